@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+# ----------------------------------------------------------
+# Converts a packet capture (pcap) or a CSV to the binary
+# trace read by TraceReplayApp (sim/trace-replay.h):
+#
+#   header:  "NSTR", uint32 version=1, uint64 n_records
+#   records: uint64 timestamp_ns, uint32 size, uint32 flow
+#
+# pcap: every IPv4 packet is a record, size is the transport
+#       payload and flow is the index of its five tuple (in
+#       order of appearance). Other packets use their length.
+# CSV:  columns time (s), size (bytes) and optionally flow.
+#       A header line is skipped.
+#
+# e.g.
+#   python3 trace_converter.py capture.pcap video.nstr
+#   python3 trace_converter.py web.csv web.nstr --flow 3
+# ----------------------------------------------------------
+import argparse
+import struct
+import sys
+
+MAGIC = b"NSTR"
+VERSION = 1
+HEADER = struct.Struct("<4sIQ")
+RECORD = struct.Struct("<QII")
+
+# Set text colors
+CLEAR = '\033[0m'
+RED = '\033[0;31m'
+GREEN = '\033[0;32m'
+
+
+def ipv4_record(data):
+    """Returns (five tuple, payload size) of an IPv4 packet, None if it is not IPv4"""
+    if len(data) < 20 or data[0] >> 4 != 4:
+        return None
+    ihl = (data[0] & 0x0F) * 4
+    total = struct.unpack("!H", data[2:4])[0]
+    proto = data[9]
+    src, dst = data[12:16], data[16:20]
+    sport = dport = 0
+    l4 = 0
+    if proto in (6, 17) and len(data) >= ihl + 4:
+        sport, dport = struct.unpack("!HH", data[ihl:ihl + 4])
+        if proto == 17:
+            l4 = 8
+        elif len(data) >= ihl + 13:
+            l4 = (data[ihl + 12] >> 4) * 4
+    return (proto, src, dst, sport, dport), max(0, total - ihl - l4)
+
+
+def read_pcap(path):
+    """Yields (timestamp ns, size, flow) of every packet of a classic pcap file"""
+    flows = {}
+    with open(path, "rb") as f:
+        gh = f.read(24)
+        magic = struct.unpack("<I", gh[:4])[0]
+        if magic in (0xA1B2C3D4, 0xA1B23C4D):
+            endian = "<"
+        elif magic in (0xD4C3B2A1, 0x4D3CB2A1):
+            endian = ">"
+        else:
+            raise ValueError("Not a pcap file (pcapng is not supported, convert it with editcap -F pcap)")
+        nano = magic in (0xA1B23C4D, 0x4D3CB2A1)
+        linktype = struct.unpack(endian + "I", gh[20:24])[0]
+        # Bytes before the IP header for the supported link types
+        offsets = {1: 14, 101: 0, 113: 16, 228: 0}
+        offset = offsets.get(linktype)
+
+        rec = struct.Struct(endian + "IIII")
+        while True:
+            rh = f.read(rec.size)
+            if len(rh) < rec.size:
+                break
+            sec, frac, incl, orig = rec.unpack(rh)
+            data = f.read(incl)
+            ts = sec * 1_000_000_000 + (frac if nano else frac * 1000)
+
+            parsed = ipv4_record(data[offset:]) if offset is not None else None
+            if parsed is None:
+                yield ts, orig, 0
+                continue
+            key, size = parsed
+            yield ts, size, flows.setdefault(key, len(flows))
+
+
+def read_csv(path):
+    """Yields (timestamp ns, size, flow) of every line of a CSV, sorted by time"""
+    rows = []
+    with open(path) as f:
+        for line in f:
+            cols = line.replace(";", ",").replace("\t", ",").split(",")
+            try:
+                ts = round(float(cols[0]) * 1e9)
+                size = int(float(cols[1]))
+                flow = int(cols[2]) if len(cols) > 2 and cols[2].strip() else 0
+            except (ValueError, IndexError):
+                continue  # header or empty line
+            rows.append((ts, size, flow))
+    rows.sort(key=lambda r: r[0])
+    return rows
+
+
+def main():
+    parser = argparse.ArgumentParser(description="pcap/CSV to TraceReplayApp binary trace")
+    parser.add_argument("input", help="pcap or CSV file")
+    parser.add_argument("output", help="binary trace")
+    parser.add_argument("--flow", type=int, default=None, help="only keep this flow")
+    parser.add_argument("--csv", action="store_true", help="force CSV input")
+    args = parser.parse_args()
+
+    is_csv = args.csv or args.input.lower().endswith((".csv", ".txt"))
+    records = read_csv(args.input) if is_csv else read_pcap(args.input)
+
+    n = 0
+    with open(args.output, "wb") as out:
+        out.write(HEADER.pack(MAGIC, VERSION, 0))
+        for ts, size, flow in records:
+            if args.flow is not None and flow != args.flow:
+                continue
+            out.write(RECORD.pack(ts, size, flow))
+            n += 1
+        out.seek(0)
+        out.write(HEADER.pack(MAGIC, VERSION, n))
+
+    if n == 0:
+        print(f"{RED}No records written{CLEAR}")
+        sys.exit(1)
+    print(f"{GREEN}{n} records written to {args.output}{CLEAR}")
+
+
+if __name__ == "__main__":
+    main()
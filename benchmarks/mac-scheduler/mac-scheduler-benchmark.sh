@@ -0,0 +1,91 @@
+#!/bin/bash
+
+# MAC scheduler benchmark: runs the street grid scenario (phyDistro=4) with one gNb and K UEs for
+# every K, with the profiled TDMA RR scheduler (--macProfile=1), once with the RBG assignment of
+# NrMacSchedulerTdma and once with its own (--macFastAssign=1), and collects the SchedulerProfile.txt
+# of each run (calls, mean, p50, p99 and max wall time per phase, active UEs per slot) in one tab
+# separated file, one row per UEs, assignment and phase. Run it from the root of the repository, as
+# parallel.sh.
+#
+# e.g.
+#   bash benchmarks/mac-scheduler/mac-scheduler-benchmark.sh -u "1 2 4 8 16 32 64 128 256" -t 0.5
+
+source "paths.cfg"
+
+ues="1 2 4 8 16 32 64 128 256"
+simTime=0.5
+build_ns3=1
+pass_through=""
+
+helpFunction()
+{
+   echo ""
+   echo "Usage: $0 -u \"$ues\" -t $simTime -n -p \"--arg=val\""
+   echo -e "\t-u Number of UEs (of the single gNb) to sweep"
+   echo -e "\t-t Simulated time of every run in s"
+   echo -e "\t-n Skips the build step of ns3, it always builds by default"
+   echo -e "\t-p Pass through commands to every simulation, args must be inside quotes \"--arg=value\""
+   exit 1 # Exit script after printing help
+}
+
+while getopts "u:t:np:" opt
+do
+   case "$opt" in
+      u ) ues="$OPTARG" ;;
+      t ) simTime="$OPTARG" ;;
+      n ) build_ns3=0 ;;
+      p ) pass_through="$OPTARG" ;;
+      ? ) helpFunction ;; # Print helpFunction in case parameter is non-existent
+   esac
+done
+
+if [ "$build_ns3" == "1" ]
+then
+   "${RUTA_NS3}/ns3" build
+
+   if [ "$?" != "0" ]; then
+      printf "${red}Error while building, benchmark cancelled! ${clear}\n"
+      exit 1
+   fi
+fi
+
+outdir="${RUTA_PROBE}/out/MACSCHED-"`date +%Y%m%d_%H%M%S`
+mkdir -p "$outdir"
+results="$outdir/mac-scheduler.tsv"
+printf "ues\tfast\tphase\tcalls\tmeanNs\tp50Ns\tp99Ns\tmaxNs\texit\n" > "$results"
+
+for ue in $ues; do
+   for fast in 0 1; do
+      rundir="$outdir/U${ue}-F${fast}"
+      mkdir -p "$rundir"
+      printf "Running ${cyan}${ue} UEs, macFastAssign=${fast}${clear}\n"
+
+      "${RUTA_NS3}/ns3" run "${FILENAME}
+          --phyDistro=4
+          --gridUes=$ue
+          --gNbNum=1
+          --simTime=$simTime
+          --macProfile=1
+          --macFastAssign=$fast
+          --logging=0
+          $pass_through
+          " --cwd "$rundir" --no-build &> "$rundir/stdout.txt"
+      exit_status=$?
+
+      # SchedulerProfile.txt: header, then "phase calls meanNs p50Ns p99Ns maxNs" per phase
+      if [ -f "$rundir/SchedulerProfile.txt" ]; then
+         tail -n +2 "$rundir/SchedulerProfile.txt" | while read -r line; do
+            printf "${ue}\t${fast}\t${line}\t${exit_status}\n" >> "$results"
+         done
+      else
+         printf "${ue}\t${fast}\t\t\t\t\t\t\t${exit_status}\n" >> "$results"
+      fi
+
+      if [ "$exit_status" != "0" ]; then
+         printf "${red}Error ${exit_status}, see $rundir/stdout.txt${clear}\n"
+      fi
+   done
+done
+
+printf "Results in ${blue}${results}${clear}\n"
+grep -P "^\S+\t\S+\t(dl|ul|dlAssign|dlActiveUes)\t" "$results" | column -t -s $'\t'
@@ -0,0 +1,111 @@
+#!/bin/bash
+
+# Distributed mode check: runs the same simulation in one process and with mpirun -np 2 (--mpi=1,
+# ns-3 configured with --enable-mpi), compares every output of the single process run with the one of
+# the distributed run (they must be identical) and collects the RunStats.txt of both (rank 0 and
+# rank 1) in one tab separated file. Both runs use --flowProbe=1, so FlowOutput.txt comes from the
+# StreamingFlowProbe in both (the FlowMonitor of --flowProbe=0 numbers and bins the flows in its own
+# way), and --scheduler=NodeOrder, the event scheduler the distributed run always uses (simultaneous
+# events ordered by node). Run it from the root of the repository, as parallel.sh.
+#
+# e.g.
+#   bash benchmarks/mpi/mpi-benchmark.sh -s "Edge Remote" -t 1 -p "--flowType=TCP"
+
+source "paths.cfg"
+
+servers="Edge Remote"
+simTime=1
+build_ns3=1
+pass_through=""
+
+helpFunction()
+{
+   echo ""
+   echo "Usage: $0 -s \"$servers\" -t $simTime -n -p \"--arg=val\""
+   echo -e "\t-s Server types to run (the server delay is the lookahead of the distributed run)"
+   echo -e "\t-t Simulated time of every run in s"
+   echo -e "\t-n Skips the build step of ns3, it always builds by default"
+   echo -e "\t-p Pass through commands to every simulation, args must be inside quotes \"--arg=value\""
+   exit 1 # Exit script after printing help
+}
+
+while getopts "s:t:np:" opt
+do
+   case "$opt" in
+      s ) servers="$OPTARG" ;;
+      t ) simTime="$OPTARG" ;;
+      n ) build_ns3=0 ;;
+      p ) pass_through="$OPTARG" ;;
+      ? ) helpFunction ;; # Print helpFunction in case parameter is non-existent
+   esac
+done
+
+# The distributed run always uses the probe, so the single process one has to as well
+if [[ "$pass_through" =~ --flowProbe=(0|false) ]]; then
+   printf "${red}--flowProbe=0 can not be compared with the distributed run, both runs use --flowProbe=1${clear}\n"
+fi
+if [[ "$pass_through" =~ --scheduler= ]]; then
+   printf "${red}The distributed run always uses the NodeOrder event scheduler, both runs use --scheduler=NodeOrder${clear}\n"
+fi
+
+if [ "$build_ns3" == "1" ]
+then
+   "${RUTA_NS3}/ns3" build
+
+   if [ "$?" != "0" ]; then
+      printf "${red}Error while building, benchmark cancelled! ${clear}\n"
+      exit 1
+   fi
+fi
+
+outdir="${RUTA_PROBE}/out/MPI-"`date +%Y%m%d_%H%M%S`
+mkdir -p "$outdir"
+results="$outdir/mpi.tsv"
+printf "server\tmode\tsetupTime\trunTime\tsimulatedTime\tevents\teventsPerSecond\twallPerSimSecond\tnodes\tbuildings\tpeakRssKb\texit\n" > "$results"
+
+# RunStats.txt: one "name<TAB>value" per line, the first 9 in the order of the header (cache counters follow)
+runStats()
+{
+   if [ -f "$1" ]; then
+      head -n 9 "$1" | cut -f2 | paste -s -d '\t'
+   else
+      printf '\t\t\t\t\t\t\t\t'
+   fi
+}
+
+for server in $servers; do
+   single="$outdir/${server}-single"
+   distributed="$outdir/${server}-mpi"
+   mkdir -p "$single" "$distributed"
+   args="${FILENAME} --serverType=$server --simTime=$simTime --logging=0 $pass_through --flowProbe=1 --scheduler=NodeOrder"
+
+   printf "Running ${cyan}${server}${clear}, one process\n"
+   "${RUTA_NS3}/ns3" run "$args" --cwd "$single" --no-build &> "$single/stdout.txt"
+   single_status=$?
+
+   printf "Running ${cyan}${server}${clear}, mpirun -np 2\n"
+   "${RUTA_NS3}/ns3" run "$args --mpi=1" --command-template="mpirun -np 2 %s" \
+       --cwd "$distributed" --no-build &> "$distributed/stdout.txt"
+   mpi_status=$?
+
+   printf "${server}\tsingle\t$(runStats "$single/RunStats.txt")\t${single_status}\n" >> "$results"
+   printf "${server}\trank0\t$(runStats "$distributed/RunStats.txt")\t${mpi_status}\n" >> "$results"
+   printf "${server}\trank1\t$(runStats "$distributed/RunStats-rank1.txt")\t${mpi_status}\n" >> "$results"
+
+   # Wall times, logs and the settings differ by design
+   for file in $(cd "$single" && ls); do
+      case "$file" in
+         stdout.txt|output.log|RunStats.txt|graph.ini ) continue ;;
+      esac
+      if [ ! -f "$distributed/$file" ]; then
+         printf "  ${red}missing${clear}   $file\n"
+      elif cmp -s "$single/$file" "$distributed/$file"; then
+         printf "  ${green}identical${clear} $file\n"
+      else
+         printf "  ${red}different${clear} $file\n"
+      fi
+   done
+done
+
+printf "Results in ${blue}${results}${clear}\n"
+column -t -s $'\t' "$results"
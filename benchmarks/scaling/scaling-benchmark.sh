@@ -0,0 +1,99 @@
+#!/bin/bash
+
+# Scaling benchmark of the street grid scenario (phyDistro=4): runs the simulation for every
+# combination of blocks (N x M), UEs (K) and gNbs and collects the RunStats.txt of each run
+# (setup time, events/s, wall time per simulated second and peak RSS) in one tab separated file.
+# Run it from the root of the repository, as parallel.sh.
+#
+# e.g.
+#   bash benchmarks/scaling/scaling-benchmark.sh -b "2x2 4x4 8x8" -u "10 50 200" -g "1 4" -t 0.5
+
+source "paths.cfg"
+
+blocks="2x2 4x4 8x8"
+ues="10 50 200"
+gnbs="1 4 9"
+simTime=0.5
+build_ns3=1
+pass_through=""
+
+helpFunction()
+{
+   echo ""
+   echo "Usage: $0 -b \"$blocks\" -u \"$ues\" -g \"$gnbs\" -t $simTime -n -p \"--arg=val\""
+   echo -e "\t-b Blocks of the grid to sweep, NxM separated by spaces"
+   echo -e "\t-u Number of UEs to sweep"
+   echo -e "\t-g Number of gNbs to sweep"
+   echo -e "\t-t Simulated time of every run in s"
+   echo -e "\t-n Skips the build step of ns3, it always builds by default"
+   echo -e "\t-p Pass through commands to every simulation, args must be inside quotes \"--arg=value\""
+   exit 1 # Exit script after printing help
+}
+
+while getopts "b:u:g:t:np:" opt
+do
+   case "$opt" in
+      b ) blocks="$OPTARG" ;;
+      u ) ues="$OPTARG" ;;
+      g ) gnbs="$OPTARG" ;;
+      t ) simTime="$OPTARG" ;;
+      n ) build_ns3=0 ;;
+      p ) pass_through="$OPTARG" ;;
+      ? ) helpFunction ;; # Print helpFunction in case parameter is non-existent
+   esac
+done
+
+if [ "$build_ns3" == "1" ]
+then
+   "${RUTA_NS3}/ns3" build
+
+   if [ "$?" != "0" ]; then
+      printf "${red}Error while building, benchmark cancelled! ${clear}\n"
+      exit 1
+   fi
+fi
+
+outdir="${RUTA_PROBE}/out/SCALING-"`date +%Y%m%d_%H%M%S`
+mkdir -p "$outdir"
+results="$outdir/scaling.tsv"
+printf "blocksX\tblocksY\tues\tgnbs\tsetupTime\trunTime\tsimulatedTime\tevents\teventsPerSecond\twallPerSimSecond\tnodes\tbuildings\tpeakRssKb\texit\n" > "$results"
+
+for block in $blocks; do
+   blocksX=${block%x*}
+   blocksY=${block#*x}
+   for ue in $ues; do
+      for gnb in $gnbs; do
+         rundir="$outdir/B${blocksX}x${blocksY}-U${ue}-G${gnb}"
+         mkdir -p "$rundir"
+         printf "Running ${cyan}${blocksX}x${blocksY} blocks, ${ue} UEs, ${gnb} gNbs${clear}\n"
+
+         "${RUTA_NS3}/ns3" run "${FILENAME}
+             --phyDistro=4
+             --gridBlocksX=$blocksX
+             --gridBlocksY=$blocksY
+             --gridUes=$ue
+             --gNbNum=$gnb
+             --simTime=$simTime
+             --logging=0
+             $pass_through
+             " --cwd "$rundir" --no-build &> "$rundir/stdout.txt"
+         exit_status=$?
+
+         # RunStats.txt: one "name<TAB>value" per line, the first 9 in the order of the header (cache counters follow)
+         stats=""
+         if [ -f "$rundir/RunStats.txt" ]; then
+            stats=$(head -n 9 "$rundir/RunStats.txt" | cut -f2 | paste -s -d '\t')
+         else
+            stats=$(printf '\t\t\t\t\t\t\t\t')
+         fi
+         printf "${blocksX}\t${blocksY}\t${ue}\t${gnb}\t${stats}\t${exit_status}\n" >> "$results"
+
+         if [ "$exit_status" != "0" ]; then
+            printf "${red}Error ${exit_status}, see $rundir/stdout.txt${clear}\n"
+         fi
+      done
+   done
+done
+
+printf "Results in ${blue}${results}${clear}\n"
+column -t -s $'\t' "$results"
@@ -0,0 +1,219 @@
+/**
+ * Event scheduler benchmark: replays a sequence of Insert / RemoveNext / Remove operations against
+ * every scheduler and prints the time per operation.
+ *
+ * The sequence is read from a file written by simulation-main-dev with --schedulerTrace=<file>, or
+ * generated with an NR like pattern (slot and symbol events, per UE packets and restarted timers)
+ * when no trace is given.
+ *
+ * e.g.
+ *   ./ns3 run "scheduler-benchmark --trace=sched.bin"
+ *   ./ns3 run "scheduler-benchmark --ues=64 --ops=5000000 --schedulers=Map,Heap,SlotBucket"
+ *
+ * The scratch build makes one executable per directory, so the scheduler sources are included here.
+ */
+#include "ns3/core-module.h"
+
+#include "../../sim/cmdline-colors.h"
+#include "../../sim/slot-bucket-scheduler.h"
+#include "../../sim/slot-bucket-scheduler.cc"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+
+using namespace ns3;
+
+using Record = RecordingScheduler::Record;
+
+/**
+ * @brief Reads a trace written by RecordingScheduler
+ */
+static std::vector<Record>
+ReadTrace(std::string filename)
+{
+    std::ifstream in(filename, std::ios::binary | std::ios::ate);
+    NS_ABORT_MSG_IF(!in.is_open(), "Can't open " << filename);
+    std::streamsize size = in.tellg();
+    in.seekg(0);
+
+    std::vector<Record> records(size / sizeof(Record));
+    in.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(Record));
+    return records;
+}
+
+/**
+ * @brief Generates ops operations of an NR like simulation: a slot event that schedules the 14 symbol
+ * events of the slot, and per UE a packet source every interval that restarts (removes and inserts)
+ * a 200 ms retransmission timer
+ */
+static std::vector<Record>
+SynthesizeTrace(uint32_t ues, uint64_t slotNs, uint64_t ops)
+{
+    enum Type
+    {
+        SLOT,
+        SYMBOL,
+        PACKET,
+        TIMER
+    };
+
+    std::vector<Record> records;
+    records.reserve(ops);
+    std::set<std::pair<uint64_t, uint32_t>> pending;
+    std::unordered_map<uint32_t, std::pair<Type, uint32_t>> info; // uid -> (type, ue)
+    std::vector<std::pair<uint64_t, uint32_t>> timers(ues, {0, 0});
+    std::mt19937_64 rng(1);
+    std::uniform_int_distribution<uint64_t> jitter(0, slotNs);
+    uint32_t uid = 1;
+
+    auto insert = [&](uint64_t ts, Type type, uint32_t ue) {
+        pending.insert({ts, uid});
+        info[uid] = {type, ue};
+        records.push_back({ts, uid, RecordingScheduler::INSERT});
+        return std::make_pair(ts, uid++);
+    };
+
+    insert(0, SLOT, 0);
+    for (uint32_t ue = 0; ue < ues; ue++)
+    {
+        insert(jitter(rng), PACKET, ue);
+    }
+
+    while (records.size() < ops && !pending.empty())
+    {
+        auto next = *pending.begin();
+        pending.erase(pending.begin());
+        records.push_back({next.first, next.second, RecordingScheduler::REMOVE_NEXT});
+        auto it = info.find(next.second);
+        Type type = it->second.first;
+        uint32_t ue = it->second.second;
+        info.erase(it);
+
+        uint64_t now = next.first;
+        switch (type)
+        {
+        case SLOT:
+            insert(now + slotNs, SLOT, 0);
+            for (uint32_t symbol = 1; symbol < 14; symbol++)
+            {
+                insert(now + symbol * slotNs / 14, SYMBOL, 0);
+            }
+            break;
+        case PACKET:
+            if (timers[ue].second != 0 && pending.erase(timers[ue]) > 0)
+            {
+                info.erase(timers[ue].second);
+                records.push_back({timers[ue].first, timers[ue].second, RecordingScheduler::REMOVE});
+            }
+            timers[ue] = insert(now + 200000000, TIMER, ue);
+            insert(now + 8 * slotNs + jitter(rng), PACKET, ue);
+            break;
+        default:
+            break;
+        }
+    }
+    return records;
+}
+
+/**
+ * @brief Replays the records against a new scheduler
+ * @return (seconds, RemoveNext that did not return the recorded event)
+ */
+static std::pair<double, uint64_t>
+Replay(std::string typeId, const std::vector<Record>& records)
+{
+    ObjectFactory factory;
+    factory.SetTypeId(typeId);
+    Ptr<Scheduler> scheduler = factory.Create<Scheduler>();
+
+    uint64_t mismatches = 0;
+    auto tic = std::chrono::steady_clock::now();
+    for (const Record& record : records)
+    {
+        Scheduler::Event ev;
+        ev.impl = nullptr;
+        ev.key.m_ts = record.ts;
+        ev.key.m_uid = record.uid;
+        ev.key.m_context = 0;
+
+        switch (record.op)
+        {
+        case RecordingScheduler::INSERT:
+            scheduler->Insert(ev);
+            break;
+        case RecordingScheduler::REMOVE_NEXT:
+            if (scheduler->IsEmpty() || scheduler->RemoveNext().key.m_uid != record.uid)
+            {
+                mismatches++;
+            }
+            break;
+        case RecordingScheduler::REMOVE:
+            scheduler->Remove(ev);
+            break;
+        }
+    }
+    auto toc = std::chrono::steady_clock::now();
+
+    while (!scheduler->IsEmpty())
+    {
+        scheduler->RemoveNext();
+    }
+    return {1e-9 * std::chrono::duration_cast<std::chrono::nanoseconds>(toc - tic).count(), mismatches};
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::string trace = "";
+    std::string schedulers = "Map,Heap,List,Calendar,PriorityQueue,SlotBucket";
+    uint32_t ues = 16;
+    uint64_t ops = 2000000;
+    uint16_t numerology = 3;
+    uint32_t repeat = 3;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("trace", "Operations written by simulation-main-dev --schedulerTrace, empty: synthetic NR pattern", trace);
+    cmd.AddValue("schedulers", "Comma separated schedulers (short names or TypeIds)", schedulers);
+    cmd.AddValue("ues", "UEs of the synthetic pattern", ues);
+    cmd.AddValue("ops", "Operations of the synthetic pattern", ops);
+    cmd.AddValue("numerology", "Numerology of the synthetic pattern and SlotBucket width", numerology);
+    cmd.AddValue("repeat", "Runs per scheduler, the best one is printed", repeat);
+    cmd.Parse(argc, argv);
+
+    uint64_t slotNs = 1000000 >> numerology;
+    Config::SetDefault("ns3::SlotBucketScheduler::BucketWidth", TimeValue(NanoSeconds(slotNs)));
+
+    std::vector<Record> records = trace.empty() ? SynthesizeTrace(ues, slotNs, ops) : ReadTrace(trace);
+    NS_ABORT_MSG_IF(records.empty(), "No operations to replay");
+    std::cout << TXT_CYAN << records.size() << " operations ("
+              << (trace.empty() ? "synthetic, " + std::to_string(ues) + " UEs" : trace) << ")"
+              << TXT_CLEAR << std::endl;
+
+    std::cout << std::left << std::setw(16) << "Scheduler" << std::setw(12) << "Time (s)"
+              << std::setw(12) << "ns/op" << "Mismatches" << std::endl;
+
+    std::stringstream list(schedulers);
+    std::string name;
+    while (std::getline(list, name, ','))
+    {
+        std::pair<double, uint64_t> best{std::numeric_limits<double>::max(), 0};
+        for (uint32_t run = 0; run < std::max<uint32_t>(1, repeat); run++)
+        {
+            auto result = Replay(SchedulerTypeName(name), records);
+            if (result.first < best.first)
+            {
+                best = result;
+            }
+        }
+        std::cout << std::left << std::setw(16) << name << std::setw(12) << std::setprecision(4)
+                  << best.first << std::setw(12) << 1e9 * best.first / records.size()
+                  << (best.second ? TXT_RED : TXT_GREEN) << best.second << TXT_CLEAR << std::endl;
+    }
+
+    return 0;
+}
@@ -50,6 +50,12 @@ else:
     dataRate = 1000
 thr_limit = dataRate*1.1
 
+# Interval of the UDP rx stats in ms (UdpRecvAgg_NodeN.txt), 0 if they are per packet
+if config.has_option('general', 'udpAggInterval'):
+    udpAggInterval = float(config['general']['udpAggInterval'].split()[0])
+else:
+    udpAggInterval = 0
+
 """ gNbNum = int(config['gNb']['gNbNum'])
 gNbX = float(config['gNb']['gNbX'])
 gNbY = float(config['gNb']['gNbY'])
@@ -137,12 +143,8 @@ def graphMobility():
         ax.add_artist(gnbAnnBox)
     
     for bld in buildingList:
-        
-        # TODO: change the creation of the json files that there is a tree type and
-        #       a building type, the idea is that the image is automatically chosen
-        #       depending on the type. Maybe Inherit building class and create new models?
 
-        if phyData["istree"] or bld["ExternalWallsType"] == 0:
+        if bld.get("type") == "tree":
             bldIcon = plt.imread(get_sample_data(f'{MAINPROBE}/images/tree.png'))
             bldBox = OffsetImage(bldIcon, zoom=0.03)
             bldAnnBox = AnnotationBbox(bldBox, [bld["xmin"], bld["ymin"]+5], frameon=False)
@@ -680,14 +682,24 @@ def graphUdpDelay():
     
     # We assume that there is only 1 UE
     filepath = HOMEPATH + "UdpRecv_Node1.txt"
+    aggpath = HOMEPATH + "UdpRecvAgg_Node1.txt"
     title = "Application Packet Delay"
 
-    udpstats = pd.read_csv(filepath, sep="\t")
+    if os.path.exists(aggpath):
+        # Aggregated per interval by the simulation (--udpAggInterval)
+        udpstats = pd.read_csv(aggpath, sep="\t")
+        time = udpstats["Time (s)"]
+        plt.fill_between(time, udpstats["DelayMin"] * 1000, udpstats["DelayMax"] * 1000, alpha=0.2, label="min-max")
+        plt.plot(time, udpstats["DelayP95"] * 1000, label="p95")
+        plt.plot(time, udpstats["DelayMean"] * 1000, label="mean")
+        plt.legend()
+    else:
+        udpstats = pd.read_csv(filepath, sep="\t")
 
-    time = udpstats["Time (s)"]
-    delay = udpstats["Delay"] * 1000
+        time = udpstats["Time (s)"]
+        delay = udpstats["Delay"] * 1000
 
-    plt.plot(time, delay)
+        plt.plot(time, delay)
     plt.suptitle(title)
     plt.title(SUBTITLE)
     plt.ylabel("Delay [ms]")
@@ -970,15 +982,25 @@ def graphGoodPut():
 
     # In this test we only have 1 UE, with NodeId=1
     filepath = HOMEPATH + "UdpRecv_Node1.txt"
-    df = pd.read_csv(filepath, sep="\t")
+    aggpath = HOMEPATH + "UdpRecvAgg_Node1.txt"
+
+    if os.path.exists(aggpath):
+        # Rows are written at the end of each interval, move them to its start before resampling
+        df = pd.read_csv(aggpath, sep="\t")
+        interval = (udpAggInterval if udpAggInterval > 0 else resamplePeriod) * 1e-3
+        df[timeCol] = pd.to_timedelta(df[timeCol] - interval, unit="s")
+        sizeCol = "Bytes"
+    else:
+        df = pd.read_csv(filepath, sep="\t")
+        df[timeCol] = pd.to_timedelta(df[timeCol], unit="s")
+        sizeCol = "Packet Size"
 
-    df[timeCol] = pd.to_timedelta(df[timeCol], unit="s")
     df.index += 1
-    df.loc[0] = [pd.Timedelta(0), 0, 0, 0, 0]
+    df.loc[0] = [pd.Timedelta(0)] + [0] * (len(df.columns) - 1)
     df.sort_index(inplace=True)
 
     resampled = df.copy().resample(f"{resamplePeriod}ms", on=timeCol)
-    new_df = resampled['Packet Size'].sum().to_frame(name='Bytes').copy()
+    new_df = resampled[sizeCol].sum().to_frame(name='Bytes').copy()
     new_df = RESAMPLED_DF.join([new_df]).drop('Time', axis=1).fillna(0)
 
     # THR = bits / ( ( time in a period in secs ) * bits in a megabit )
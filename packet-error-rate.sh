@@ -34,7 +34,14 @@ if [ -f $myfolder/$filename.gz ]; then
 }
 fi
 
-if [ "$flowType" == "TCP" ]; then
+# The ascii dump only exists when the simulation ran with --asciiTrace=1. Without it only the passes
+# that read it are skipped: the simulator writes tcp-per.txt and tcp-delay.txt by itself
+# (TcpTraceAnalyzer)
+if [ "$flowType" == "TCP" ] && [ ! -f $myfolder/$filename ]; then
+{
+    printf "No ${filename}, TCP analysis skipped (tcp-per.txt and tcp-delay.txt are written by the simulation)\n"
+}
+elif [ "$flowType" == "TCP" ] && [ ! -f $myfolder/"tcp-per.txt" ]; then
 {
     printf "PER..."
     cat $myfolder/$filename |grep /NodeList/$serverID | awk '\
@@ -152,7 +159,11 @@ if [ "$flowType" == "TCP" ]; then
 }
 fi
 
-if [ "$flowType" == "UDP" ];
+if [ "$flowType" == "UDP" ] && [ ! -f $myfolder/$filename ]; then
+{
+    printf "No ${filename}, udp-delay.txt needs a simulation with --asciiTrace=1\n"
+}
+elif [ "$flowType" == "UDP" ];
 then
 {
     cat $myfolder/$filename |grep /NodeList/0 | awk '\
@@ -0,0 +1,334 @@
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include "backhaul-aggregation.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("BackhaulAggregation");
+
+/**
+ * Tag of a carrier packet, the id of the packets it carries in the m_inFlight of the sender.
+ */
+class AggregateTag : public Tag
+{
+public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::AggregateTag")
+                                .SetParent<Tag>()
+                                .SetGroupName("MyAppComp")
+                                .AddConstructor<AggregateTag>();
+        return tid;
+    }
+
+    TypeId GetInstanceTypeId() const override
+    {
+        return GetTypeId();
+    }
+
+    uint32_t GetSerializedSize() const override
+    {
+        return 8;
+    }
+
+    void Serialize(TagBuffer buf) const override
+    {
+        buf.WriteU64(m_id);
+    }
+
+    void Deserialize(TagBuffer buf) override
+    {
+        m_id = buf.ReadU64();
+    }
+
+    void Print(std::ostream& os) const override
+    {
+        os << "AggregateId=" << m_id;
+    }
+
+    uint64_t m_id{0};
+};
+
+NS_OBJECT_ENSURE_REGISTERED(AggregateTag);
+NS_OBJECT_ENSURE_REGISTERED(AggregatingPointToPointNetDevice);
+
+TypeId
+AggregatingPointToPointNetDevice::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::AggregatingPointToPointNetDevice")
+            .SetParent<PointToPointNetDevice>()
+            .SetGroupName("MyAppComp")
+            .AddConstructor<AggregatingPointToPointNetDevice>()
+            .AddAttribute("AggregationWindow",
+                          "Max time a packet waits for other packets of its flow, 0 disables the aggregation",
+                          TimeValue(MicroSeconds(20)),
+                          MakeTimeAccessor(&AggregatingPointToPointNetDevice::m_window),
+                          MakeTimeChecker(Seconds(0)))
+            .AddAttribute("MaxAggregateSize",
+                          "Max number of bytes of a carrier, when reached it is sent right away",
+                          UintegerValue(65535),
+                          MakeUintegerAccessor(&AggregatingPointToPointNetDevice::m_maxBytes),
+                          MakeUintegerChecker<uint32_t>(1));
+    return tid;
+}
+
+AggregatingPointToPointNetDevice::AggregatingPointToPointNetDevice()
+    : m_carriers(0),
+      m_carried(0),
+      m_nextId(0)
+{
+}
+
+AggregatingPointToPointNetDevice::~AggregatingPointToPointNetDevice()
+{
+}
+
+void
+AggregatingPointToPointNetDevice::DoDispose()
+{
+    for (auto& [key, pending] : m_pending)
+    {
+        pending.flushEvent.Cancel();
+    }
+    m_pending.clear();
+    m_inFlight.clear();
+    m_upperRx = NetDevice::ReceiveCallback();
+    m_upperPromiscRx = NetDevice::PromiscReceiveCallback();
+    PointToPointNetDevice::DoDispose();
+}
+
+std::pair<uint64_t, uint64_t>
+AggregatingPointToPointNetDevice::GetAggregationStats() const
+{
+    return {m_carriers, m_carried};
+}
+
+AggregatingPointToPointNetDevice::FlowKey
+AggregatingPointToPointNetDevice::Classify(Ptr<const Packet> packet, uint16_t protocolNumber)
+{
+    if (protocolNumber != Ipv4L3Protocol::PROT_NUMBER)
+    {
+        return FlowKey(0, 0, 0, 0, 0);
+    }
+
+    Ipv4Header ipHeader;
+    packet->PeekHeader(ipHeader);
+    uint16_t srcPort = 0;
+    uint16_t dstPort = 0;
+    uint8_t protocol = ipHeader.GetProtocol();
+    uint32_t ipLen = ipHeader.GetSerializedSize();
+    if ((protocol == UdpL4Protocol::PROT_NUMBER || protocol == TcpL4Protocol::PROT_NUMBER) &&
+        packet->GetSize() >= ipLen + 4)
+    {
+        // Both UDP and TCP headers start with the ports
+        uint8_t buf[64];
+        packet->CopyData(buf, ipLen + 4);
+        srcPort = (buf[ipLen] << 8) | buf[ipLen + 1];
+        dstPort = (buf[ipLen + 2] << 8) | buf[ipLen + 3];
+    }
+    return FlowKey(protocol, ipHeader.GetSource().Get(), ipHeader.GetDestination().Get(), srcPort, dstPort);
+}
+
+bool
+AggregatingPointToPointNetDevice::Send(Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber)
+{
+    NS_LOG_FUNCTION(this << packet << dest << protocolNumber);
+    if (m_window.IsZero() || !IsLinkUp())
+    {
+        return PointToPointNetDevice::Send(packet, dest, protocolNumber);
+    }
+
+    FlowKey key = Classify(packet, protocolNumber);
+    auto it = m_pending.find(key);
+    if ((it == m_pending.end() || it->second.packets.empty()) && GetQueue()->IsEmpty())
+    {
+        // Nothing queued in front of it, waiting would only add delay
+        return PointToPointNetDevice::Send(packet, dest, protocolNumber);
+    }
+    if (it != m_pending.end() &&
+        (it->second.protocolNumber != protocolNumber || it->second.bytes + packet->GetSize() > m_maxBytes))
+    {
+        Flush(key);
+    }
+
+    PendingAggregate& pending = m_pending[key];
+    if (pending.packets.empty())
+    {
+        pending.protocolNumber = protocolNumber;
+        pending.dest = dest;
+        pending.flushEvent =
+            Simulator::Schedule(m_window, &AggregatingPointToPointNetDevice::Flush, this, key);
+    }
+    pending.packets.push_back(packet);
+    pending.bytes += packet->GetSize();
+    return true;
+}
+
+void
+AggregatingPointToPointNetDevice::Flush(FlowKey key)
+{
+    auto it = m_pending.find(key);
+    if (it == m_pending.end() || it->second.packets.empty())
+    {
+        return;
+    }
+    PendingAggregate& pending = it->second;
+    pending.flushEvent.Cancel();
+
+    if (pending.packets.size() == 1)
+    {
+        // Nothing to aggregate
+        PointToPointNetDevice::Send(pending.packets.front(), pending.dest, pending.protocolNumber);
+    }
+    else
+    {
+        AggregateTag tag;
+        tag.m_id = m_nextId++;
+        Ptr<Packet> carrier = Create<Packet>(pending.bytes);
+        carrier->AddPacketTag(tag);
+
+        NS_LOG_DEBUG("Carrier " << tag.m_id << " with " << pending.packets.size() << " packets, "
+                                << pending.bytes << " B");
+        m_carriers++;
+        m_carried += pending.packets.size();
+
+        m_inFlight.emplace(tag.m_id, std::move(pending.packets));
+        if (!PointToPointNetDevice::Send(carrier, pending.dest, pending.protocolNumber))
+        {
+            // Dropped by the queue, so are the packets it carries
+            m_inFlight.erase(tag.m_id);
+        }
+    }
+    m_pending.erase(it);
+}
+
+Ptr<AggregatingPointToPointNetDevice>
+AggregatingPointToPointNetDevice::GetPeer() const
+{
+    Ptr<Channel> channel = GetChannel();
+    for (std::size_t i = 0; channel && i < channel->GetNDevices(); ++i)
+    {
+        Ptr<NetDevice> device = channel->GetDevice(i);
+        if (PeekPointer(device) != this)
+        {
+            return DynamicCast<AggregatingPointToPointNetDevice>(device);
+        }
+    }
+    return nullptr;
+}
+
+bool
+AggregatingPointToPointNetDevice::Unpack(Ptr<const Packet> carrier, std::vector<Ptr<Packet>>& packets, bool release) const
+{
+    AggregateTag tag;
+    if (!carrier->PeekPacketTag(tag))
+    {
+        return false;
+    }
+    Ptr<AggregatingPointToPointNetDevice> peer = GetPeer();
+    NS_ASSERT_MSG(peer, "Carrier " << tag.m_id << " from a device that does not aggregate");
+    auto it = peer->m_inFlight.find(tag.m_id);
+    NS_ASSERT_MSG(it != peer->m_inFlight.end(), "Unknown carrier " << tag.m_id);
+    if (release)
+    {
+        packets = std::move(it->second);
+        // The link keeps the order of the carriers, the ones sent before this one were lost
+        peer->m_inFlight.erase(peer->m_inFlight.begin(), std::next(it));
+    }
+    else
+    {
+        packets = it->second;
+    }
+    return true;
+}
+
+void
+AggregatingPointToPointNetDevice::SetReceiveCallback(NetDevice::ReceiveCallback cb)
+{
+    m_upperRx = cb;
+    PointToPointNetDevice::SetReceiveCallback(
+        MakeCallback(&AggregatingPointToPointNetDevice::RxFromBase, this));
+}
+
+void
+AggregatingPointToPointNetDevice::SetPromiscReceiveCallback(NetDevice::PromiscReceiveCallback cb)
+{
+    m_upperPromiscRx = cb;
+    PointToPointNetDevice::SetPromiscReceiveCallback(
+        MakeCallback(&AggregatingPointToPointNetDevice::PromiscRxFromBase, this));
+}
+
+bool
+AggregatingPointToPointNetDevice::RxFromBase(Ptr<NetDevice> device,
+                                             Ptr<const Packet> packet,
+                                             uint16_t protocol,
+                                             const Address& from)
+{
+    std::vector<Ptr<Packet>> packets;
+    if (!Unpack(packet, packets, true))
+    {
+        return m_upperRx(device, packet, protocol, from);
+    }
+
+    bool ok = true;
+    for (auto& p : packets)
+    {
+        ok &= m_upperRx(device, p, protocol, from);
+    }
+    return ok;
+}
+
+bool
+AggregatingPointToPointNetDevice::PromiscRxFromBase(Ptr<NetDevice> device,
+                                                    Ptr<const Packet> packet,
+                                                    uint16_t protocol,
+                                                    const Address& from,
+                                                    const Address& to,
+                                                    NetDevice::PacketType packetType)
+{
+    // PointToPointNetDevice calls the promiscuous callback before the normal one, the packets are
+    // released by the latter
+    std::vector<Ptr<Packet>> packets;
+    if (!Unpack(packet, packets, false))
+    {
+        return m_upperPromiscRx(device, packet, protocol, from, to, packetType);
+    }
+
+    bool ok = true;
+    for (auto& p : packets)
+    {
+        ok &= m_upperPromiscRx(device, p, protocol, from, to, packetType);
+    }
+    return ok;
+}
+
+NetDeviceContainer
+InstallAggregatingP2p(Ptr<Node> a, Ptr<Node> b, DataRate dataRate, uint16_t mtu, Time delay, Time window)
+{
+    NetDeviceContainer devices;
+    Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel>();
+    channel->SetAttribute("Delay", TimeValue(delay));
+
+    for (Ptr<Node> node : {a, b})
+    {
+        Ptr<AggregatingPointToPointNetDevice> dev = CreateObject<AggregatingPointToPointNetDevice>();
+        dev->SetAttribute("DataRate", DataRateValue(dataRate));
+        dev->SetAttribute("Mtu", UintegerValue(mtu));
+        dev->SetAttribute("AggregationWindow", TimeValue(window));
+        dev->SetAddress(Mac48Address::Allocate());
+        node->AddDevice(dev);
+        Ptr<Queue<Packet>> queue = CreateObject<DropTailQueue<Packet>>();
+        dev->SetQueue(queue);
+        // Flow control with the traffic control layer, as PointToPointHelper does
+        Ptr<NetDeviceQueueInterface> ndqi = CreateObject<NetDeviceQueueInterface>();
+        ndqi->GetTxQueue(0)->ConnectQueueTraces(queue);
+        dev->AggregateObject(ndqi);
+        dev->Attach(channel);
+        devices.Add(dev);
+    }
+    return devices;
+}
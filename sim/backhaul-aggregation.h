@@ -0,0 +1,112 @@
+#ifndef BACKHAUL_AGGREGATION_H
+#define BACKHAUL_AGGREGATION_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include <map>
+#include <tuple>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Point to point device that carries the back-to-back packets of a flow as a single "super packet".
+ *
+ * A packet is sent right away when its flow (IPv4 five tuple) has nothing pending and the queue of
+ * the device is empty, so a lone packet (a TCP ACK, a sparse flow) never waits. Once packets queue up
+ * behind the transmission, the packets of a flow sent within AggregationWindow of the first one are
+ * kept and sent together as one carrier packet with the size of all of them: they would have waited
+ * in the queue anyway. The carrier has a tag that points to the original packets, kept by the sending
+ * device, so their headers, tags and timestamps are untouched. The device at the other end of the
+ * link gives them back to its node one by one when the carrier arrives.
+ *
+ * Only the devices on both ends must be of this type (see InstallAggregatingP2p). The traces of the
+ * device (MacTx, PhyTx, pcap...) see the carriers, not the original packets.
+ */
+class AggregatingPointToPointNetDevice : public PointToPointNetDevice
+{
+public:
+    static TypeId GetTypeId();
+    AggregatingPointToPointNetDevice();
+    ~AggregatingPointToPointNetDevice() override;
+
+    bool Send(Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber) override;
+    void SetReceiveCallback(NetDevice::ReceiveCallback cb) override;
+    void SetPromiscReceiveCallback(NetDevice::PromiscReceiveCallback cb) override;
+
+    /**
+     * @return Number of carriers sent and number of packets they carried
+     */
+    std::pair<uint64_t, uint64_t> GetAggregationStats() const;
+
+protected:
+    void DoDispose() override;
+
+private:
+    /** Protocol, source, destination, source port, destination port */
+    typedef std::tuple<uint8_t, uint32_t, uint32_t, uint16_t, uint16_t> FlowKey;
+
+    struct PendingAggregate
+    {
+        std::vector<Ptr<Packet>> packets;
+        uint32_t bytes{0};
+        uint16_t protocolNumber{0};
+        Address dest;
+        EventId flushEvent;
+    };
+
+    static FlowKey Classify(Ptr<const Packet> packet, uint16_t protocolNumber);
+
+    void Flush(FlowKey key);
+
+    bool RxFromBase(Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address& from);
+    bool PromiscRxFromBase(Ptr<NetDevice> device,
+                           Ptr<const Packet> packet,
+                           uint16_t protocol,
+                           const Address& from,
+                           const Address& to,
+                           NetDevice::PacketType packetType);
+
+    /**
+     * @brief Gets the packets a carrier points to, from the device at the other end of the link
+     * @param release Whether to forget them (last receiver of the carrier), and those of the
+     * carriers sent before it that never arrived
+     * @return false if it is not a carrier
+     */
+    bool Unpack(Ptr<const Packet> carrier, std::vector<Ptr<Packet>>& packets, bool release) const;
+
+    /**
+     * @return Device at the other end of the link, nullptr if it is not an aggregating one
+     */
+    Ptr<AggregatingPointToPointNetDevice> GetPeer() const;
+
+    Time m_window;              //!< Max time a packet waits for others of its flow
+    uint32_t m_maxBytes;        //!< Max size of a carrier
+    std::map<FlowKey, PendingAggregate> m_pending;
+
+    NetDevice::ReceiveCallback m_upperRx;
+    NetDevice::PromiscReceiveCallback m_upperPromiscRx;
+
+    uint64_t m_carriers;
+    uint64_t m_carried;
+
+    /** Packets inside the carriers sent and not received yet, by carrier id */
+    mutable std::map<uint64_t, std::vector<Ptr<Packet>>> m_inFlight;
+    uint64_t m_nextId;
+};
+
+/**
+ * @brief Connects two nodes with AggregatingPointToPointNetDevice's, the same as
+ * PointToPointHelper::Install(a, b) does with plain devices
+ * @param window AggregationWindow of both devices
+ */
+NetDeviceContainer InstallAggregatingP2p(Ptr<Node> a,
+                                         Ptr<Node> b,
+                                         DataRate dataRate,
+                                         uint16_t mtu,
+                                         Time delay,
+                                         Time window);
+
+#endif // BACKHAUL_AGGREGATION_H
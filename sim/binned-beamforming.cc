@@ -0,0 +1,124 @@
+#include "ns3/core-module.h"
+#include "ns3/antenna-module.h"
+#include "ns3/nr-module.h"
+
+#include "binned-beamforming.h"
+
+#include <cmath>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("BinnedDirectPathBeamforming");
+
+NS_OBJECT_ENSURE_REGISTERED(BinnedDirectPathBeamforming);
+
+TypeId
+BinnedDirectPathBeamforming::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::BinnedDirectPathBeamforming")
+            .SetParent<IdealBeamformingAlgorithm>()
+            .SetGroupName("MyAppComp")
+            .AddConstructor<BinnedDirectPathBeamforming>()
+            .AddAttribute("AngleResolution",
+                          "Size (rad) of the azimuth and inclination bins",
+                          DoubleValue(M_PI / 180),
+                          MakeDoubleAccessor(&BinnedDirectPathBeamforming::m_resolution),
+                          MakeDoubleChecker<double>(1e-4, M_PI)); // azimuth bins fit in the uint16_t of BeamId
+    return tid;
+}
+
+uint64_t BinnedDirectPathBeamforming::s_hits = 0;
+uint64_t BinnedDirectPathBeamforming::s_misses = 0;
+
+BinnedDirectPathBeamforming::BinnedDirectPathBeamforming()
+    : m_resolution(M_PI / 180)
+{
+}
+
+BinnedDirectPathBeamforming::~BinnedDirectPathBeamforming()
+{
+}
+
+BeamformingVectorPair
+BinnedDirectPathBeamforming::GetBeamformingVectors(const Ptr<NrSpectrumPhy>& gnbSpectrumPhy,
+                                                   const Ptr<NrSpectrumPhy>& ueSpectrumPhy) const
+{
+    return std::make_pair(GetVector(gnbSpectrumPhy, ueSpectrumPhy), GetVector(ueSpectrumPhy, gnbSpectrumPhy));
+}
+
+uint32_t
+BinnedDirectPathBeamforming::GetConfigId(const Ptr<const UniformPlanarArray>& antenna) const
+{
+    auto it = m_configOf.find(PeekPointer(antenna));
+    if (it != m_configOf.end())
+    {
+        return it->second;
+    }
+
+    // Element locations already include the spacing and the orientation of the array
+    std::vector<double> locations;
+    locations.reserve(3 * antenna->GetNumberOfElements());
+    for (size_t i = 0; i < antenna->GetNumberOfElements(); i++)
+    {
+        Vector loc = antenna->GetElementLocation(i);
+        locations.push_back(loc.x);
+        locations.push_back(loc.y);
+        locations.push_back(loc.z);
+    }
+    uint32_t id = m_configs.emplace(locations, m_configs.size()).first->second;
+    m_configOf[PeekPointer(antenna)] = id;
+    return id;
+}
+
+BeamformingVector
+BinnedDirectPathBeamforming::GetVector(const Ptr<NrSpectrumPhy>& thisPhy,
+                                       const Ptr<NrSpectrumPhy>& otherPhy) const
+{
+    Ptr<const UniformPlanarArray> antenna = DynamicCast<const UniformPlanarArray>(thisPhy->GetAntenna());
+    NS_ABORT_MSG_IF(!antenna, "BinnedDirectPathBeamforming needs a UniformPlanarArray");
+
+    // Direction of the other end as seen from this one (as DirectPathBeamforming)
+    Angles angles(otherPhy->GetMobility()->GetPosition(), thisPhy->GetMobility()->GetPosition());
+    // Azimuth in [0, 2pi) so the bins are in [0, N) and the bin is a valid BeamId sector
+    double azimuth0 = angles.GetAzimuth() < 0 ? angles.GetAzimuth() + 2 * M_PI : angles.GetAzimuth();
+    int32_t nAzBins = static_cast<int32_t>(std::ceil(2 * M_PI / m_resolution));
+    int32_t azBin = std::min(static_cast<int32_t>(std::floor(azimuth0 / m_resolution)), nAzBins - 1);
+    int32_t incBin = static_cast<int32_t>(std::floor(angles.GetInclination() / m_resolution));
+
+    Key key(GetConfigId(antenna), azBin, incBin);
+    auto it = m_cache.find(key);
+    if (it != m_cache.end())
+    {
+        s_hits++;
+        return it->second;
+    }
+    s_misses++;
+
+    double azimuth = (azBin + 0.5) * m_resolution;
+    double inclination = (incBin + 0.5) * m_resolution;
+    size_t n = antenna->GetNumberOfElements();
+    double power = 1.0 / std::sqrt(n);
+
+    PhasedArrayModel::ComplexVector weights(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        Vector loc = antenna->GetElementLocation(i);
+        double phase = -2 * M_PI *
+                       (std::sin(inclination) * std::cos(azimuth) * loc.x +
+                        std::sin(inclination) * std::sin(azimuth) * loc.y +
+                        std::cos(inclination) * loc.z);
+        weights[i] = std::exp(std::complex<double>(0, phase)) * power;
+    }
+
+    // The bin identifies the beam
+    BeamformingVector bfv = std::make_pair(weights, BeamId(static_cast<uint16_t>(azBin), inclination * 180 / M_PI));
+    m_cache.emplace(key, bfv);
+    return bfv;
+}
+
+std::pair<uint64_t, uint64_t>
+BinnedDirectPathBeamforming::GetCacheStats()
+{
+    return std::make_pair(s_hits, s_misses);
+}
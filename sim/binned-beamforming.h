@@ -0,0 +1,62 @@
+#ifndef BINNED_BEAMFORMING_H
+#define BINNED_BEAMFORMING_H
+
+#include "ns3/core-module.h"
+#include "ns3/antenna-module.h"
+#include "ns3/nr-module.h"
+
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
+using namespace ns3;
+
+/**
+ * DirectPathBeamforming with the departure/arrival angles quantized to AngleResolution: the beam of
+ * an array points to the center of the (azimuth, inclination) bin of the other end, and it is kept
+ * in a cache by (array configuration, azimuth bin, inclination bin).
+ *
+ * A UE that stays in the same angular bin gets the same vector (same values, same BeamId), so the
+ * beamforming refresh does not make ThreeGppSpectrumPropagationLossModel recompute its long term
+ * component, and arrays with the same configuration share the computed vectors.
+ */
+class BinnedDirectPathBeamforming : public IdealBeamformingAlgorithm
+{
+public:
+    static TypeId GetTypeId();
+    BinnedDirectPathBeamforming();
+    ~BinnedDirectPathBeamforming() override;
+
+    BeamformingVectorPair GetBeamformingVectors(const Ptr<NrSpectrumPhy>& gnbSpectrumPhy,
+                                                const Ptr<NrSpectrumPhy>& ueSpectrumPhy) const override;
+
+    /**
+     * @return Vectors taken from the cache and vectors computed, by every instance (the helper owns
+     * the algorithm, so they are counted per run)
+     */
+    static std::pair<uint64_t, uint64_t> GetCacheStats();
+
+private:
+    /** Array configuration, azimuth bin, inclination bin */
+    using Key = std::tuple<uint32_t, int32_t, int32_t>;
+
+    /**
+     * @brief Beam of the array of thisPhy towards the other end
+     */
+    BeamformingVector GetVector(const Ptr<NrSpectrumPhy>& thisPhy, const Ptr<NrSpectrumPhy>& otherPhy) const;
+
+    /**
+     * @brief Identifier of the configuration of an array (same element locations, same id)
+     */
+    uint32_t GetConfigId(const Ptr<const UniformPlanarArray>& antenna) const;
+
+    double m_resolution;    //!< Attribute AngleResolution (rad)
+
+    mutable std::map<Key, BeamformingVector> m_cache;
+    mutable std::unordered_map<const UniformPlanarArray*, uint32_t> m_configOf;
+    mutable std::map<std::vector<double>, uint32_t> m_configs;
+    static uint64_t s_hits;
+    static uint64_t s_misses;
+};
+
+#endif // BINNED_BEAMFORMING_H
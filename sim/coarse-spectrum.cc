@@ -0,0 +1,188 @@
+#include "ns3/core-module.h"
+#include "ns3/nr-module.h"
+#include "ns3/spectrum-module.h"
+
+#include "coarse-spectrum.h"
+
+#include <algorithm>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("CoarseSpectrumPropagationLossModel");
+
+NS_OBJECT_ENSURE_REGISTERED(CoarseSpectrumPropagationLossModel);
+
+TypeId
+CoarseSpectrumPropagationLossModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::CoarseSpectrumPropagationLossModel")
+            .SetParent<PhasedArraySpectrumPropagationLossModel>()
+            .SetGroupName("MyAppComp")
+            .AddConstructor<CoarseSpectrumPropagationLossModel>()
+            .AddAttribute("RbPerBand",
+                          "RBs of a group evaluated with a single gain",
+                          UintegerValue(1),
+                          MakeUintegerAccessor(&CoarseSpectrumPropagationLossModel::m_rbPerBand),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("SamplesPerBand",
+                          "Frequencies of a group where the fading is evaluated, the group gets "
+                          "the mean of their gains (at most RbPerBand)",
+                          UintegerValue(2),
+                          MakeUintegerAccessor(&CoarseSpectrumPropagationLossModel::m_samples),
+                          MakeUintegerChecker<uint32_t>(1));
+    return tid;
+}
+
+CoarseSpectrumPropagationLossModel::CoarseSpectrumPropagationLossModel()
+    : m_rbPerBand(1),
+      m_samples(2)
+{
+}
+
+CoarseSpectrumPropagationLossModel::~CoarseSpectrumPropagationLossModel()
+{
+}
+
+void
+CoarseSpectrumPropagationLossModel::SetInner(Ptr<PhasedArraySpectrumPropagationLossModel> inner)
+{
+    m_inner = inner;
+}
+
+int64_t
+CoarseSpectrumPropagationLossModel::DoAssignStreams(int64_t stream)
+{
+    // The channel holds this model instead of the 3GPP one, so its streams are forwarded
+    return m_inner ? m_inner->AssignStreams(stream) : 0;
+}
+
+const CoarseSpectrumPropagationLossModel::Grouping&
+CoarseSpectrumPropagationLossModel::GetGrouping(Ptr<const SpectrumModel> fine) const
+{
+    auto it = m_groupings.find(fine->GetUid());
+    if (it != m_groupings.end())
+    {
+        return it->second;
+    }
+
+    Grouping grouping;
+    Bands bands;
+    uint32_t index = 0;
+    for (auto band = fine->Begin(); band != fine->End(); ++band, ++index)
+    {
+        uint32_t group = index / m_rbPerBand;
+        if (group == bands.size())
+        {
+            BandInfo info;
+            info.fl = band->fl;
+            bands.push_back(info);
+        }
+        bands.back().fh = band->fh;
+        grouping.group.push_back(group);
+        grouping.width.push_back(band->fh - band->fl);
+    }
+    grouping.groupWidth.assign(bands.size(), 0);
+    for (size_t i = 0; i < grouping.group.size(); ++i)
+    {
+        grouping.groupWidth[grouping.group[i]] += grouping.width[i];
+    }
+    // Every group split in equal parts, the fading is evaluated at the center of each part
+    const uint32_t samples = std::min(m_samples, m_rbPerBand);
+    Bands sampleBands;
+    for (auto& band : bands)
+    {
+        band.fc = (band.fl + band.fh) / 2;
+        double step = (band.fh - band.fl) / samples;
+        for (uint32_t k = 0; k < samples; ++k)
+        {
+            BandInfo info;
+            info.fl = band.fl + k * step;
+            info.fh = info.fl + step;
+            info.fc = info.fl + step / 2;
+            sampleBands.push_back(info);
+        }
+    }
+    grouping.model = Create<SpectrumModel>(bands);
+    grouping.samples = Create<SpectrumModel>(sampleBands);
+
+    NS_LOG_INFO("Spectrum model " << fine->GetUid() << ": " << fine->GetNumBands() << " bands in "
+                                  << bands.size() << " groups of " << samples << " samples");
+    return m_groupings.emplace(fine->GetUid(), std::move(grouping)).first->second;
+}
+
+Ptr<SpectrumValue>
+CoarseSpectrumPropagationLossModel::DoCalcRxPowerSpectralDensity(Ptr<const SpectrumSignalParameters> params,
+                                                                 Ptr<const MobilityModel> a,
+                                                                 Ptr<const MobilityModel> b,
+                                                                 Ptr<const PhasedArrayModel> aPhasedArrayModel,
+                                                                 Ptr<const PhasedArrayModel> bPhasedArrayModel) const
+{
+    const Grouping& grouping = GetGrouping(params->psd->GetSpectrumModel());
+
+    // Mean PSD of every group (energy over the group width)
+    Ptr<SpectrumValue> coarseTx = m_pool.Get(grouping.model);
+    for (size_t i = 0; i < grouping.group.size(); ++i)
+    {
+        (*coarseTx)[grouping.group[i]] += (*params->psd)[i] * grouping.width[i];
+    }
+    for (size_t g = 0; g < grouping.groupWidth.size(); ++g)
+    {
+        (*coarseTx)[g] /= grouping.groupWidth[g];
+    }
+
+    // The mean PSD of the group on each of its samples
+    const size_t groups = grouping.groupWidth.size();
+    const size_t samples = grouping.samples->GetNumBands() / groups;
+    Ptr<SpectrumValue> sampleTx = m_pool.Get(grouping.samples);
+    for (size_t s = 0; s < groups * samples; ++s)
+    {
+        (*sampleTx)[s] = (*coarseTx)[s / samples];
+    }
+
+    // Base parameters of the signal with the sampled PSD, in an object reused while nobody keeps it.
+    // The 3GPP model only reads the base fields
+    if (!m_coarseParams || m_coarseParams->GetReferenceCount() > 1)
+    {
+        m_coarseParams = Create<SpectrumSignalParameters>();
+    }
+    *m_coarseParams = *params;
+    m_coarseParams->psd = sampleTx;
+    Ptr<SpectrumValue> sampleRx =
+        m_inner->CalcRxPowerSpectralDensity(m_coarseParams, a, b, aPhasedArrayModel, bPhasedArrayModel);
+
+    // Mean gain of every group (the Tx PSD is the same on all its samples), kept in the coarse buffer
+    for (size_t g = 0; g < groups; ++g)
+    {
+        double sum = 0;
+        for (size_t k = 0; k < samples; ++k)
+        {
+            sum += (*sampleRx)[g * samples + k];
+        }
+        (*coarseTx)[g] = (*coarseTx)[g] > 0 ? sum / samples / (*coarseTx)[g] : 0;
+    }
+
+    // Gain of the group on every RB, in a buffer recycled once the receiver releases it
+    Ptr<SpectrumValue> rx = m_pool.Get(params->psd->GetSpectrumModel());
+    for (size_t i = 0; i < grouping.group.size(); ++i)
+    {
+        (*rx)[i] = (*params->psd)[i] * (*coarseTx)[grouping.group[i]];
+    }
+    return rx;
+}
+
+void
+InstallCoarseSpectrum(const BandwidthPartInfoPtrVector& bwps, uint32_t rbPerBand, uint32_t samples)
+{
+    for (const auto& bwp : bwps)
+    {
+        Ptr<CoarseSpectrumPropagationLossModel> coarse = CreateObject<CoarseSpectrumPropagationLossModel>();
+        coarse->SetAttribute("RbPerBand", UintegerValue(rbPerBand));
+        coarse->SetAttribute("SamplesPerBand", UintegerValue(samples));
+        coarse->SetInner(bwp.get()->m_3gppChannel);
+
+        // The 3GPP model stays in the BWP (its channel model can still be replaced), the channel
+        // calls it through the coarse one
+        bwp.get()->m_channel->SetAttribute("PhasedArraySpectrumPropagationLossModel", PointerValue(coarse));
+    }
+}
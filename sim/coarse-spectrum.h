@@ -0,0 +1,97 @@
+#ifndef COARSE_SPECTRUM_H
+#define COARSE_SPECTRUM_H
+
+#include "ns3/core-module.h"
+#include "ns3/nr-module.h"
+#include "ns3/spectrum-module.h"
+
+#include "spectrum-pool.h"
+
+#include <map>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Reduced frequency resolution of the fading, for fast exploratory runs. Experimental: its speedup
+ * and error have not been measured yet.
+ *
+ * The PHYs keep one SpectrumValue entry per RB (about 264 at 400 MHz and numerology 3) and the
+ * 3GPP spectrum model computes the small scale fading of every entry: for each RB the sum over the
+ * clusters of the beamformed channel with its delay and Doppler phases. This model sits in front of
+ * the ThreeGppSpectrumPropagationLossModel of the channel and evaluates it on groups of RbPerBand
+ * RBs instead: the transmitted PSD is averaged (in linear power) over each group, the 3GPP model
+ * computes the gain at SamplesPerBand frequencies evenly spread over the group (the centers of
+ * equal parts of it), and the mean of those gains (in linear power) is applied to every RB of the
+ * group. With SamplesPerBand equal to RbPerBand that is the mean gain of the RBs of the group; a
+ * single sample is the gain at the center of the group. Interference, SINR, CQI and EESM still see
+ * one value per RB, but flat inside a group: the PHY and the AMC do not know about the groups.
+ *
+ * The groups start at RB 0, so when RbPerBand is a multiple of the RBG size of the scheduler every
+ * RBG has a single gain and the allocation sees the same channel the PHY decodes with. When the RBs
+ * of the BWP are not a multiple of RbPerBand the last group is shorter, clamped to the band edge.
+ *
+ * The coarse PSDs, the received PSD and the parameters given to the 3GPP model are recycled, so this
+ * model does not allocate after the first slots; the 3GPP model still allocates its own received
+ * PSD (one value per sample) on every call.
+ *
+ * The cost of the fading drops by RbPerBand / SamplesPerBand; the error is the frequency selectivity
+ * lost inside a group, small while the group is narrower than the coherence bandwidth of the
+ * channel, and smaller with more samples per group. The groups end at the PHY: the SINR, the CQI and
+ * the EESM are still computed on every RB (with the same value inside a group). Compare a
+ * run against the full resolution one (same RngRun) with RunStats.txt (wall time) and FlowOutput.txt
+ * / RxPacketTrace (throughput and BLER) before using it in a study.
+ */
+class CoarseSpectrumPropagationLossModel : public PhasedArraySpectrumPropagationLossModel
+{
+public:
+    static TypeId GetTypeId();
+    CoarseSpectrumPropagationLossModel();
+    ~CoarseSpectrumPropagationLossModel() override;
+
+    /**
+     * @brief Model evaluated on the groups of RBs
+     */
+    void SetInner(Ptr<PhasedArraySpectrumPropagationLossModel> inner);
+
+    int64_t DoAssignStreams(int64_t stream) override;
+
+private:
+    /** Groups of a fine spectrum model */
+    struct Grouping
+    {
+        Ptr<const SpectrumModel> model;     //!< One band per group
+        Ptr<const SpectrumModel> samples;   //!< SamplesPerBand bands per group, given to the inner model
+        std::vector<uint32_t> group;        //!< Group of every fine band
+        std::vector<double> width;          //!< Width of every fine band (Hz)
+        std::vector<double> groupWidth;     //!< Width of every group (Hz)
+    };
+
+    Ptr<SpectrumValue> DoCalcRxPowerSpectralDensity(Ptr<const SpectrumSignalParameters> params,
+                                                    Ptr<const MobilityModel> a,
+                                                    Ptr<const MobilityModel> b,
+                                                    Ptr<const PhasedArrayModel> aPhasedArrayModel,
+                                                    Ptr<const PhasedArrayModel> bPhasedArrayModel) const override;
+
+    /**
+     * @return Groups of a fine spectrum model, created the first time it is seen
+     */
+    const Grouping& GetGrouping(Ptr<const SpectrumModel> fine) const;
+
+    uint32_t m_rbPerBand;   //!< Attribute RbPerBand
+    uint32_t m_samples;     //!< Attribute SamplesPerBand
+    Ptr<PhasedArraySpectrumPropagationLossModel> m_inner;
+    mutable std::map<SpectrumModelUid_t, Grouping> m_groupings;
+    mutable SpectrumValuePool m_pool;   //!< Coarse, sampled and received PSDs
+    mutable Ptr<SpectrumSignalParameters> m_coarseParams;  //!< Parameters given to the inner model
+};
+
+/**
+ * @brief Puts a CoarseSpectrumPropagationLossModel in front of the 3GPP spectrum model of the
+ * channel of every BWP
+ * @param rbPerBand RBs per group
+ * @param samples Frequencies of a group where the fading is evaluated
+ */
+void InstallCoarseSpectrum(const BandwidthPartInfoPtrVector& bwps, uint32_t rbPerBand, uint32_t samples);
+
+#endif // COARSE_SPECTRUM_H
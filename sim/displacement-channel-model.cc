@@ -0,0 +1,225 @@
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/nr-module.h"
+#include "ns3/spectrum-module.h"
+
+#include "displacement-channel-model.h"
+
+#include <cmath>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("DisplacementChannelModel");
+
+NS_OBJECT_ENSURE_REGISTERED(DisplacementChannelModel);
+
+TypeId
+DisplacementChannelModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::DisplacementChannelModel")
+            .SetParent<ParallelChannelModel>()
+            .SetGroupName("MyAppComp")
+            .AddConstructor<DisplacementChannelModel>()
+            .AddAttribute("Distance",
+                          "Displacement (m) of a link end after which its channel is regenerated",
+                          DoubleValue(1.0),
+                          MakeDoubleAccessor(&DisplacementChannelModel::m_distance),
+                          MakeDoubleChecker<double>(0.0))
+            .AddAttribute("Angle",
+                          "Rotation (rad) of the direction between the link ends after which its "
+                          "channel is regenerated",
+                          DoubleValue(10 * M_PI / 180),
+                          MakeDoubleAccessor(&DisplacementChannelModel::m_angle),
+                          MakeDoubleChecker<double>(0.0))
+            .AddAttribute("BinSize",
+                          "Side (m) of the position bins used to reuse the generated channels",
+                          DoubleValue(1.0),
+                          MakeDoubleAccessor(&DisplacementChannelModel::m_binSize),
+                          MakeDoubleChecker<double>(1e-3))
+            .AddAttribute("MaxCachedChannels",
+                          "Channels kept by position bin, the cache is emptied when it is full",
+                          UintegerValue(8192),
+                          MakeUintegerAccessor(&DisplacementChannelModel::m_maxBins),
+                          MakeUintegerChecker<uint32_t>(1));
+    return tid;
+}
+
+DisplacementChannelModel::DisplacementChannelModel()
+    : m_distance(1.0),
+      m_angle(10 * M_PI / 180),
+      m_binSize(1.0),
+      m_maxBins(8192),
+      m_generated(0),
+      m_binHits(0),
+      m_reused(0)
+{
+}
+
+DisplacementChannelModel::~DisplacementChannelModel()
+{
+}
+
+uint64_t
+DisplacementChannelModel::PairKey(uint32_t x, uint32_t y)
+{
+    return (static_cast<uint64_t>(std::min(x, y)) << 32) | std::max(x, y);
+}
+
+bool
+DisplacementChannelModel::Moved(const Link& link, const Vector& aPos, const Vector& bPos) const
+{
+    if (CalculateDistance(link.aPos, aPos) > m_distance || CalculateDistance(link.bPos, bPos) > m_distance)
+    {
+        return true;
+    }
+
+    Vector before = link.bPos - link.aPos;
+    Vector now = bPos - aPos;
+    double norms = before.GetLength() * now.GetLength();
+    if (norms <= 0)
+    {
+        return false;
+    }
+    double cosine = (before.x * now.x + before.y * now.y + before.z * now.z) / norms;
+    return std::acos(std::max(-1.0, std::min(1.0, cosine))) > m_angle;
+}
+
+DisplacementChannelModel::BinKey
+DisplacementChannelModel::GetBinKey(uint64_t link,
+                                    uint32_t aNode,
+                                    const Vector& aPos,
+                                    uint32_t bNode,
+                                    const Vector& bPos) const
+{
+    auto bin = [this](double v) { return static_cast<int64_t>(std::floor(v / m_binSize)); };
+    const Vector& first = aNode <= bNode ? aPos : bPos;
+    const Vector& second = aNode <= bNode ? bPos : aPos;
+    return BinKey(link,
+                  bin(first.x), bin(first.y), bin(first.z),
+                  bin(second.x), bin(second.y), bin(second.z));
+}
+
+Ptr<const MatrixBasedChannelModel::ChannelMatrix>
+DisplacementChannelModel::GetChannel(Ptr<const MobilityModel> aMob,
+                                     Ptr<const MobilityModel> bMob,
+                                     Ptr<const PhasedArrayModel> aAntenna,
+                                     Ptr<const PhasedArrayModel> bAntenna)
+{
+    uint32_t aNode = aMob->GetObject<Node>()->GetId();
+    uint32_t bNode = bMob->GetObject<Node>()->GetId();
+    uint64_t linkKey = PairKey(aAntenna->GetId(), bAntenna->GetId());
+    uint64_t paramsKey = PairKey(aNode, bNode);
+    Vector aPos = aMob->GetPosition();
+    Vector bPos = bMob->GetPosition();
+    // Positions are stored as seen from the lowest antenna id, so both directions compare the same
+    if (aAntenna->GetId() > bAntenna->GetId())
+    {
+        std::swap(aPos, bPos);
+    }
+
+    auto it = m_links.find(linkKey);
+    if (it != m_links.end() && !Moved(it->second, aPos, bPos))
+    {
+        m_reused++;
+        return it->second.matrix;
+    }
+
+    BinKey binKey = GetBinKey(linkKey, aNode, aMob->GetPosition(), bNode, bMob->GetPosition());
+    auto cached = m_bins.find(binKey);
+    if (cached != m_bins.end())
+    {
+        m_binHits++;
+        Link& link = m_links[linkKey];
+        link = cached->second;
+        link.aPos = aPos;
+        link.bPos = bPos;
+        m_params[paramsKey] = link.params;
+        return link.matrix;
+    }
+
+    // Generate a new channel: the base model regenerates it when its update period is over, so it
+    // is set to the minimum only for this call
+    TimeValue period;
+    GetAttribute("UpdatePeriod", period);
+    if (it != m_links.end())
+    {
+        SetAttribute("UpdatePeriod", TimeValue(TimeStep(1)));
+    }
+    Ptr<const ChannelMatrix> matrix = ThreeGppChannelModel::GetChannel(aMob, bMob, aAntenna, bAntenna);
+    SetAttribute("UpdatePeriod", period);
+    m_generated++;
+
+    Link link;
+    link.aPos = aPos;
+    link.bPos = bPos;
+    link.matrix = matrix;
+    link.params = ThreeGppChannelModel::GetParams(aMob, bMob);
+    m_links[linkKey] = link;
+    m_params[paramsKey] = link.params;
+
+    if (m_bins.size() >= m_maxBins)
+    {
+        NS_LOG_INFO("Channel bin cache full, emptying it");
+        m_bins.clear();
+    }
+    m_bins[binKey] = link;
+    return matrix;
+}
+
+Ptr<const MatrixBasedChannelModel::ChannelParams>
+DisplacementChannelModel::GetParams(Ptr<const MobilityModel> aMob, Ptr<const MobilityModel> bMob) const
+{
+    auto it = m_params.find(PairKey(aMob->GetObject<Node>()->GetId(), bMob->GetObject<Node>()->GetId()));
+    if (it != m_params.end())
+    {
+        return it->second;
+    }
+    return ThreeGppChannelModel::GetParams(aMob, bMob);
+}
+
+std::tuple<uint64_t, uint64_t, uint64_t>
+DisplacementChannelModel::GetStats() const
+{
+    return std::make_tuple(m_generated, m_binHits, m_reused);
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+std::vector<Ptr<DisplacementChannelModel>>
+InstallDisplacementChannelModel(const BandwidthPartInfoPtrVector& bwps,
+                                double distance,
+                                double angleDeg,
+                                double binSize)
+{
+    std::vector<Ptr<DisplacementChannelModel>> models;
+    for (const auto& bwp : bwps)
+    {
+        Ptr<ThreeGppSpectrumPropagationLossModel> spectrumLoss =
+            DynamicCast<ThreeGppSpectrumPropagationLossModel>(bwp.get()->m_3gppChannel);
+        NS_ABORT_MSG_IF(!spectrumLoss, "The BWP has no 3GPP spectrum propagation loss model");
+
+        PointerValue current;
+        spectrumLoss->GetAttribute("ChannelModel", current);
+        Ptr<ThreeGppChannelModel> old = current.Get<ThreeGppChannelModel>();
+        NS_ABORT_MSG_IF(!old, "The BWP channel model is not a ThreeGppChannelModel");
+
+        DoubleValue frequency;
+        StringValue scenario;
+        PointerValue condition;
+        old->GetAttribute("Frequency", frequency);
+        old->GetAttribute("Scenario", scenario);
+        old->GetAttribute("ChannelConditionModel", condition);
+
+        Ptr<DisplacementChannelModel> model = CreateObject<DisplacementChannelModel>();
+        model->SetAttribute("Frequency", frequency);
+        model->SetAttribute("Scenario", scenario);
+        model->SetAttribute("ChannelConditionModel", condition);
+        model->SetAttribute("Distance", DoubleValue(distance));
+        model->SetAttribute("Angle", DoubleValue(angleDeg * M_PI / 180));
+        model->SetAttribute("BinSize", DoubleValue(binSize));
+        spectrumLoss->SetAttribute("ChannelModel", PointerValue(model));
+        models.push_back(model);
+    }
+    return models;
+}
@@ -0,0 +1,99 @@
+#ifndef DISPLACEMENT_CHANNEL_MODEL_H
+#define DISPLACEMENT_CHANNEL_MODEL_H
+
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/nr-module.h"
+#include "ns3/spectrum-module.h"
+
+#include "parallel-channel-model.h"
+
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * 3GPP channel model whose channel (matrix and parameters) is regenerated when the link moves, not
+ * when time passes: a link keeps its channel until one of its ends moved more than Distance, or the
+ * direction between them rotated more than Angle, since the channel was generated.
+ *
+ * Every generated channel is also kept by the position bin (BinSize) of both ends, so a UE that comes
+ * back to a bin (same path, round trip) gets the same channel without generating it again. The long
+ * term component of ThreeGppSpectrumPropagationLossModel is recomputed only when the channel it
+ * receives changes, so it follows the same policy.
+ *
+ * Keep UpdatePeriod at 0, if not the channel is also regenerated by time. The matrices it does
+ * generate are computed as in ParallelChannelModel (Threads).
+ */
+class DisplacementChannelModel : public ParallelChannelModel
+{
+public:
+    static TypeId GetTypeId();
+    DisplacementChannelModel();
+    ~DisplacementChannelModel() override;
+
+    Ptr<const ChannelMatrix> GetChannel(Ptr<const MobilityModel> aMob,
+                                        Ptr<const MobilityModel> bMob,
+                                        Ptr<const PhasedArrayModel> aAntenna,
+                                        Ptr<const PhasedArrayModel> bAntenna) override;
+
+    Ptr<const ChannelParams> GetParams(Ptr<const MobilityModel> aMob,
+                                       Ptr<const MobilityModel> bMob) const override;
+
+    /**
+     * @return Number of channels generated, taken from the bin cache and reused without moving
+     * (written to RunStats.txt)
+     */
+    std::tuple<uint64_t, uint64_t, uint64_t> GetStats() const;
+
+private:
+    /** Channel in use by a link */
+    struct Link
+    {
+        Vector aPos;
+        Vector bPos;
+        Ptr<const ChannelMatrix> matrix;
+        Ptr<const ChannelParams> params;
+    };
+
+    /** Link (antenna pair) and position bins of both ends, lowest node id first */
+    using BinKey = std::tuple<uint64_t, int64_t, int64_t, int64_t, int64_t, int64_t, int64_t>;
+
+    static uint64_t PairKey(uint32_t x, uint32_t y);
+
+    /**
+     * @return true if the link moved past Distance or Angle since its channel was generated
+     */
+    bool Moved(const Link& link, const Vector& aPos, const Vector& bPos) const;
+
+    BinKey GetBinKey(uint64_t link, uint32_t aNode, const Vector& aPos, uint32_t bNode, const Vector& bPos) const;
+
+    double m_distance;      //!< Attribute Distance (m)
+    double m_angle;         //!< Attribute Angle (rad)
+    double m_binSize;       //!< Attribute BinSize (m)
+    uint32_t m_maxBins;     //!< Attribute MaxCachedChannels
+
+    std::unordered_map<uint64_t, Link> m_links;             //!< Key: antenna pair
+    std::unordered_map<uint64_t, Ptr<const ChannelParams>> m_params;  //!< Key: node pair
+    std::map<BinKey, Link> m_bins;
+
+    uint64_t m_generated;
+    uint64_t m_binHits;
+    uint64_t m_reused;
+};
+
+/**
+ * @brief Replaces the channel model of the 3GPP spectrum propagation model of every BWP by a
+ * DisplacementChannelModel with the same frequency, scenario and channel condition model. Call it
+ * after NrHelper::InitializeOperationBand and before installing the devices
+ * @return The installed models, to read their stats
+ */
+std::vector<Ptr<DisplacementChannelModel>> InstallDisplacementChannelModel(const BandwidthPartInfoPtrVector& bwps,
+                                     double distance,
+                                     double angleDeg,
+                                     double binSize);
+
+#endif // DISPLACEMENT_CHANNEL_MODEL_H
@@ -0,0 +1,383 @@
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include "distributed-mode.h"
+
+#ifdef NS3_MPI
+#include "ns3/mpi-interface.h"
+
+#include <mpi.h>
+#endif
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("DistributedMode");
+
+#ifdef NS3_MPI
+NS_OBJECT_ENSURE_REGISTERED(PartitionedSimulatorImpl);
+
+const int RESULTS_TAG = 0x2D52;     // MPI tag of SendToRank, ns-3 uses 0 for the packets
+
+void
+EnableDistributedMode(int* argc, char*** argv)
+{
+    // MpiInterface picks the granted time window interface from the simulator type, then ours wraps it
+    GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::DistributedSimulatorImpl"));
+    MpiInterface::Enable(argc, argv);
+    GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::PartitionedSimulatorImpl"));
+
+    NS_ABORT_MSG_IF(MpiInterface::GetSize() != 2,
+                    "The distributed mode needs 2 processes (mpirun -np 2), not " << MpiInterface::GetSize());
+    NS_LOG_INFO("Rank " << MpiInterface::GetSystemId() << " of " << MpiInterface::GetSize());
+}
+
+void
+DisableDistributedMode()
+{
+    if (MpiInterface::IsEnabled())
+    {
+        MpiInterface::Disable();
+    }
+}
+
+bool
+IsDistributed()
+{
+    return MpiInterface::IsEnabled();
+}
+
+uint32_t
+GetRank()
+{
+    return MpiInterface::IsEnabled() ? MpiInterface::GetSystemId() : RAN_RANK;
+}
+
+void
+SendToRank(uint32_t rank, const std::string& data)
+{
+    uint64_t size = data.size();
+    MPI_Send(&size, 1, MPI_UINT64_T, rank, RESULTS_TAG, MpiInterface::GetCommunicator());
+    MPI_Send(data.data(), size, MPI_CHAR, rank, RESULTS_TAG, MpiInterface::GetCommunicator());
+}
+
+std::string
+ReceiveFromRank(uint32_t rank)
+{
+    uint64_t size = 0;
+    MPI_Recv(&size, 1, MPI_UINT64_T, rank, RESULTS_TAG, MpiInterface::GetCommunicator(), MPI_STATUS_IGNORE);
+    std::string data(size, '\0');
+    MPI_Recv(data.data(), size, MPI_CHAR, rank, RESULTS_TAG, MpiInterface::GetCommunicator(), MPI_STATUS_IGNORE);
+    return data;
+}
+
+#else
+
+void
+EnableDistributedMode(int* argc [[maybe_unused]], char*** argv [[maybe_unused]])
+{
+    NS_FATAL_ERROR("ns-3 was built without MPI, configure it with ./ns3 configure --enable-mpi");
+}
+
+void
+DisableDistributedMode()
+{
+}
+
+bool
+IsDistributed()
+{
+    return false;
+}
+
+uint32_t
+GetRank()
+{
+    return RAN_RANK;
+}
+
+void
+SendToRank(uint32_t rank [[maybe_unused]], const std::string& data [[maybe_unused]])
+{
+    NS_FATAL_ERROR("ns-3 was built without MPI");
+}
+
+std::string
+ReceiveFromRank(uint32_t rank [[maybe_unused]])
+{
+    NS_FATAL_ERROR("ns-3 was built without MPI");
+}
+
+#endif // NS3_MPI
+
+uint32_t
+RankSystemId(uint32_t sysId, uint32_t rank)
+{
+    return IsDistributed() ? rank : sysId;
+}
+
+bool
+IsLocal(Ptr<Node> node)
+{
+    return !IsDistributed() || node->GetSystemId() == GetRank();
+}
+
+std::string
+RankFileName(std::string filename)
+{
+    if (GetRank() == RAN_RANK || filename.empty())
+    {
+        return filename;
+    }
+
+    std::string rank = "-rank" + std::to_string(GetRank());
+    size_t dot = filename.find_last_of('.');
+    size_t slash = filename.find_last_of('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    {
+        return filename + rank;
+    }
+    return filename.substr(0, dot) + rank + filename.substr(dot);
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+NS_OBJECT_ENSURE_REGISTERED(NodeOrderScheduler);
+
+TypeId
+NodeOrderScheduler::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::NodeOrderScheduler")
+                            .SetParent<Scheduler>()
+                            .SetGroupName("MyAppComp")
+                            .AddConstructor<NodeOrderScheduler>();
+    return tid;
+}
+
+NodeOrderScheduler::NodeOrderScheduler()
+{
+}
+
+NodeOrderScheduler::~NodeOrderScheduler()
+{
+}
+
+bool
+NodeOrderScheduler::KeyCompare::operator()(const EventKey& a, const EventKey& b) const
+{
+    if (a.m_ts != b.m_ts)
+    {
+        return a.m_ts < b.m_ts;
+    }
+    if (a.m_context != b.m_context)
+    {
+        return a.m_context < b.m_context;
+    }
+    return a.m_uid < b.m_uid;
+}
+
+void
+NodeOrderScheduler::Insert(const Event& ev)
+{
+    m_events.emplace(ev.key, ev.impl);
+}
+
+bool
+NodeOrderScheduler::IsEmpty() const
+{
+    return m_events.empty();
+}
+
+Scheduler::Event
+NodeOrderScheduler::PeekNext() const
+{
+    NS_ASSERT(!m_events.empty());
+    auto it = m_events.begin();
+    return Event{it->second, it->first};
+}
+
+Scheduler::Event
+NodeOrderScheduler::RemoveNext()
+{
+    NS_ASSERT(!m_events.empty());
+    auto it = m_events.begin();
+    Event ev{it->second, it->first};
+    m_events.erase(it);
+    return ev;
+}
+
+void
+NodeOrderScheduler::Remove(const Event& ev)
+{
+    auto it = m_events.find(ev.key);
+    NS_ASSERT(it != m_events.end() && it->second == ev.impl);
+    m_events.erase(it);
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+#ifdef NS3_MPI
+
+TypeId
+PartitionedSimulatorImpl::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::PartitionedSimulatorImpl")
+                            .SetParent<SimulatorImpl>()
+                            .SetGroupName("MyAppComp")
+                            .AddConstructor<PartitionedSimulatorImpl>();
+    return tid;
+}
+
+PartitionedSimulatorImpl::PartitionedSimulatorImpl()
+    : m_rank(0),
+      m_dropped(0)
+{
+}
+
+PartitionedSimulatorImpl::~PartitionedSimulatorImpl()
+{
+}
+
+void
+PartitionedSimulatorImpl::NotifyConstructionCompleted()
+{
+    SimulatorImpl::NotifyConstructionCompleted();
+
+    ObjectFactory factory("ns3::DistributedSimulatorImpl");
+    m_simulator = factory.Create<SimulatorImpl>();
+    m_rank = MpiInterface::GetSystemId();
+}
+
+void
+PartitionedSimulatorImpl::DoDispose()
+{
+    if (m_simulator)
+    {
+        m_simulator->Dispose();
+        m_simulator = nullptr;
+    }
+    SimulatorImpl::DoDispose();
+}
+
+void
+PartitionedSimulatorImpl::ScheduleWithContext(uint32_t context, const Time& delay, EventImpl* event)
+{
+    if (context != Simulator::NO_CONTEXT && context < NodeList::GetNNodes() &&
+        NodeList::GetNode(context)->GetSystemId() != m_rank)
+    {
+        m_dropped++;
+        event->Unref();
+        return;
+    }
+    m_simulator->ScheduleWithContext(context, delay, event);
+}
+
+void
+PartitionedSimulatorImpl::Destroy()
+{
+    NS_LOG_INFO("Rank " << m_rank << ": " << m_dropped << " events of nodes of the other rank dropped");
+    m_simulator->Destroy();
+}
+
+bool
+PartitionedSimulatorImpl::IsFinished() const
+{
+    return m_simulator->IsFinished();
+}
+
+void
+PartitionedSimulatorImpl::Stop()
+{
+    m_simulator->Stop();
+}
+
+EventId
+PartitionedSimulatorImpl::Stop(const Time& delay)
+{
+    return m_simulator->Stop(delay);
+}
+
+EventId
+PartitionedSimulatorImpl::Schedule(const Time& delay, EventImpl* event)
+{
+    return m_simulator->Schedule(delay, event);
+}
+
+EventId
+PartitionedSimulatorImpl::ScheduleNow(EventImpl* event)
+{
+    return m_simulator->ScheduleNow(event);
+}
+
+EventId
+PartitionedSimulatorImpl::ScheduleDestroy(EventImpl* event)
+{
+    return m_simulator->ScheduleDestroy(event);
+}
+
+void
+PartitionedSimulatorImpl::Remove(const EventId& id)
+{
+    m_simulator->Remove(id);
+}
+
+void
+PartitionedSimulatorImpl::Cancel(const EventId& id)
+{
+    m_simulator->Cancel(id);
+}
+
+bool
+PartitionedSimulatorImpl::IsExpired(const EventId& id) const
+{
+    return m_simulator->IsExpired(id);
+}
+
+void
+PartitionedSimulatorImpl::Run()
+{
+    m_simulator->Run();
+}
+
+Time
+PartitionedSimulatorImpl::Now() const
+{
+    return m_simulator->Now();
+}
+
+Time
+PartitionedSimulatorImpl::GetDelayLeft(const EventId& id) const
+{
+    return m_simulator->GetDelayLeft(id);
+}
+
+Time
+PartitionedSimulatorImpl::GetMaximumSimulationTime() const
+{
+    return m_simulator->GetMaximumSimulationTime();
+}
+
+void
+PartitionedSimulatorImpl::SetScheduler(ObjectFactory schedulerFactory)
+{
+    m_simulator->SetScheduler(schedulerFactory);
+}
+
+uint32_t
+PartitionedSimulatorImpl::GetSystemId() const
+{
+    return m_simulator->GetSystemId();
+}
+
+uint32_t
+PartitionedSimulatorImpl::GetContext() const
+{
+    return m_simulator->GetContext();
+}
+
+uint64_t
+PartitionedSimulatorImpl::GetEventCount() const
+{
+    return m_simulator->GetEventCount();
+}
+
+#endif // NS3_MPI
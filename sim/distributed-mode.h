@@ -0,0 +1,159 @@
+#ifndef DISTRIBUTED_MODE_H
+#define DISTRIBUTED_MODE_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <map>
+#include <string>
+
+using namespace ns3;
+
+/*
+ * Distributed run (--mpi=1) with two MPI processes (mpirun -np 2), ns-3 DistributedSimulatorImpl:
+ *  - RAN_RANK: gNBs, UEs and the EPC (SGW, PGW, MME)
+ *  - SERVER_RANK: remote host and the traffic it generates
+ *
+ * The cut is the RemoteHost<->PGW p2p link, whose delay (server delay, 4 ms Edge or 40 ms Remote) is
+ * the lookahead of the conservative synchronization. The EPC can not go to the server rank: the S1-U
+ * links have no delay and the S1-AP/S11 interfaces are direct calls between the nodes.
+ *
+ * Every node (and object) is created in both processes in the same order, so node ids and random
+ * streams are the ones of the single process run. Without --mpi these functions leave the system ids
+ * and file names as they are.
+ */
+const uint32_t RAN_RANK = 0;
+const uint32_t SERVER_RANK = 1;
+
+/**
+ * @brief Enables MPI and the PartitionedSimulatorImpl. Must be called before any node or event is
+ * created (the simulator implementation is chosen on first use). Aborts if ns-3 was built without MPI
+ * or the run does not have 2 processes
+ */
+void EnableDistributedMode(int* argc, char*** argv);
+
+/**
+ * @brief Finalizes MPI (after Simulator::Destroy), nothing if the mode is not enabled
+ */
+void DisableDistributedMode();
+
+bool IsDistributed();
+
+/**
+ * @return Rank of this process, RAN_RANK if the mode is not enabled
+ */
+uint32_t GetRank();
+
+/**
+ * @return rank as system id of a node if the mode is enabled, sysId otherwise
+ */
+uint32_t RankSystemId(uint32_t sysId, uint32_t rank);
+
+/**
+ * @return If the events of the node are simulated by this process (always, if the mode is not enabled)
+ */
+bool IsLocal(Ptr<Node> node);
+
+/**
+ * @return filename on the RAN rank, filename with "-rankN" before the extension on the others, so
+ * both processes can write their own copy of the same output
+ */
+std::string RankFileName(std::string filename);
+
+/**
+ * @brief Sends data to rank (blocking), for the results gathered after the run
+ */
+void SendToRank(uint32_t rank, const std::string& data);
+
+/**
+ * @return The data sent by rank with SendToRank (blocking)
+ */
+std::string ReceiveFromRank(uint32_t rank);
+
+/**
+ * Event scheduler that runs the simultaneous events by context (node id) and then in the order they
+ * were scheduled, instead of only in the order they were scheduled.
+ *
+ * A packet that crosses the cut is scheduled in the receiving rank when the MPI message arrives (at
+ * the end of a synchronization window), not when it is sent as in the single process run, so with the
+ * default ordering it could run after events of other nodes at the same nanosecond that it would have
+ * run before. Ordering the ties by node makes them the same in both runs; only the ties with events of
+ * the receiving node itself still depend on when the packet was scheduled. The mpi mode always uses
+ * it, a single process run needs it too (--scheduler=NodeOrder) to be compared with a distributed one.
+ */
+class NodeOrderScheduler : public Scheduler
+{
+public:
+    static TypeId GetTypeId();
+    NodeOrderScheduler();
+    ~NodeOrderScheduler() override;
+
+    // Scheduler
+    void Insert(const Event& ev) override;
+    bool IsEmpty() const override;
+    Event PeekNext() const override;
+    Event RemoveNext() override;
+    void Remove(const Event& ev) override;
+
+private:
+    /** Time, context and uid order of the event keys */
+    struct KeyCompare
+    {
+        bool operator()(const EventKey& a, const EventKey& b) const;
+    };
+
+    std::map<EventKey, EventImpl*, KeyCompare> m_events;
+};
+
+#ifdef NS3_MPI
+/**
+ * DistributedSimulatorImpl that only keeps the events of the nodes of this process.
+ *
+ * Both processes hold every node, but a node only lives in the rank of its system id: the events
+ * scheduled with the context of a node of the other rank (its initialization, the slot loop of the NR
+ * PHYs, its applications) are dropped. Without it the server rank would also simulate the whole RAN
+ * (with no traffic), and the applications of the remote host would run in both processes. Events
+ * without context (scheduled from main) are kept in both.
+ *
+ * It wraps the DistributedSimulatorImpl the same way VisualSimulatorImpl wraps the default one.
+ */
+class PartitionedSimulatorImpl : public SimulatorImpl
+{
+public:
+    static TypeId GetTypeId();
+    PartitionedSimulatorImpl();
+    ~PartitionedSimulatorImpl() override;
+
+    // SimulatorImpl
+    void Destroy() override;
+    bool IsFinished() const override;
+    void Stop() override;
+    EventId Stop(const Time& delay) override;
+    EventId Schedule(const Time& delay, EventImpl* event) override;
+    void ScheduleWithContext(uint32_t context, const Time& delay, EventImpl* event) override;
+    EventId ScheduleNow(EventImpl* event) override;
+    EventId ScheduleDestroy(EventImpl* event) override;
+    void Remove(const EventId& id) override;
+    void Cancel(const EventId& id) override;
+    bool IsExpired(const EventId& id) const override;
+    void Run() override;
+    Time Now() const override;
+    Time GetDelayLeft(const EventId& id) const override;
+    Time GetMaximumSimulationTime() const override;
+    void SetScheduler(ObjectFactory schedulerFactory) override;
+    uint32_t GetSystemId() const override;
+    uint32_t GetContext() const override;
+    uint64_t GetEventCount() const override;
+
+protected:
+    void DoDispose() override;
+    void NotifyConstructionCompleted() override;
+
+private:
+    Ptr<SimulatorImpl> m_simulator;     //!< The DistributedSimulatorImpl
+    uint32_t m_rank;
+    uint64_t m_dropped;                 //!< Events of nodes of the other rank
+};
+#endif // NS3_MPI
+
+#endif // DISTRIBUTED_MODE_H
@@ -0,0 +1,261 @@
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/nr-module.h"
+#include "ns3/eps-bearer-tag.h"
+#include "ns3/lte-ue-rrc.h"
+
+#include "epc-bypass.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("EpcBypass");
+
+NS_OBJECT_ENSURE_REGISTERED(EpcBypassNetDevice);
+
+TypeId
+EpcBypassNetDevice::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::EpcBypassNetDevice")
+            .SetParent<NetDevice>()
+            .SetGroupName("MyAppComp")
+            .AddConstructor<EpcBypassNetDevice>()
+            .AddAttribute("Delay",
+                          "Delay line between the remote host and the gNB (one way server delay)",
+                          TimeValue(MilliSeconds(40)),
+                          MakeTimeAccessor(&EpcBypassNetDevice::m_delay),
+                          MakeTimeChecker(Seconds(0)))
+            .AddAttribute("BearerId",
+                          "EPS bearer id used for the downlink traffic",
+                          UintegerValue(1),
+                          MakeUintegerAccessor(&EpcBypassNetDevice::m_bearerId),
+                          MakeUintegerChecker<uint8_t>(1, 15))
+            .AddAttribute("Mtu",
+                          "The MAC-level Maximum Transmission Unit",
+                          UintegerValue(1500),
+                          MakeUintegerAccessor(&EpcBypassNetDevice::m_mtu),
+                          MakeUintegerChecker<uint16_t>())
+            .AddTraceSource("Tx",
+                            "Packet given to a gNB",
+                            MakeTraceSourceAccessor(&EpcBypassNetDevice::m_txTrace),
+                            "ns3::Packet::TracedCallback")
+            .AddTraceSource("Drop",
+                            "Packet dropped, unknown UE or UE not connected",
+                            MakeTraceSourceAccessor(&EpcBypassNetDevice::m_dropTrace),
+                            "ns3::Packet::TracedCallback");
+    return tid;
+}
+
+EpcBypassNetDevice::EpcBypassNetDevice()
+    : m_node(nullptr),
+      m_ifIndex(0),
+      m_mtu(1500),
+      m_address(Mac48Address::Allocate()),
+      m_bearerId(1)
+{
+}
+
+EpcBypassNetDevice::~EpcBypassNetDevice()
+{
+}
+
+void
+EpcBypassNetDevice::DoDispose()
+{
+    m_node = nullptr;
+    m_ues.clear();
+    NetDevice::DoDispose();
+}
+
+void
+EpcBypassNetDevice::AddUe(Ipv4Address ueAddress, Ptr<NrUeNetDevice> ueDevice)
+{
+    NS_LOG_FUNCTION(this << ueAddress);
+    m_ues[ueAddress] = ueDevice;
+}
+
+bool
+EpcBypassNetDevice::Send(Ptr<Packet> packet, const Address& dest [[maybe_unused]], uint16_t protocolNumber)
+{
+    NS_LOG_FUNCTION(this << packet << protocolNumber);
+    if (protocolNumber != Ipv4L3Protocol::PROT_NUMBER)
+    {
+        m_dropTrace(packet);
+        return false;
+    }
+
+    Ipv4Header ipHeader;
+    packet->PeekHeader(ipHeader);
+    Simulator::Schedule(m_delay, &EpcBypassNetDevice::Deliver, this, packet, ipHeader.GetDestination());
+    return true;
+}
+
+void
+EpcBypassNetDevice::Deliver(Ptr<Packet> packet, Ipv4Address destination)
+{
+    auto it = m_ues.find(destination);
+    if (it == m_ues.end())
+    {
+        NS_LOG_WARN("No UE with address " << destination);
+        m_dropTrace(packet);
+        return;
+    }
+
+    // The RNTI and the serving gNB are read at delivery time, they change with the RRC connection
+    Ptr<NrUeNetDevice> ueDev = it->second;
+    Ptr<NrGnbNetDevice> gnbDev = ConstCast<NrGnbNetDevice>(ueDev->GetTargetEnb());
+    uint16_t rnti = ueDev->GetRrc()->GetRnti();
+    if (!gnbDev || rnti == 0)
+    {
+        NS_LOG_LOGIC("UE " << destination << " not connected yet");
+        m_dropTrace(packet);
+        return;
+    }
+
+    // Same tag EpcEnbApplication puts on the packets from the S1-U tunnel
+    EpsBearerTag tag(rnti, m_bearerId);
+    packet->AddPacketTag(tag);
+    m_txTrace(packet);
+    gnbDev->Send(packet, ueDev->GetAddress(), Ipv4L3Protocol::PROT_NUMBER);
+}
+
+void
+EpcBypassNetDevice::SetIfIndex(const uint32_t index)
+{
+    m_ifIndex = index;
+}
+
+uint32_t
+EpcBypassNetDevice::GetIfIndex() const
+{
+    return m_ifIndex;
+}
+
+Ptr<Channel>
+EpcBypassNetDevice::GetChannel() const
+{
+    return nullptr;
+}
+
+void
+EpcBypassNetDevice::SetAddress(Address address)
+{
+    m_address = Mac48Address::ConvertFrom(address);
+}
+
+Address
+EpcBypassNetDevice::GetAddress() const
+{
+    return m_address;
+}
+
+bool
+EpcBypassNetDevice::SetMtu(const uint16_t mtu)
+{
+    m_mtu = mtu;
+    return true;
+}
+
+uint16_t
+EpcBypassNetDevice::GetMtu() const
+{
+    return m_mtu;
+}
+
+bool
+EpcBypassNetDevice::IsLinkUp() const
+{
+    return true;
+}
+
+void
+EpcBypassNetDevice::AddLinkChangeCallback(Callback<void> callback [[maybe_unused]])
+{
+}
+
+bool
+EpcBypassNetDevice::IsBroadcast() const
+{
+    return false;
+}
+
+Address
+EpcBypassNetDevice::GetBroadcast() const
+{
+    return Mac48Address::GetBroadcast();
+}
+
+bool
+EpcBypassNetDevice::IsMulticast() const
+{
+    return false;
+}
+
+Address
+EpcBypassNetDevice::GetMulticast(Ipv4Address multicastGroup [[maybe_unused]]) const
+{
+    return Mac48Address::GetMulticast(multicastGroup);
+}
+
+Address
+EpcBypassNetDevice::GetMulticast(Ipv6Address addr) const
+{
+    return Mac48Address::GetMulticast(addr);
+}
+
+bool
+EpcBypassNetDevice::IsBridge() const
+{
+    return false;
+}
+
+bool
+EpcBypassNetDevice::IsPointToPoint() const
+{
+    return true;
+}
+
+bool
+EpcBypassNetDevice::SendFrom(Ptr<Packet> packet,
+                             const Address& source [[maybe_unused]],
+                             const Address& dest,
+                             uint16_t protocolNumber)
+{
+    return Send(packet, dest, protocolNumber);
+}
+
+Ptr<Node>
+EpcBypassNetDevice::GetNode() const
+{
+    return m_node;
+}
+
+void
+EpcBypassNetDevice::SetNode(Ptr<Node> node)
+{
+    m_node = node;
+}
+
+bool
+EpcBypassNetDevice::NeedsArp() const
+{
+    return false;
+}
+
+void
+EpcBypassNetDevice::SetReceiveCallback(NetDevice::ReceiveCallback cb [[maybe_unused]])
+{
+    // Downlink only, nothing is received
+}
+
+void
+EpcBypassNetDevice::SetPromiscReceiveCallback(NetDevice::PromiscReceiveCallback cb [[maybe_unused]])
+{
+}
+
+bool
+EpcBypassNetDevice::SupportsSendFrom() const
+{
+    return false;
+}
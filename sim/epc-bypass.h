@@ -0,0 +1,84 @@
+#ifndef EPC_BYPASS_H
+#define EPC_BYPASS_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/nr-module.h"
+
+#include <map>
+
+using namespace ns3;
+
+/**
+ * Net device for the remote host that skips the EPC in downlink: the IPv4 packets it is given are
+ * delayed by a delay line (the Remote/Edge server delay) and handed to the RRC of the gNB that serves
+ * the destination UE, with the EpsBearerTag of its default bearer, so they go straight to PDCP/RLC.
+ *
+ * The uplink keeps using the EPC (the UE default route), so the remote host still needs its p2p link
+ * to the PGW, and the PGW a route back to the address of this device. Since both ends keep their IP
+ * stack, TCP and UDP behave as usual.
+ */
+class EpcBypassNetDevice : public NetDevice
+{
+public:
+    static TypeId GetTypeId();
+    EpcBypassNetDevice();
+    ~EpcBypassNetDevice() override;
+
+    /**
+     * @brief Registers a UE, the packets to ueAddress are sent to the gNB it is attached to
+     */
+    void AddUe(Ipv4Address ueAddress, Ptr<NrUeNetDevice> ueDevice);
+
+    // NetDevice
+    void SetIfIndex(const uint32_t index) override;
+    uint32_t GetIfIndex() const override;
+    Ptr<Channel> GetChannel() const override;
+    void SetAddress(Address address) override;
+    Address GetAddress() const override;
+    bool SetMtu(const uint16_t mtu) override;
+    uint16_t GetMtu() const override;
+    bool IsLinkUp() const override;
+    void AddLinkChangeCallback(Callback<void> callback) override;
+    bool IsBroadcast() const override;
+    Address GetBroadcast() const override;
+    bool IsMulticast() const override;
+    Address GetMulticast(Ipv4Address multicastGroup) const override;
+    Address GetMulticast(Ipv6Address addr) const override;
+    bool IsBridge() const override;
+    bool IsPointToPoint() const override;
+    bool Send(Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber) override;
+    bool SendFrom(Ptr<Packet> packet,
+                  const Address& source,
+                  const Address& dest,
+                  uint16_t protocolNumber) override;
+    Ptr<Node> GetNode() const override;
+    void SetNode(Ptr<Node> node) override;
+    bool NeedsArp() const override;
+    void SetReceiveCallback(NetDevice::ReceiveCallback cb) override;
+    void SetPromiscReceiveCallback(NetDevice::PromiscReceiveCallback cb) override;
+    bool SupportsSendFrom() const override;
+
+protected:
+    void DoDispose() override;
+
+private:
+    /**
+     * @brief End of the delay line, gives the packet to the gNB of the UE
+     */
+    void Deliver(Ptr<Packet> packet, Ipv4Address destination);
+
+    Ptr<Node> m_node;
+    uint32_t m_ifIndex;
+    uint16_t m_mtu;
+    Mac48Address m_address;
+    Time m_delay;               //!< Delay line (one way server delay)
+    uint8_t m_bearerId;         //!< EPS bearer id of the traffic (1: default bearer)
+    std::map<Ipv4Address, Ptr<NrUeNetDevice>> m_ues;
+
+    TracedCallback<Ptr<const Packet>> m_txTrace;
+    TracedCallback<Ptr<const Packet>> m_dropTrace;
+};
+
+#endif // EPC_BYPASS_H
@@ -0,0 +1,522 @@
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include "flow-probe.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("StreamingFlowProbe");
+
+NS_OBJECT_ENSURE_REGISTERED(StreamingFlowProbe);
+
+/**
+ * Byte tag with the flow id and the time the packet left its source. A byte tag (not a packet tag)
+ * so it follows the bytes through the RLC segmentation and concatenation, as Ipv4FlowProbeTag.
+ */
+class StreamingFlowProbeTag : public Tag
+{
+public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::StreamingFlowProbeTag")
+                                .SetParent<Tag>()
+                                .SetGroupName("MyAppComp")
+                                .AddConstructor<StreamingFlowProbeTag>();
+        return tid;
+    }
+
+    TypeId GetInstanceTypeId() const override
+    {
+        return GetTypeId();
+    }
+
+    uint32_t GetSerializedSize() const override
+    {
+        return 4 + 8;
+    }
+
+    void Serialize(TagBuffer buf) const override
+    {
+        buf.WriteU32(m_flowId);
+        buf.WriteU64(m_txTime);
+    }
+
+    void Deserialize(TagBuffer buf) override
+    {
+        m_flowId = buf.ReadU32();
+        m_txTime = buf.ReadU64();
+    }
+
+    void Print(std::ostream& os) const override
+    {
+        os << "FlowId=" << m_flowId << " TxTime=" << m_txTime;
+    }
+
+    uint32_t m_flowId{0};
+    uint64_t m_txTime{0};   //!< Time::GetTimeStep() of the transmission
+};
+
+NS_OBJECT_ENSURE_REGISTERED(StreamingFlowProbeTag);
+
+QuantileSketch::QuantileSketch(double minValue, double maxValue, double gamma)
+    : m_minValue(minValue),
+      m_logGamma(std::log(gamma)),
+      m_gamma(gamma),
+      m_count(0),
+      m_zeros(0),
+      m_buckets(static_cast<size_t>(std::ceil(std::log(maxValue / minValue) / std::log(gamma))) + 1, 0)
+{
+}
+
+void
+QuantileSketch::Add(double value)
+{
+    m_count++;
+    if (value < m_minValue)
+    {
+        m_zeros++;
+        return;
+    }
+    size_t idx = static_cast<size_t>(std::ceil(std::log(value / m_minValue) / m_logGamma));
+    m_buckets[std::min(idx, m_buckets.size() - 1)]++;
+}
+
+double
+QuantileSketch::Quantile(double q) const
+{
+    if (m_count == 0)
+    {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(q * (m_count - 1));
+    if (rank < m_zeros)
+    {
+        return 0;
+    }
+    uint64_t acc = m_zeros;
+    for (size_t i = 0; i < m_buckets.size(); ++i)
+    {
+        acc += m_buckets[i];
+        if (acc > rank)
+        {
+            // Middle of the bucket (minValue*gamma^(i-1), minValue*gamma^i]
+            return m_minValue * std::pow(m_gamma, i) * 2 / (1 + m_gamma);
+        }
+    }
+    return m_minValue * std::pow(m_gamma, m_buckets.size() - 1);
+}
+
+uint64_t
+QuantileSketch::GetCount() const
+{
+    return m_count;
+}
+
+void
+QuantileSketch::Merge(const QuantileSketch& other)
+{
+    NS_ABORT_MSG_IF(other.m_buckets.size() != m_buckets.size(), "Sketches with different buckets");
+    m_count += other.m_count;
+    m_zeros += other.m_zeros;
+    for (size_t i = 0; i < m_buckets.size(); ++i)
+    {
+        m_buckets[i] += other.m_buckets[i];
+    }
+}
+
+void
+QuantileSketch::Save(std::ostream& os) const
+{
+    os << m_count << " " << m_zeros << " " << m_buckets.size();
+    for (uint64_t b : m_buckets)
+    {
+        os << " " << b;
+    }
+}
+
+void
+QuantileSketch::Load(std::istream& is)
+{
+    size_t n = 0;
+    is >> m_count >> m_zeros >> n;
+    NS_ABORT_MSG_IF(n != m_buckets.size(), "Sketches with different buckets");
+    for (uint64_t& b : m_buckets)
+    {
+        is >> b;
+    }
+}
+
+StreamingFlowProbe::StreamingFlowProbe()
+    : m_interval(MilliSeconds(100)),
+      m_fiveTupleRx(false)
+{
+}
+
+StreamingFlowProbe::~StreamingFlowProbe()
+{
+}
+
+TypeId
+StreamingFlowProbe::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::StreamingFlowProbe")
+            .SetParent<Object>()
+            .SetGroupName("MyAppComp")
+            .AddConstructor<StreamingFlowProbe>()
+            .AddAttribute("Interval",
+                          "Bin width of the per flow throughput time series",
+                          TimeValue(MilliSeconds(100)),
+                          MakeTimeAccessor(&StreamingFlowProbe::m_interval),
+                          MakeTimeChecker(NanoSeconds(1)))
+            .AddAttribute("FiveTupleRx",
+                          "Match the received packets to the flows by five tuple instead of the flow id "
+                          "of the tag (the sender may be in another process)",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&StreamingFlowProbe::m_fiveTupleRx),
+                          MakeBooleanChecker());
+    return tid;
+}
+
+void
+StreamingFlowProbe::Install(NodeContainer nodes)
+{
+    for (uint32_t i = 0; i < nodes.GetN(); ++i)
+    {
+        Ptr<Ipv4L3Protocol> ipv4 = nodes.Get(i)->GetObject<Ipv4L3Protocol>();
+        NS_ABORT_MSG_IF(!ipv4, "Node " << nodes.Get(i)->GetId() << " has no IPv4 stack");
+        ipv4->TraceConnectWithoutContext("SendOutgoing",
+                                         MakeCallback(&StreamingFlowProbe::SendOutgoing, this));
+        ipv4->TraceConnectWithoutContext("LocalDeliver",
+                                         MakeCallback(&StreamingFlowProbe::LocalDeliver, this));
+    }
+}
+
+StreamingFlowProbe::FiveTuple
+StreamingFlowProbe::Classify(const Ipv4Header& header, Ptr<const Packet> packet)
+{
+    uint16_t srcPort = 0;
+    uint16_t dstPort = 0;
+    uint8_t protocol = header.GetProtocol();
+    if ((protocol == UdpL4Protocol::PROT_NUMBER || protocol == TcpL4Protocol::PROT_NUMBER) &&
+        packet->GetSize() >= 4)
+    {
+        // Both UDP and TCP headers start with the source and destination ports
+        uint8_t ports[4];
+        packet->CopyData(ports, 4);
+        srcPort = (ports[0] << 8) | ports[1];
+        dstPort = (ports[2] << 8) | ports[3];
+    }
+    return FiveTuple(protocol,
+                     header.GetSource().Get(),
+                     header.GetDestination().Get(),
+                     srcPort,
+                     dstPort);
+}
+
+void
+StreamingFlowProbe::SendOutgoing(const Ipv4Header& header, Ptr<const Packet> packet, uint32_t interface [[maybe_unused]])
+{
+    FiveTuple tuple = Classify(header, packet);
+    auto [it, isNew] = m_flowIds.emplace(tuple, m_flows.size());
+    if (isNew)
+    {
+        m_flows.emplace_back();
+        m_tuples.push_back(tuple);
+        m_tcpUdpFlows.clear();
+    }
+
+    Time now = Simulator::Now();
+    FlowStats& flow = m_flows[it->second];
+    flow.txPackets++;
+    flow.txBytes += packet->GetSize() + header.GetSerializedSize();
+    flow.firstTx = std::min(flow.firstTx, now);
+    flow.lastTx = now;
+
+    StreamingFlowProbeTag tag;
+    tag.m_flowId = it->second;
+    tag.m_txTime = now.GetTimeStep();
+    packet->AddByteTag(tag);
+}
+
+void
+StreamingFlowProbe::LocalDeliver(const Ipv4Header& header, Ptr<const Packet> packet, uint32_t interface [[maybe_unused]])
+{
+    StreamingFlowProbeTag tag;
+    if (!packet->FindFirstMatchingByteTag(tag))
+    {
+        return;
+    }
+
+    uint32_t id = tag.m_flowId;
+    if (m_fiveTupleRx)
+    {
+        FiveTuple tuple = Classify(header, packet);
+        auto [it, isNew] = m_flowIds.emplace(tuple, m_flows.size());
+        if (isNew)
+        {
+            m_flows.emplace_back();
+            m_tuples.push_back(tuple);
+            m_tcpUdpFlows.clear();
+        }
+        id = it->second;
+    }
+    else if (id >= m_flows.size())
+    {
+        return;
+    }
+
+    Time now = Simulator::Now();
+    Time delay = now - Time(tag.m_txTime);
+    FlowStats& flow = m_flows[id];
+
+    if (flow.rxPackets > 0)
+    {
+        Time jitter = Abs(delay - flow.lastDelay);
+        flow.jitter.Add(jitter.GetSeconds());
+        flow.jitterSum += jitter;
+    }
+    flow.delay.Add(delay.GetSeconds());
+    flow.delaySum += delay;
+    flow.lastDelay = delay;
+
+    uint32_t size = packet->GetSize() + header.GetSerializedSize();
+    flow.rxPackets++;
+    flow.rxBytes += size;
+    flow.firstRx = std::min(flow.firstRx, now);
+    flow.lastRx = now;
+
+    size_t bin = static_cast<size_t>(now.GetTimeStep() / m_interval.GetTimeStep());
+    if (bin >= flow.rxBytesPerInterval.size())
+    {
+        flow.rxBytesPerInterval.resize(bin + 1, 0);
+    }
+    flow.rxBytesPerInterval[bin] += size;
+}
+
+void
+StreamingFlowProbe::WriteJson(std::string filename) const
+{
+    std::ofstream out(filename, std::ofstream::out | std::ofstream::trunc);
+    if (!out.is_open())
+    {
+        std::cerr << "Can't open file " << filename << std::endl;
+        return;
+    }
+
+    auto secs = [](Time t) { return t == Time::Max() ? -1.0 : t.GetSeconds(); };
+
+    // ns resolution, the default 6 significant digits lose the sub ms part of the times
+    out << std::fixed << std::setprecision(9);
+    out << "{\"interval\": " << m_interval.GetSeconds() << ", \"flows\": [";
+    std::vector<uint32_t> order = GetFlowOrder();
+    for (size_t id = 0; id < order.size(); ++id)
+    {
+        const FlowStats& f = m_flows[order[id]];
+        auto [protocol, src, dst, srcPort, dstPort] = m_tuples[order[id]];
+
+        out << (id ? ",\n" : "\n") << "{\"id\": " << id
+            << ", \"proto\": " << +protocol
+            << ", \"src\": \"" << Ipv4Address(src) << ":" << srcPort << "\""
+            << ", \"dst\": \"" << Ipv4Address(dst) << ":" << dstPort << "\""
+            << ", \"txPackets\": " << f.txPackets << ", \"txBytes\": " << f.txBytes
+            << ", \"rxPackets\": " << f.rxPackets << ", \"rxBytes\": " << f.rxBytes
+            << ", \"firstTx\": " << secs(f.firstTx) << ", \"lastTx\": " << f.lastTx.GetSeconds()
+            << ", \"firstRx\": " << secs(f.firstRx) << ", \"lastRx\": " << f.lastRx.GetSeconds()
+            << ", \"delay\": {\"p50\": " << f.delay.Quantile(0.5) << ", \"p95\": "
+            << f.delay.Quantile(0.95) << ", \"p99\": " << f.delay.Quantile(0.99) << "}"
+            << ", \"jitter\": {\"p50\": " << f.jitter.Quantile(0.5) << ", \"p95\": "
+            << f.jitter.Quantile(0.95) << ", \"p99\": " << f.jitter.Quantile(0.99) << "}"
+            << ", \"rxBytesPerInterval\": [";
+        for (size_t i = 0; i < f.rxBytesPerInterval.size(); ++i)
+        {
+            out << (i ? "," : "") << f.rxBytesPerInterval[i];
+        }
+        out << "]}";
+    }
+    out << "\n]}\n";
+}
+
+std::string
+StreamingFlowProbe::Save() const
+{
+    std::ostringstream os;
+    os << m_flows.size() << "\n";
+    for (size_t id = 0; id < m_flows.size(); ++id)
+    {
+        const FlowStats& f = m_flows[id];
+        auto [protocol, src, dst, srcPort, dstPort] = m_tuples[id];
+
+        os << +protocol << " " << src << " " << dst << " " << srcPort << " " << dstPort << " "
+           << f.txPackets << " " << f.txBytes << " " << f.rxPackets << " " << f.rxBytes << " "
+           << f.firstTx.GetTimeStep() << " " << f.lastTx.GetTimeStep() << " "
+           << f.firstRx.GetTimeStep() << " " << f.lastRx.GetTimeStep() << " "
+           << f.lastDelay.GetTimeStep() << " " << f.delaySum.GetTimeStep() << " "
+           << f.jitterSum.GetTimeStep() << " ";
+        f.delay.Save(os);
+        os << " ";
+        f.jitter.Save(os);
+        os << " " << f.rxBytesPerInterval.size();
+        for (uint64_t bytes : f.rxBytesPerInterval)
+        {
+            os << " " << bytes;
+        }
+        os << "\n";
+    }
+    return os.str();
+}
+
+void
+StreamingFlowProbe::Merge(const std::string& saved)
+{
+    m_tcpUdpFlows.clear();  // The first tx of the flows can change
+    std::istringstream is(saved);
+    uint32_t n = 0;
+    is >> n;
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        uint32_t protocol = 0;
+        uint32_t src = 0;
+        uint32_t dst = 0;
+        uint16_t srcPort = 0;
+        uint16_t dstPort = 0;
+        int64_t times[7];
+        FlowStats other;
+        size_t intervals = 0;
+
+        is >> protocol >> src >> dst >> srcPort >> dstPort >> other.txPackets >> other.txBytes
+            >> other.rxPackets >> other.rxBytes;
+        for (int64_t& t : times)
+        {
+            is >> t;
+        }
+        other.firstTx = Time(times[0]);
+        other.lastTx = Time(times[1]);
+        other.firstRx = Time(times[2]);
+        other.lastRx = Time(times[3]);
+        other.lastDelay = Time(times[4]);
+        other.delaySum = Time(times[5]);
+        other.jitterSum = Time(times[6]);
+        other.delay.Load(is);
+        other.jitter.Load(is);
+        is >> intervals;
+        other.rxBytesPerInterval.resize(intervals);
+        for (uint64_t& bytes : other.rxBytesPerInterval)
+        {
+            is >> bytes;
+        }
+        NS_ABORT_MSG_IF(!is, "Malformed flow " << i << " of the saved probe");
+
+        FiveTuple tuple(protocol, src, dst, srcPort, dstPort);
+        auto [it, isNew] = m_flowIds.emplace(tuple, m_flows.size());
+        if (isNew)
+        {
+            m_flows.push_back(other);
+            m_tuples.push_back(tuple);
+            continue;
+        }
+
+        // The tx of a flow is in one process and its rx in the other
+        FlowStats& flow = m_flows[it->second];
+        if (other.lastRx > flow.lastRx)
+        {
+            flow.lastDelay = other.lastDelay;
+        }
+        flow.txPackets += other.txPackets;
+        flow.txBytes += other.txBytes;
+        flow.rxPackets += other.rxPackets;
+        flow.rxBytes += other.rxBytes;
+        flow.firstTx = std::min(flow.firstTx, other.firstTx);
+        flow.lastTx = std::max(flow.lastTx, other.lastTx);
+        flow.firstRx = std::min(flow.firstRx, other.firstRx);
+        flow.lastRx = std::max(flow.lastRx, other.lastRx);
+        flow.delaySum += other.delaySum;
+        flow.jitterSum += other.jitterSum;
+        flow.delay.Merge(other.delay);
+        flow.jitter.Merge(other.jitter);
+        if (other.rxBytesPerInterval.size() > flow.rxBytesPerInterval.size())
+        {
+            flow.rxBytesPerInterval.resize(other.rxBytesPerInterval.size(), 0);
+        }
+        for (size_t b = 0; b < other.rxBytesPerInterval.size(); ++b)
+        {
+            flow.rxBytesPerInterval[b] += other.rxBytesPerInterval[b];
+        }
+    }
+}
+
+std::vector<uint32_t>
+StreamingFlowProbe::GetFlowOrder() const
+{
+    // The internal ids follow the order of the SendOutgoing events, that differs between processes
+    // when two flows start in the same ns: (first tx, five tuple) is the same in any run
+    std::vector<uint32_t> order(m_flows.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return std::tie(m_flows[a].firstTx, m_tuples[a]) < std::tie(m_flows[b].firstTx, m_tuples[b]);
+    });
+    return order;
+}
+
+const std::vector<uint32_t>&
+StreamingFlowProbe::GetTcpUdpFlows() const
+{
+    // Sorted again only after a new flow or a Merge, FindFlow is called once per flow
+    if (m_tcpUdpFlows.empty())
+    {
+        for (uint32_t id : GetFlowOrder())
+        {
+            uint8_t protocol = std::get<0>(m_tuples[id]);
+            if (protocol == TcpL4Protocol::PROT_NUMBER || protocol == UdpL4Protocol::PROT_NUMBER)
+            {
+                m_tcpUdpFlows.push_back(id);
+            }
+        }
+    }
+    return m_tcpUdpFlows;
+}
+
+FlowMonitor::FlowStatsContainer
+StreamingFlowProbe::GetFlowMonitorStats() const
+{
+    FlowMonitor::FlowStatsContainer stats;
+    FlowId flowId = 1;
+    for (uint32_t id : GetTcpUdpFlows())
+    {
+        const FlowStats& f = m_flows[id];
+        FlowMonitor::FlowStats& s = stats[flowId++];
+        s.timeFirstTxPacket = f.firstTx;
+        s.timeLastTxPacket = f.lastTx;
+        s.timeFirstRxPacket = f.firstRx;
+        s.timeLastRxPacket = f.lastRx;
+        s.delaySum = f.delaySum;
+        s.jitterSum = f.jitterSum;
+        s.lastDelay = f.lastDelay;
+        s.txBytes = f.txBytes;
+        s.rxBytes = f.rxBytes;
+        s.txPackets = f.txPackets;
+        s.rxPackets = f.rxPackets;
+    }
+    return stats;
+}
+
+Ipv4FlowClassifier::FiveTuple
+StreamingFlowProbe::FindFlow(FlowId flowId) const
+{
+    auto [protocol, src, dst, srcPort, dstPort] = m_tuples.at(GetTcpUdpFlows().at(flowId - 1));
+    Ipv4FlowClassifier::FiveTuple t;
+    t.protocol = protocol;
+    t.sourceAddress = Ipv4Address(src);
+    t.destinationAddress = Ipv4Address(dst);
+    t.sourcePort = srcPort;
+    t.destinationPort = dstPort;
+    return t;
+}
@@ -0,0 +1,152 @@
+#ifndef FLOW_PROBE_H
+#define FLOW_PROBE_H
+
+#include "ns3/core-module.h"
+#include "ns3/flow-monitor-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Fixed memory quantile sketch. Values are stored in logarithmic buckets, so every quantile has a
+ * relative error below (gamma - 1) / 2 (1% by default), whatever the number of samples.
+ * Values outside [minValue, maxValue] are clamped to the first/last bucket.
+ */
+class QuantileSketch
+{
+public:
+    QuantileSketch(double minValue = 1e-6, double maxValue = 100, double gamma = 1.02);
+
+    void Add(double value);
+
+    /**
+     * @param q Quantile in [0, 1]
+     * @return The value of the quantile, 0 if the sketch is empty
+     */
+    double Quantile(double q) const;
+
+    uint64_t GetCount() const;
+
+    /**
+     * @brief Adds the samples of other (same minValue, maxValue and gamma)
+     */
+    void Merge(const QuantileSketch& other);
+
+    void Save(std::ostream& os) const;
+    void Load(std::istream& is);
+
+private:
+    double m_minValue;
+    double m_logGamma;
+    double m_gamma;
+    uint64_t m_count;
+    uint64_t m_zeros;               //!< Samples below minValue
+    std::vector<uint64_t> m_buckets;
+};
+
+/**
+ * Light per flow probe, an alternative to the FlowMonitor histograms. It tags (byte tag) the packets
+ * sent by the endpoints (Ipv4L3Protocol SendOutgoing) and, when they are delivered (LocalDeliver), keeps per
+ * flow:
+ *  - tx/rx packets and bytes and the time of the first/last tx and rx packet
+ *  - quantile sketches of the delay and jitter (p50, p95, p99 are written)
+ *  - received bytes per interval (throughput time series)
+ *
+ * Results are written as JSON (FlowProbe.json by default), and GetFlowMonitorStats gives the counts
+ * and sums of FlowOutput.txt, so no FlowMonitor has to be installed next to it.
+ *
+ * In the distributed mode the source and the destination of a flow are in different processes: with
+ * FiveTupleRx the received packets are matched to the flows by five tuple (the tag only gives the tx
+ * time), and the server rank sends its half (Save) to the RAN rank, that adds it (Merge).
+ */
+class StreamingFlowProbe : public Object
+{
+public:
+    StreamingFlowProbe();
+    ~StreamingFlowProbe() override;
+    static TypeId GetTypeId();
+
+    /**
+     * @brief Connects the probe to the IPv4 stack of every node (they must be the flows endpoints)
+     */
+    void Install(NodeContainer nodes);
+
+    /**
+     * @brief Writes the results of every flow
+     */
+    void WriteJson(std::string filename) const;
+
+    /**
+     * @return The stats of every flow, to be added by the probe of another process with Merge
+     */
+    std::string Save() const;
+
+    /**
+     * @brief Adds the stats saved by another probe
+     */
+    void Merge(const std::string& saved);
+
+    /**
+     * @return The TCP and UDP flows as the FlowMonitor counts them (ids from 1 in order of first tx,
+     * ties by five tuple), to write FlowOutput.txt without a FlowMonitor
+     */
+    FlowMonitor::FlowStatsContainer GetFlowMonitorStats() const;
+
+    /**
+     * @return Five tuple of a flow id of GetFlowMonitorStats
+     */
+    Ipv4FlowClassifier::FiveTuple FindFlow(FlowId flowId) const;
+
+private:
+    /** Protocol, source address, destination address, source port, destination port */
+    typedef std::tuple<uint8_t, uint32_t, uint32_t, uint16_t, uint16_t> FiveTuple;
+
+    struct FlowStats
+    {
+        uint64_t txPackets{0};
+        uint64_t txBytes{0};
+        uint64_t rxPackets{0};
+        uint64_t rxBytes{0};
+        Time firstTx{Time::Max()};
+        Time lastTx{0};
+        Time firstRx{Time::Max()};
+        Time lastRx{0};
+        Time lastDelay{0};
+        Time delaySum{0};
+        Time jitterSum{0};
+        QuantileSketch delay;
+        QuantileSketch jitter;
+        std::vector<uint64_t> rxBytesPerInterval;
+    };
+
+    void SendOutgoing(const Ipv4Header& header, Ptr<const Packet> packet, uint32_t interface);
+    void LocalDeliver(const Ipv4Header& header, Ptr<const Packet> packet, uint32_t interface);
+
+    static FiveTuple Classify(const Ipv4Header& header, Ptr<const Packet> packet);
+
+    /**
+     * @return Ids of every flow by first tx and five tuple, the order of the ids that are written
+     */
+    std::vector<uint32_t> GetFlowOrder() const;
+
+    /**
+     * @return Ids of the TCP and UDP flows, in the order of GetFlowOrder
+     */
+    const std::vector<uint32_t>& GetTcpUdpFlows() const;
+
+    std::map<FiveTuple, uint32_t> m_flowIds;    //!< Flow id by five tuple
+    std::vector<FlowStats> m_flows;             //!< Stats by flow id
+    std::vector<FiveTuple> m_tuples;            //!< Five tuple by flow id
+    mutable std::vector<uint32_t> m_tcpUdpFlows; //!< Cache of GetTcpUdpFlows, empty when outdated
+    Time m_interval;                            //!< Bin width of the throughput time series
+    bool m_fiveTupleRx;                         //!< Attribute FiveTupleRx
+};
+
+#endif // FLOW_PROBE_H
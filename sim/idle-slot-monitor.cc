@@ -0,0 +1,207 @@
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/nr-module.h"
+
+#include "idle-slot-monitor.h"
+#include "cmdline-colors.h"
+
+#include <fstream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("IdleSlotMonitor");
+
+NS_OBJECT_ENSURE_REGISTERED(IdleSlotMonitor);
+
+TypeId
+IdleSlotMonitor::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::IdleSlotMonitor")
+            .SetParent<Object>()
+            .SetGroupName("MyAppComp")
+            .AddConstructor<IdleSlotMonitor>()
+            .AddAttribute("IdleSlots",
+                          "Consecutive slots without a scheduled UE for a PHY to be considered idle "
+                          "(covers HARQ retransmissions and periodic CQI/SRS)",
+                          UintegerValue(80),
+                          MakeUintegerAccessor(&IdleSlotMonitor::m_idleThreshold),
+                          MakeUintegerChecker<uint32_t>(1));
+    return tid;
+}
+
+IdleSlotMonitor::IdleSlotMonitor()
+    : m_idleThreshold(80),
+      m_simEnd(Seconds(0)),
+      m_slots(0),
+      m_idle(0),
+      m_skippable(0),
+      m_skipped(0),
+      m_finished(false)
+{
+}
+
+IdleSlotMonitor::~IdleSlotMonitor()
+{
+}
+
+void
+IdleSlotMonitor::Install(NetDeviceContainer gnbDevs)
+{
+    for (auto it = gnbDevs.Begin(); it != gnbDevs.End(); ++it)
+    {
+        Ptr<NrGnbNetDevice> gnbDev = DynamicCast<NrGnbNetDevice>(*it);
+        NS_ABORT_MSG_IF(!gnbDev, "IdleSlotMonitor needs NrGnbNetDevices");
+        for (uint32_t bwp = 0; bwp < gnbDev->GetCcMapSize(); ++bwp)
+        {
+            Ptr<NrGnbPhy> phy = gnbDev->GetPhy(bwp);
+            PhyState state;
+            state.slot = phy->GetSlotPeriod();
+            state.lastBusy = -state.slot;
+            state.busy = 0;
+            m_phys[(static_cast<uint32_t>(phy->GetCellId()) << 16) | phy->GetBwpId()] = state;
+
+            phy->TraceConnectWithoutContext("SlotDataStats",
+                                            MakeCallback(&IdleSlotMonitor::SlotData, this));
+        }
+    }
+}
+
+void
+IdleSlotMonitor::SetTrafficEnd(Time trafficEnd, Time simEnd)
+{
+    m_simEnd = simEnd;
+    if (trafficEnd < simEnd)
+    {
+        Simulator::Schedule(trafficEnd, &IdleSlotMonitor::CheckIdle, this);
+    }
+}
+
+void
+IdleSlotMonitor::SlotData(const SfnSf& sfn,
+                          uint32_t scheduledUe,
+                          uint32_t usedReg,
+                          uint32_t usedSym,
+                          uint32_t availableRb,
+                          uint32_t availableSym,
+                          uint16_t bwpId,
+                          uint16_t cellId)
+{
+    if (scheduledUe == 0)
+    {
+        return;
+    }
+
+    auto it = m_phys.find((static_cast<uint32_t>(cellId) << 16) | bwpId);
+    if (it == m_phys.end())
+    {
+        return;
+    }
+    PhyState& state = it->second;
+    Time now = Simulator::Now();
+    if (now == state.lastBusy)
+    {
+        return; // DL and UL of the same slot
+    }
+    CloseIdleRun(state, now);
+    state.lastBusy = now;
+    state.busy++;
+}
+
+void
+IdleSlotMonitor::CloseIdleRun(PhyState& state, Time now)
+{
+    int64_t gap = (now - state.lastBusy).GetTimeStep() / state.slot.GetTimeStep() - 1;
+    if (gap <= 0)
+    {
+        return;
+    }
+    m_idle += gap;
+    if (gap > m_idleThreshold)
+    {
+        m_skippable += gap - m_idleThreshold;
+    }
+}
+
+void
+IdleSlotMonitor::CheckIdle()
+{
+    Time now = Simulator::Now();
+    Time wait = Seconds(0);
+    for (const auto& phy : m_phys)
+    {
+        Time idleFor = now - phy.second.lastBusy;
+        Time needed = phy.second.slot * m_idleThreshold;
+        if (idleFor < needed)
+        {
+            wait = std::max(wait, needed - idleFor);
+        }
+    }
+
+    if (!wait.IsZero())
+    {
+        Simulator::Schedule(wait, &IdleSlotMonitor::CheckIdle, this);
+        return;
+    }
+
+    for (const auto& phy : m_phys)
+    {
+        m_skipped += (m_simEnd - now).GetTimeStep() / phy.second.slot.GetTimeStep();
+    }
+    NS_LOG_INFO("Every gNB idle since the traffic end, stopping at " << now.GetSeconds() << " s");
+    Simulator::Stop();
+}
+
+void
+IdleSlotMonitor::Finish()
+{
+    if (m_finished)
+    {
+        return;
+    }
+    m_finished = true;
+
+    Time now = Simulator::Now();
+    for (auto& phy : m_phys)
+    {
+        m_slots += now.GetTimeStep() / phy.second.slot.GetTimeStep();
+        CloseIdleRun(phy.second, now);
+    }
+}
+
+void
+IdleSlotMonitor::WriteSummary(std::string filename) const
+{
+    std::ofstream out(filename);
+    out << "slots " << m_slots << std::endl;
+    out << "idle " << m_idle << std::endl;
+    out << "skippable " << m_skippable << std::endl;
+    out << "skipped " << m_skipped << std::endl;
+
+    std::cout << TXT_CYAN << "Slots: " << m_slots << " (" << m_idle << " idle, " << m_skippable
+              << " skippable), skipped at the end: " << m_skipped << TXT_CLEAR << std::endl;
+}
+
+uint64_t
+IdleSlotMonitor::GetSlots() const
+{
+    return m_slots;
+}
+
+uint64_t
+IdleSlotMonitor::GetIdleSlots() const
+{
+    return m_idle;
+}
+
+uint64_t
+IdleSlotMonitor::GetSkippableSlots() const
+{
+    return m_skippable;
+}
+
+uint64_t
+IdleSlotMonitor::GetSkippedSlots() const
+{
+    return m_skipped;
+}
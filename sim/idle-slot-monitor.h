@@ -0,0 +1,100 @@
+#ifndef IDLE_SLOT_MONITOR_H
+#define IDLE_SLOT_MONITOR_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/nr-module.h"
+
+#include <map>
+
+using namespace ns3;
+
+/**
+ * Detects the slots in which a gNB PHY has nothing to do (no UE scheduled in DL or UL, so no BSR
+ * served, empty DL queues and no HARQ retransmission) and, when the traffic is over, stops the
+ * simulation early: once every PHY has been idle for IdleSlots slots after the traffic end, the
+ * simulation is stopped instead of running empty slots until simTime. Idle slots before the traffic
+ * end are only counted, they are still run: skipping them would need the slot loop of NrGnbPhy
+ * (StartSlot rescheduling itself every slot) to be suspended and restarted at the next pending
+ * event, and that source is not among the patched copies of to_replace_in_src.
+ *
+ * Busy slots come from the SlotDataStats trace, idle slots are the gaps between them, so the
+ * monitor adds no event per slot. Counters:
+ *  - slots: slots run by every PHY
+ *  - idle: slots without a scheduled UE
+ *  - skippable: idle slots after the first IdleSlots of an idle run, the slots a PHY able to skip
+ *    ahead could elide (prologue before the apps, gaps of bursty traffic); they are not skipped
+ *  - skipped: slots not run because the simulation ended early
+ */
+class IdleSlotMonitor : public Object
+{
+public:
+    static TypeId GetTypeId();
+    IdleSlotMonitor();
+    ~IdleSlotMonitor() override;
+
+    /**
+     * @brief Connects to the SlotDataStats trace of every BWP of the gNBs
+     */
+    void Install(NetDeviceContainer gnbDevs);
+
+    /**
+     * @brief Enables the early stop
+     * @param trafficEnd Time after which no application sends
+     * @param simEnd Time of Simulator::Stop
+     */
+    void SetTrafficEnd(Time trafficEnd, Time simEnd);
+
+    /**
+     * @brief Closes the open idle runs, call it after Simulator::Run()
+     */
+    void Finish();
+
+    /**
+     * @brief Writes the counters (one "name value" per line) and prints them
+     */
+    void WriteSummary(std::string filename) const;
+
+    uint64_t GetSlots() const;
+    uint64_t GetIdleSlots() const;
+    uint64_t GetSkippableSlots() const;
+    uint64_t GetSkippedSlots() const;
+
+private:
+    struct PhyState
+    {
+        Time slot;          //!< Slot duration
+        Time lastBusy;      //!< Start of the last busy slot, -slot if none
+        uint64_t busy;
+    };
+
+    void SlotData(const SfnSf& sfn,
+                  uint32_t scheduledUe,
+                  uint32_t usedReg,
+                  uint32_t usedSym,
+                  uint32_t availableRb,
+                  uint32_t availableSym,
+                  uint16_t bwpId,
+                  uint16_t cellId);
+
+    /**
+     * @brief Accounts the idle slots between the last busy slot of a PHY and now
+     */
+    void CloseIdleRun(PhyState& state, Time now);
+
+    /**
+     * @brief Stops the simulation if every PHY is idle, if not checks again later
+     */
+    void CheckIdle();
+
+    uint32_t m_idleThreshold;   //!< Attribute IdleSlots
+    std::map<uint32_t, PhyState> m_phys;    //!< Key: cellId << 16 | bwpId
+    Time m_simEnd;
+    uint64_t m_slots;
+    uint64_t m_idle;
+    uint64_t m_skippable;
+    uint64_t m_skipped;
+    bool m_finished;
+};
+
+#endif // IDLE_SLOT_MONITOR_H
@@ -0,0 +1,350 @@
+#include "ns3/core-module.h"
+#include "ns3/nr-module.h"
+
+#include "mac-scheduler-profiler.h"
+#include "cmdline-colors.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("ProfiledMacSchedulerTdmaRR");
+
+NS_OBJECT_ENSURE_REGISTERED(ProfiledMacSchedulerTdmaRR);
+
+void
+WallTimeHistogram::Add(uint64_t ns)
+{
+    uint32_t bucket = 0;
+    for (uint64_t v = ns; v > 0; v >>= 1)
+    {
+        bucket++;
+    }
+    m_buckets[std::min(bucket, N_BUCKETS - 1)]++;
+    m_count++;
+    m_sum += ns;
+    m_max = std::max(m_max, ns);
+}
+
+uint64_t
+WallTimeHistogram::GetCount() const
+{
+    return m_count;
+}
+
+double
+WallTimeHistogram::GetMean() const
+{
+    return m_count > 0 ? static_cast<double>(m_sum) / m_count : 0;
+}
+
+uint64_t
+WallTimeHistogram::GetMax() const
+{
+    return m_max;
+}
+
+uint64_t
+WallTimeHistogram::GetQuantile(double q) const
+{
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < N_BUCKETS; ++i)
+    {
+        seen += m_buckets[i];
+        if (seen > 0 && seen >= q * m_count)
+        {
+            return std::min(m_max, i == 0 ? 0 : (uint64_t(1) << i) - 1);
+        }
+    }
+    return m_max;
+}
+
+uint64_t
+WallTimeHistogram::GetBucket(uint32_t i) const
+{
+    return m_buckets.at(i);
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+std::array<WallTimeHistogram, ProfiledMacSchedulerTdmaRR::N_PHASES> ProfiledMacSchedulerTdmaRR::s_profile;
+
+const std::array<std::string, ProfiledMacSchedulerTdmaRR::N_PHASES> ProfiledMacSchedulerTdmaRR::s_names = {
+    "dl", "dlSort", "dlAssign", "dlDci", "dlActiveUes", "dlLcg",
+    "ul", "ulSort", "ulAssign", "ulDci", "ulActiveUes", "ulLcg"};
+
+TypeId
+ProfiledMacSchedulerTdmaRR::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::ProfiledMacSchedulerTdmaRR")
+                            .SetParent<NrMacSchedulerTdmaRR>()
+                            .SetGroupName("MyAppComp")
+                            .AddConstructor<ProfiledMacSchedulerTdmaRR>()
+                            .AddAttribute("FastAssignment",
+                                          "Assign the RBGs with the UE list and single UE fast path of this "
+                                          "class instead of NrMacSchedulerTdma",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&ProfiledMacSchedulerTdmaRR::m_fastAssignment),
+                                          MakeBooleanChecker());
+    return tid;
+}
+
+ProfiledMacSchedulerTdmaRR::ProfiledMacSchedulerTdmaRR()
+    : m_fastAssignment(false),
+      m_sortNs(0),
+      m_dciNs(0)
+{
+}
+
+ProfiledMacSchedulerTdmaRR::~ProfiledMacSchedulerTdmaRR()
+{
+}
+
+uint64_t
+ProfiledMacSchedulerTdmaRR::Since(Clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+void
+ProfiledMacSchedulerTdmaRR::DoSchedDlTriggerReq(const NrMacSchedSapProvider::SchedDlTriggerReqParameters& params)
+{
+    m_dciNs = 0;
+    auto start = Clock::now();
+    NrMacSchedulerTdmaRR::DoSchedDlTriggerReq(params);
+    s_profile[DL].Add(Since(start));
+    s_profile[DL_DCI].Add(m_dciNs);
+}
+
+void
+ProfiledMacSchedulerTdmaRR::DoSchedUlTriggerReq(const NrMacSchedSapProvider::SchedUlTriggerReqParameters& params)
+{
+    m_dciNs = 0;
+    auto start = Clock::now();
+    NrMacSchedulerTdmaRR::DoSchedUlTriggerReq(params);
+    s_profile[UL].Add(Since(start));
+    s_profile[UL_DCI].Add(m_dciNs);
+}
+
+void
+ProfiledMacSchedulerTdmaRR::DoSchedDlRlcBufferReq(const NrMacSchedSapProvider::SchedDlRlcBufferReqParameters& params)
+{
+    auto start = Clock::now();
+    NrMacSchedulerTdmaRR::DoSchedDlRlcBufferReq(params);
+    s_profile[DL_LCG].Add(Since(start));
+}
+
+void
+ProfiledMacSchedulerTdmaRR::DoSchedUlMacCtrlInfoReq(const NrMacSchedSapProvider::SchedUlMacCtrlInfoReqParameters& params)
+{
+    auto start = Clock::now();
+    NrMacSchedulerTdmaRR::DoSchedUlMacCtrlInfoReq(params);
+    s_profile[UL_LCG].Add(Since(start));
+}
+
+NrMacSchedulerNs3::BeamSymbolMap
+ProfiledMacSchedulerTdmaRR::AssignDLRBG(uint32_t symAvail, const ActiveUeMap& activeDl) const
+{
+    uint64_t ues = 0;
+    for (const auto& beam : activeDl)
+    {
+        ues += beam.second.size();
+    }
+    s_profile[DL_ACTIVE_UES].Add(ues);
+
+    m_sortNs = 0;
+    auto start = Clock::now();
+    BeamSymbolMap ret = m_fastAssignment ? FastAssignRBG(symAvail, activeDl, true)
+                                         : NrMacSchedulerTdmaRR::AssignDLRBG(symAvail, activeDl);
+    uint64_t total = Since(start);
+    s_profile[DL_SORT].Add(m_sortNs);
+    s_profile[DL_ASSIGN].Add(total - std::min(total, m_sortNs));
+    return ret;
+}
+
+NrMacSchedulerNs3::BeamSymbolMap
+ProfiledMacSchedulerTdmaRR::AssignULRBG(uint32_t symAvail, const ActiveUeMap& activeUl) const
+{
+    uint64_t ues = 0;
+    for (const auto& beam : activeUl)
+    {
+        ues += beam.second.size();
+    }
+    s_profile[UL_ACTIVE_UES].Add(ues);
+
+    m_sortNs = 0;
+    auto start = Clock::now();
+    BeamSymbolMap ret = m_fastAssignment ? FastAssignRBG(symAvail, activeUl, false)
+                                         : NrMacSchedulerTdmaRR::AssignULRBG(symAvail, activeUl);
+    uint64_t total = Since(start);
+    s_profile[UL_SORT].Add(m_sortNs);
+    s_profile[UL_ASSIGN].Add(total - std::min(total, m_sortNs));
+    return ret;
+}
+
+NrMacSchedulerNs3::BeamSymbolMap
+ProfiledMacSchedulerTdmaRR::FastAssignRBG(uint32_t symAvail, const ActiveUeMap& activeUes, bool dl) const
+{
+    BeamSymbolMap symPerBeam = GetSymPerBeam(symAvail, activeUes);
+    std::vector<uint8_t> mask = dl ? GetDlNotchedRbgMask() : GetUlNotchedRbgMask();
+    if (mask.empty())
+    {
+        mask.assign(GetBandwidthInRbg(), 1);
+    }
+    const uint32_t usable = std::count(mask.begin(), mask.end(), 1);
+    auto compare = dl ? GetUeCompareDlFn() : GetUeCompareUlFn();
+
+    // A UE is served while its TB does not hold its buffer (as in NrMacSchedulerTdma)
+    auto wantsMore = [dl](const UePtrAndBufferReq& ue) {
+        uint32_t tbs = dl ? NrMacSchedulerUeInfo::GetDlTBS(ue.first) : NrMacSchedulerUeInfo::GetUlTBS(ue.first);
+        return tbs < std::max(ue.second, 7U);
+    };
+
+    for (const auto& beam : activeUes)
+    {
+        uint32_t beamSym = symPerBeam.at(beam.first);
+        const std::vector<UePtrAndBufferReq>& beamUes = beam.second;
+        FTResources assigned(0, 0);
+        for (const auto& ue : beamUes)
+        {
+            dl ? BeforeDlSched(ue, FTResources(usable * beamSym, beamSym))
+               : BeforeUlSched(ue, FTResources(usable * beamSym, beamSym));
+        }
+
+        m_toServe.clear();
+        for (const auto& ue : beamUes)
+        {
+            if (wantsMore(ue))
+            {
+                m_toServe.push_back(ue);
+            }
+        }
+        if (m_toServe.size() > 1)
+        {
+            std::stable_sort(m_toServe.begin(), m_toServe.end(), compare);
+        }
+
+        while (beamSym > 0 && !m_toServe.empty())
+        {
+            // Whole symbol (every usable RBG) to the first UE of the round robin order
+            UePtrAndBufferReq served = m_toServe.front();
+            std::vector<uint16_t>& rbgs = dl ? served.first->m_dlRBG : served.first->m_ulRBG;
+            for (uint16_t rbg = 0; rbg < mask.size(); ++rbg)
+            {
+                if (mask[rbg] == 1)
+                {
+                    rbgs.push_back(rbg);
+                }
+            }
+            dl ? served.first->m_dlSym++ : served.first->m_ulSym++;
+            beamSym--;
+            assigned.m_rbg += usable;
+            assigned.m_sym += 1;
+
+            dl ? AssignedDlResources(served, FTResources(usable, 1), assigned)
+               : AssignedUlResources(served, FTResources(usable, 1), assigned);
+            if (beamUes.size() > 1)
+            {
+                for (const auto& ue : beamUes)
+                {
+                    if (ue.first != served.first)
+                    {
+                        dl ? NotAssignedDlResources(ue, FTResources(usable, 1), assigned)
+                           : NotAssignedUlResources(ue, FTResources(usable, 1), assigned);
+                    }
+                }
+            }
+
+            // Only the served UE changed: it leaves the list once its TB holds its buffer (its TBS
+            // only grows in this slot), otherwise it goes ahead of the UEs with an equal key, where
+            // a stable sort of the list (with the served UE first) keeps it
+            m_toServe.erase(m_toServe.begin());
+            if (wantsMore(served))
+            {
+                m_toServe.insert(std::lower_bound(m_toServe.begin(), m_toServe.end(), served, compare), served);
+            }
+        }
+    }
+    return symPerBeam;
+}
+
+std::shared_ptr<DciInfoElementTdma>
+ProfiledMacSchedulerTdmaRR::CreateDlDci(PointInFTPlane* spoint,
+                                        const std::shared_ptr<NrMacSchedulerUeInfo>& ueInfo,
+                                        uint32_t maxSym) const
+{
+    auto start = Clock::now();
+    auto dci = NrMacSchedulerTdmaRR::CreateDlDci(spoint, ueInfo, maxSym);
+    m_dciNs += Since(start);
+    return dci;
+}
+
+std::shared_ptr<DciInfoElementTdma>
+ProfiledMacSchedulerTdmaRR::CreateUlDci(PointInFTPlane* spoint,
+                                        const std::shared_ptr<NrMacSchedulerUeInfo>& ueInfo,
+                                        uint32_t maxSym) const
+{
+    auto start = Clock::now();
+    auto dci = NrMacSchedulerTdmaRR::CreateUlDci(spoint, ueInfo, maxSym);
+    m_dciNs += Since(start);
+    return dci;
+}
+
+std::function<bool(const NrMacSchedulerNs3::UePtrAndBufferReq& lhs, const NrMacSchedulerNs3::UePtrAndBufferReq& rhs)>
+ProfiledMacSchedulerTdmaRR::GetUeCompareDlFn() const
+{
+    auto compare = NrMacSchedulerTdmaRR::GetUeCompareDlFn();
+    return [this, compare](const UePtrAndBufferReq& lhs, const UePtrAndBufferReq& rhs) {
+        auto start = Clock::now();
+        bool less = compare(lhs, rhs);
+        m_sortNs += Since(start);
+        return less;
+    };
+}
+
+std::function<bool(const NrMacSchedulerNs3::UePtrAndBufferReq& lhs, const NrMacSchedulerNs3::UePtrAndBufferReq& rhs)>
+ProfiledMacSchedulerTdmaRR::GetUeCompareUlFn() const
+{
+    auto compare = NrMacSchedulerTdmaRR::GetUeCompareUlFn();
+    return [this, compare](const UePtrAndBufferReq& lhs, const UePtrAndBufferReq& rhs) {
+        auto start = Clock::now();
+        bool less = compare(lhs, rhs);
+        m_sortNs += Since(start);
+        return less;
+    };
+}
+
+void
+ProfiledMacSchedulerTdmaRR::WriteProfile(std::string filename, std::string histogramFile)
+{
+    std::ofstream out(filename);
+    out << "phase\tcalls\tmeanNs\tp50Ns\tp99Ns\tmaxNs" << std::endl;
+    for (uint32_t p = 0; p < N_PHASES; ++p)
+    {
+        const WallTimeHistogram& h = s_profile[p];
+        out << s_names[p] << "\t" << h.GetCount() << "\t" << h.GetMean() << "\t" << h.GetQuantile(0.5)
+            << "\t" << h.GetQuantile(0.99) << "\t" << h.GetMax() << std::endl;
+    }
+
+    // Bucket i: [2^(i-1), 2^i) ns, or UEs for the ActiveUes rows
+    std::ofstream hist(histogramFile);
+    hist << "phase\tfrom\tto\tcount" << std::endl;
+    for (uint32_t p = 0; p < N_PHASES; ++p)
+    {
+        for (uint32_t i = 0; i < WallTimeHistogram::N_BUCKETS; ++i)
+        {
+            if (s_profile[p].GetBucket(i) > 0)
+            {
+                hist << s_names[p] << "\t" << (i == 0 ? 0 : uint64_t(1) << (i - 1)) << "\t"
+                     << (uint64_t(1) << i) << "\t" << s_profile[p].GetBucket(i) << std::endl;
+            }
+        }
+    }
+
+    std::cout << TXT_CYAN << "MAC scheduler: DL " << s_profile[DL].GetMean() << " ns/slot (p99 "
+              << s_profile[DL].GetQuantile(0.99) << "), UL " << s_profile[UL].GetMean() << " ns/slot (p99 "
+              << s_profile[UL].GetQuantile(0.99) << "), " << s_profile[DL_ACTIVE_UES].GetMean()
+              << " active DL UEs" << TXT_CLEAR << std::endl;
+}
@@ -0,0 +1,137 @@
+#ifndef MAC_SCHEDULER_PROFILER_H
+#define MAC_SCHEDULER_PROFILER_H
+
+#include "ns3/core-module.h"
+#include "ns3/nr-module.h"
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Histogram of wall times, with buckets of powers of two of nanoseconds.
+ */
+class WallTimeHistogram
+{
+public:
+    void Add(uint64_t ns);
+
+    uint64_t GetCount() const;
+    double GetMean() const;
+    uint64_t GetMax() const;
+
+    /**
+     * @return Upper bound (ns) of the bucket that holds the quantile q
+     */
+    uint64_t GetQuantile(double q) const;
+
+    /**
+     * @return Entries of bucket i, [2^(i-1), 2^i) ns (bucket 0: 0 ns)
+     */
+    uint64_t GetBucket(uint32_t i) const;
+
+    static const uint32_t N_BUCKETS = 48;
+
+private:
+    std::array<uint64_t, N_BUCKETS> m_buckets{};
+    uint64_t m_count{0};
+    uint64_t m_sum{0};
+    uint64_t m_max{0};
+};
+
+/**
+ * TDMA round robin scheduler that measures the wall time of its work, for the scaling of the MAC
+ * with the number of UEs. Per call of DoSchedDlTriggerReq / DoSchedUlTriggerReq (one per slot and
+ * direction) it records:
+ *  - dl / ul: the whole call
+ *  - dlSort / ulSort: the UE comparisons of the sorting (each comparison is timed, so it includes
+ *    the clock overhead, ~20 ns per comparison)
+ *  - dlAssign / ulAssign: the RBG (symbol) assignment, without the sorting
+ *  - dlDci / ulDci: the DCI creation of the scheduled UEs
+ *  - dlActiveUes / ulActiveUes: UEs with data given to the assignment (a count, not a time)
+ * and per RLC buffer status report or BSR the LCG bookkeeping (dlLcg / ulLcg).
+ *
+ * The histograms are shared by every gNB and written with WriteProfile at the end of the run.
+ *
+ * With FastAssignment the RBG assignment is done here instead of in NrMacSchedulerTdma, with the
+ * same round robin order: the UEs of a beam are sorted once and each UE served is moved to its new
+ * place (instead of sorting them all again for every symbol), the UEs whose TB already holds their
+ * buffer leave the list of UEs to serve, and a beam with a single UE gets its symbols without any
+ * sorting. It is off by default until the MAC scheduler benchmark compares both.
+ */
+class ProfiledMacSchedulerTdmaRR : public NrMacSchedulerTdmaRR
+{
+public:
+    static TypeId GetTypeId();
+    ProfiledMacSchedulerTdmaRR();
+    ~ProfiledMacSchedulerTdmaRR() override;
+
+    void DoSchedDlTriggerReq(const NrMacSchedSapProvider::SchedDlTriggerReqParameters& params) override;
+    void DoSchedUlTriggerReq(const NrMacSchedSapProvider::SchedUlTriggerReqParameters& params) override;
+    void DoSchedDlRlcBufferReq(const NrMacSchedSapProvider::SchedDlRlcBufferReqParameters& params) override;
+    void DoSchedUlMacCtrlInfoReq(const NrMacSchedSapProvider::SchedUlMacCtrlInfoReqParameters& params) override;
+
+    /**
+     * @brief Writes the summary of every histogram (phase, calls, mean, p50, p99 and max in ns)
+     * to filename and their buckets to histogramFile, and prints the DL and UL summary
+     */
+    static void WriteProfile(std::string filename, std::string histogramFile);
+
+protected:
+    BeamSymbolMap AssignDLRBG(uint32_t symAvail, const ActiveUeMap& activeDl) const override;
+    BeamSymbolMap AssignULRBG(uint32_t symAvail, const ActiveUeMap& activeUl) const override;
+
+    std::shared_ptr<DciInfoElementTdma> CreateDlDci(PointInFTPlane* spoint,
+                                                    const std::shared_ptr<NrMacSchedulerUeInfo>& ueInfo,
+                                                    uint32_t maxSym) const override;
+    std::shared_ptr<DciInfoElementTdma> CreateUlDci(PointInFTPlane* spoint,
+                                                    const std::shared_ptr<NrMacSchedulerUeInfo>& ueInfo,
+                                                    uint32_t maxSym) const override;
+
+    std::function<bool(const UePtrAndBufferReq& lhs, const UePtrAndBufferReq& rhs)>
+    GetUeCompareDlFn() const override;
+    std::function<bool(const UePtrAndBufferReq& lhs, const UePtrAndBufferReq& rhs)>
+    GetUeCompareUlFn() const override;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Round robin TDMA assignment of the symbols of every beam (FastAssignment)
+     * @param dl Whether it assigns the DL or the UL
+     */
+    BeamSymbolMap FastAssignRBG(uint32_t symAvail, const ActiveUeMap& activeUes, bool dl) const;
+
+    /** Histograms of the profile */
+    enum Phase
+    {
+        DL,
+        DL_SORT,
+        DL_ASSIGN,
+        DL_DCI,
+        DL_ACTIVE_UES,
+        DL_LCG,
+        UL,
+        UL_SORT,
+        UL_ASSIGN,
+        UL_DCI,
+        UL_ACTIVE_UES,
+        UL_LCG,
+        N_PHASES
+    };
+
+    static uint64_t Since(Clock::time_point start);
+
+    static std::array<WallTimeHistogram, N_PHASES> s_profile;
+    static const std::array<std::string, N_PHASES> s_names;
+
+    bool m_fastAssignment;      //!< Attribute FastAssignment
+    mutable uint64_t m_sortNs;  //!< Time in the comparisons of the current assignment
+    mutable uint64_t m_dciNs;   //!< Time in the DCIs of the current call
+    mutable std::vector<UePtrAndBufferReq> m_toServe;  //!< UEs of the beam still to serve, in RR order
+};
+
+#endif // MAC_SCHEDULER_PROFILER_H
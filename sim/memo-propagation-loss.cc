@@ -0,0 +1,150 @@
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/network-module.h"
+#include "ns3/nr-module.h"
+#include "ns3/propagation-module.h"
+
+#include "memo-propagation-loss.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("MemoPropagationLossModel");
+
+NS_OBJECT_ENSURE_REGISTERED(MemoPropagationLossModel);
+
+TypeId
+MemoPropagationLossModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::MemoPropagationLossModel")
+            .SetParent<PropagationLossModel>()
+            .SetGroupName("MyAppComp")
+            .AddConstructor<MemoPropagationLossModel>()
+            .AddAttribute("Resolution",
+                          "Side (m) of the cells the positions are quantized to, a link is computed "
+                          "again when one end changes of cell",
+                          DoubleValue(0.01),
+                          MakeDoubleAccessor(&MemoPropagationLossModel::m_resolution),
+                          MakeDoubleChecker<double>(1e-6));
+    return tid;
+}
+
+MemoPropagationLossModel::MemoPropagationLossModel()
+    : m_resolution(0.01),
+      m_hits(0),
+      m_misses(0)
+{
+}
+
+MemoPropagationLossModel::~MemoPropagationLossModel()
+{
+}
+
+void
+MemoPropagationLossModel::SetInner(Ptr<PropagationLossModel> inner)
+{
+    m_inner = inner;
+    m_links.clear();
+}
+
+std::pair<uint64_t, uint64_t>
+MemoPropagationLossModel::GetStats() const
+{
+    return std::make_pair(m_hits, m_misses);
+}
+
+void
+MemoPropagationLossModel::Watch(uint32_t node, Ptr<MobilityModel> mobility) const
+{
+    if (m_watched.insert(node).second)
+    {
+        mobility->TraceConnectWithoutContext("CourseChange",
+                                             MakeCallback(&MemoPropagationLossModel::CourseChanged, this));
+    }
+}
+
+void
+MemoPropagationLossModel::CourseChanged(Ptr<const MobilityModel> mobility) const
+{
+    auto it = m_nodeLinks.find(mobility->GetObject<Node>()->GetId());
+    if (it == m_nodeLinks.end())
+    {
+        return;
+    }
+    for (uint64_t link : it->second)
+    {
+        m_links.erase(link);
+    }
+    it->second.clear();
+}
+
+double
+MemoPropagationLossModel::DoCalcRxPower(double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+{
+    Ptr<Node> aNode = a->GetObject<Node>();
+    Ptr<Node> bNode = b->GetObject<Node>();
+    if (!aNode || !bNode)
+    {
+        return m_inner->CalcRxPower(txPowerDbm, a, b);
+    }
+
+    uint32_t aId = aNode->GetId();
+    uint32_t bId = bNode->GetId();
+    uint64_t key = (static_cast<uint64_t>(aId) << 32) | bId;
+
+    Vector aPos = a->GetPosition();
+    Vector bPos = b->GetPosition();
+    auto cell = [this](double v) { return static_cast<int64_t>(std::floor(v / m_resolution)); };
+    Entry entry{{cell(aPos.x), cell(aPos.y), cell(aPos.z)}, {cell(bPos.x), cell(bPos.y), cell(bPos.z)}, 0};
+
+    auto it = m_links.find(key);
+    if (it != m_links.end() && std::equal(entry.a, entry.a + 3, it->second.a) &&
+        std::equal(entry.b, entry.b + 3, it->second.b))
+    {
+        m_hits++;
+        return txPowerDbm - it->second.loss;
+    }
+
+    m_misses++;
+    double rxPowerDbm = m_inner->CalcRxPower(txPowerDbm, a, b);
+    entry.loss = txPowerDbm - rxPowerDbm;
+    m_links[key] = entry;
+
+    Watch(aId, a);
+    Watch(bId, b);
+    m_nodeLinks[aId].insert(key);
+    m_nodeLinks[bId].insert(key);
+    return rxPowerDbm;
+}
+
+int64_t
+MemoPropagationLossModel::DoAssignStreams(int64_t stream)
+{
+    // The channel holds the memo instead of the chain, so its streams are forwarded
+    return m_inner ? m_inner->AssignStreams(stream) : 0;
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+std::vector<Ptr<MemoPropagationLossModel>>
+InstallMemoPropagationLoss(const BandwidthPartInfoPtrVector& bwps, double resolution)
+{
+    std::vector<Ptr<MemoPropagationLossModel>> memos;
+    for (const auto& bwp : bwps)
+    {
+        PointerValue current;
+        bwp.get()->m_channel->GetAttribute("PropagationLossModel", current);
+        Ptr<PropagationLossModel> chain = current.Get<PropagationLossModel>();
+        NS_ABORT_MSG_IF(!chain, "The BWP channel has no propagation loss model");
+
+        Ptr<MemoPropagationLossModel> memo = CreateObject<MemoPropagationLossModel>();
+        memo->SetAttribute("Resolution", DoubleValue(resolution));
+        memo->SetInner(chain);
+        bwp.get()->m_channel->SetAttribute("PropagationLossModel", PointerValue(memo));
+        memos.push_back(memo);
+    }
+    return memos;
+}
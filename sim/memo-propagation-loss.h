@@ -0,0 +1,89 @@
+#ifndef MEMO_PROPAGATION_LOSS_H
+#define MEMO_PROPAGATION_LOSS_H
+
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/nr-module.h"
+#include "ns3/propagation-module.h"
+
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Propagation loss of another model (the BWP chain: 3GPP or hybrid buildings path loss, shadowing,
+ * building penetration, foliage) memoized by link.
+ *
+ * Every (tx node, rx node) link keeps the loss of its last evaluation with the positions of both
+ * ends quantized to Resolution. While neither end leaves its cell the stored loss is returned; when
+ * one does, or a CourseChange of one end is notified (a jump or a new velocity), the loss is computed
+ * again. The loss of ns-3 models does not depend on the transmitted power, so one value serves every
+ * PSD. The shadowing of the 3GPP and buildings models is kept per link and only redrawn when the
+ * link moves, so a static link gets exactly the loss of the first evaluation.
+ *
+ * In the IndoorRouter scenario or with mobility=0 nothing moves, and every link is computed once per
+ * run.
+ */
+class MemoPropagationLossModel : public PropagationLossModel
+{
+public:
+    static TypeId GetTypeId();
+    MemoPropagationLossModel();
+    ~MemoPropagationLossModel() override;
+
+    /**
+     * @brief Model (or chain of models) whose loss is memoized
+     */
+    void SetInner(Ptr<PropagationLossModel> inner);
+
+    /**
+     * @return Evaluations served from the memo and computed by the inner model
+     */
+    std::pair<uint64_t, uint64_t> GetStats() const;
+
+private:
+    /** Loss of a link and the cells of its ends when it was computed */
+    struct Entry
+    {
+        int64_t a[3];
+        int64_t b[3];
+        double loss;
+    };
+
+    double DoCalcRxPower(double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const override;
+
+    int64_t DoAssignStreams(int64_t stream) override;
+
+    /**
+     * @brief Follows the course changes of a mobility model the first time it is seen
+     */
+    void Watch(uint32_t node, Ptr<MobilityModel> mobility) const;
+
+    /**
+     * @brief Forgets the links of the node of the mobility model
+     */
+    void CourseChanged(Ptr<const MobilityModel> mobility) const;
+
+    double m_resolution;    //!< Attribute Resolution (m)
+    Ptr<PropagationLossModel> m_inner;
+
+    mutable std::unordered_map<uint64_t, Entry> m_links;               //!< Key: tx node, rx node
+    mutable std::unordered_map<uint32_t, std::set<uint64_t>> m_nodeLinks;
+    mutable std::set<uint32_t> m_watched;
+    mutable uint64_t m_hits;
+    mutable uint64_t m_misses;
+};
+
+/**
+ * @brief Memoizes the propagation loss of the channel of every BWP. Call it once the loss models of
+ * the channel (path loss, foliage) are in place
+ * @param resolution Quantization of the positions (m)
+ * @return The memo of every BWP
+ */
+std::vector<Ptr<MemoPropagationLossModel>> InstallMemoPropagationLoss(const BandwidthPartInfoPtrVector& bwps,
+                                                                      double resolution);
+
+#endif // MEMO_PROPAGATION_LOSS_H
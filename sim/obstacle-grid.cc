@@ -0,0 +1,266 @@
+#include "ns3/core-module.h"
+#include "ns3/buildings-module.h"
+
+#include "obstacle-grid.h"
+
+#include <cmath>
+#include <limits>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("ObstacleGrid");
+
+Ptr<ObstacleGrid> ObstacleGrid::s_grid = nullptr;
+uint32_t ObstacleGrid::s_nextId = 1;
+
+Ptr<ObstacleGrid>
+ObstacleGrid::Build(double cellSize)
+{
+    s_grid = Create<ObstacleGrid>(cellSize);
+    return s_grid;
+}
+
+Ptr<ObstacleGrid>
+ObstacleGrid::Get()
+{
+    if (s_grid && s_grid->GetNBuildings() != BuildingList::GetNBuildings())
+    {
+        NS_LOG_INFO("Buildings added after the grid was built, building it again");
+        s_grid = Create<ObstacleGrid>(s_grid->m_cell);
+    }
+    return s_grid;
+}
+
+ObstacleGrid::ObstacleGrid(double cellSize)
+    : m_cell(cellSize),
+      m_x0(0),
+      m_y0(0),
+      m_nx(0),
+      m_ny(0),
+      m_id(s_nextId++)
+{
+    NS_ABORT_MSG_IF(cellSize <= 0, "The cell size of the obstacle grid must be > 0");
+
+    double x1 = -std::numeric_limits<double>::max();
+    double y1 = -std::numeric_limits<double>::max();
+    m_x0 = std::numeric_limits<double>::max();
+    m_y0 = std::numeric_limits<double>::max();
+    for (BuildingList::Iterator it = BuildingList::Begin(); it != BuildingList::End(); ++it)
+    {
+        Box box = (*it)->GetBoundaries();
+        m_buildings.push_back(*it);
+        m_boxes.push_back(box);
+        m_x0 = std::min(m_x0, box.xMin);
+        m_y0 = std::min(m_y0, box.yMin);
+        x1 = std::max(x1, box.xMax);
+        y1 = std::max(y1, box.yMax);
+    }
+    if (m_buildings.empty())
+    {
+        return;
+    }
+
+    m_nx = static_cast<int32_t>(std::floor((x1 - m_x0) / m_cell)) + 1;
+    m_ny = static_cast<int32_t>(std::floor((y1 - m_y0) / m_cell)) + 1;
+    m_cells.resize(static_cast<size_t>(m_nx) * m_ny);
+    for (uint32_t i = 0; i < m_buildings.size(); i++)
+    {
+        Insert(i);
+    }
+    NS_LOG_INFO("Obstacle grid: " << m_buildings.size() << " buildings in " << m_nx << "x" << m_ny
+                                  << " cells of " << m_cell << " m");
+}
+
+void
+ObstacleGrid::Insert(uint32_t index)
+{
+    const Box& box = m_boxes[index];
+    int32_t cx0 = static_cast<int32_t>(std::floor((box.xMin - m_x0) / m_cell));
+    int32_t cx1 = static_cast<int32_t>(std::floor((box.xMax - m_x0) / m_cell));
+    int32_t cy0 = static_cast<int32_t>(std::floor((box.yMin - m_y0) / m_cell));
+    int32_t cy1 = static_cast<int32_t>(std::floor((box.yMax - m_y0) / m_cell));
+    for (int32_t cx = std::max(0, cx0); cx <= std::min(m_nx - 1, cx1); cx++)
+    {
+        for (int32_t cy = std::max(0, cy0); cy <= std::min(m_ny - 1, cy1); cy++)
+        {
+            m_cells[static_cast<size_t>(cy) * m_nx + cx].push_back(index);
+        }
+    }
+}
+
+uint32_t
+ObstacleGrid::GetNBuildings() const
+{
+    return m_buildings.size();
+}
+
+Ptr<Building>
+ObstacleGrid::FindBuilding(const Vector& pos) const
+{
+    int32_t cx = static_cast<int32_t>(std::floor((pos.x - m_x0) / m_cell));
+    int32_t cy = static_cast<int32_t>(std::floor((pos.y - m_y0) / m_cell));
+    if (cx < 0 || cy < 0 || cx >= m_nx || cy >= m_ny)
+    {
+        return nullptr;
+    }
+    for (uint32_t index : m_cells[static_cast<size_t>(cy) * m_nx + cx])
+    {
+        if (m_boxes[index].IsInside(pos))
+        {
+            return m_buildings[index];
+        }
+    }
+    return nullptr;
+}
+
+void
+ObstacleGrid::Traverse(const Vector& a, const Vector& b, const std::function<bool(uint32_t)>& visit) const
+{
+    if (m_nx == 0)
+    {
+        return;
+    }
+
+    // Clip the segment (a + t*(b-a), t in [0,1]) to the grid rectangle (Liang-Barsky)
+    double dx = b.x - a.x;
+    double dy = b.y - a.y;
+    double t0 = 0;
+    double t1 = 1;
+    double p[4] = {-dx, dx, -dy, dy};
+    double q[4] = {a.x - m_x0, m_x0 + m_nx * m_cell - a.x, a.y - m_y0, m_y0 + m_ny * m_cell - a.y};
+    for (int i = 0; i < 4; i++)
+    {
+        if (p[i] == 0)
+        {
+            if (q[i] < 0)
+            {
+                return;
+            }
+            continue;
+        }
+        double t = q[i] / p[i];
+        if (p[i] < 0)
+        {
+            t0 = std::max(t0, t);
+        }
+        else
+        {
+            t1 = std::min(t1, t);
+        }
+    }
+    if (t0 > t1)
+    {
+        return;
+    }
+
+    // Walk the cells from the first point inside (Amanatides-Woo)
+    double sx = a.x + t0 * dx;
+    double sy = a.y + t0 * dy;
+    int32_t cx = std::min(m_nx - 1, std::max(0, static_cast<int32_t>(std::floor((sx - m_x0) / m_cell))));
+    int32_t cy = std::min(m_ny - 1, std::max(0, static_cast<int32_t>(std::floor((sy - m_y0) / m_cell))));
+    int32_t stepX = dx > 0 ? 1 : (dx < 0 ? -1 : 0);
+    int32_t stepY = dy > 0 ? 1 : (dy < 0 ? -1 : 0);
+    double inf = std::numeric_limits<double>::infinity();
+    double tMaxX = stepX ? (m_x0 + (cx + (stepX > 0)) * m_cell - a.x) / dx : inf;
+    double tMaxY = stepY ? (m_y0 + (cy + (stepY > 0)) * m_cell - a.y) / dy : inf;
+    double tDeltaX = stepX ? m_cell / std::abs(dx) : inf;
+    double tDeltaY = stepY ? m_cell / std::abs(dy) : inf;
+
+    while (true)
+    {
+        if (!visit(static_cast<uint32_t>(cy) * m_nx + cx))
+        {
+            return;
+        }
+        if (tMaxX < tMaxY)
+        {
+            if (tMaxX > t1)
+            {
+                return;
+            }
+            cx += stepX;
+            tMaxX += tDeltaX;
+        }
+        else
+        {
+            if (tMaxY > t1)
+            {
+                return;
+            }
+            cy += stepY;
+            tMaxY += tDeltaY;
+        }
+        if (cx < 0 || cy < 0 || cx >= m_nx || cy >= m_ny)
+        {
+            return;
+        }
+    }
+}
+
+void
+ObstacleGrid::ForEachIntersected(const Vector& a,
+                                 const Vector& b,
+                                 const std::function<void(Ptr<Building>)>& fn) const
+{
+    // fn is called once the marks are no longer needed, so it can query the grid again
+    std::vector<Ptr<Building>> hits;
+    Scratch& scratch = BeginQuery();
+    uint32_t query = scratch.query;
+    Traverse(a, b, [&](uint32_t cell) {
+        for (uint32_t index : m_cells[cell])
+        {
+            if (scratch.stamp[index] == query)
+            {
+                continue;
+            }
+            scratch.stamp[index] = query;
+            if (m_buildings[index]->IsIntersect(a, b))
+            {
+                hits.push_back(m_buildings[index]);
+            }
+        }
+        return true;
+    });
+    for (const auto& building : hits)
+    {
+        fn(building);
+    }
+}
+
+bool
+ObstacleGrid::IsLineOfSight(const Vector& a, const Vector& b) const
+{
+    bool los = true;
+    Scratch& scratch = BeginQuery();
+    uint32_t query = scratch.query;
+    Traverse(a, b, [&](uint32_t cell) {
+        for (uint32_t index : m_cells[cell])
+        {
+            if (scratch.stamp[index] != query)
+            {
+                scratch.stamp[index] = query;
+                if (m_buildings[index]->IsIntersect(a, b))
+                {
+                    los = false;
+                    return false;
+                }
+            }
+        }
+        return true;
+    });
+    return los;
+}
+
+ObstacleGrid::Scratch&
+ObstacleGrid::BeginQuery() const
+{
+    thread_local Scratch scratch;
+    if (scratch.grid != m_id || ++scratch.query == 0)
+    {
+        // Another grid, or the query numbers wrapped around: no building is marked
+        scratch.grid = m_id;
+        scratch.query = 1;
+        scratch.stamp.assign(m_buildings.size(), 0);
+    }
+    return scratch;
+}
@@ -0,0 +1,94 @@
+#ifndef OBSTACLE_GRID_H
+#define OBSTACLE_GRID_H
+
+#include "ns3/core-module.h"
+#include "ns3/buildings-module.h"
+
+#include <functional>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Uniform grid over the xy plane with the buildings (and trees, which are buildings) of
+ * BuildingList, so the obstacle queries only look at the buildings of the cells they touch:
+ *  - FindBuilding: point in building, one cell
+ *  - ForEachIntersected: segment vs box, the cells crossed by the segment (2D DDA)
+ *
+ * Build it once after the scenario is created (Build), Get() rebuilds it if buildings were added
+ * since then. The queries are const and can run in several threads at once (each thread keeps its
+ * own marks of the buildings already tested), and the callback of ForEachIntersected can query the
+ * grid again.
+ *
+ * Only TrajectoryChannelConditionModel looks the buildings up here. The upstream models
+ * (BuildingsChannelConditionModel, the buildings propagation loss models, MobilityBuildingInfo,
+ * BuildingsHelper) still scan the whole BuildingList.
+ */
+class ObstacleGrid : public SimpleRefCount<ObstacleGrid>
+{
+public:
+    /**
+     * @brief Builds the global grid with cells of cellSize meters
+     */
+    static Ptr<ObstacleGrid> Build(double cellSize);
+
+    /**
+     * @return The global grid, nullptr if it was never built
+     */
+    static Ptr<ObstacleGrid> Get();
+
+    explicit ObstacleGrid(double cellSize);
+
+    /**
+     * @return Building that contains the position, nullptr if it is outdoor
+     */
+    Ptr<Building> FindBuilding(const Vector& pos) const;
+
+    /**
+     * @brief Calls fn once for every building intersected by the segment a-b
+     */
+    void ForEachIntersected(const Vector& a, const Vector& b, const std::function<void(Ptr<Building>)>& fn) const;
+
+    /**
+     * @return true if no building intersects the segment a-b
+     */
+    bool IsLineOfSight(const Vector& a, const Vector& b) const;
+
+    uint32_t GetNBuildings() const;
+
+private:
+    void Insert(uint32_t index);
+
+    /**
+     * @brief Visits the cells crossed by the segment a-b, stops when visit returns false
+     */
+    void Traverse(const Vector& a, const Vector& b, const std::function<bool(uint32_t)>& visit) const;
+
+    double m_cell;
+    double m_x0;
+    double m_y0;
+    int32_t m_nx;
+    int32_t m_ny;
+    std::vector<Ptr<Building>> m_buildings;
+    std::vector<Box> m_boxes;
+    std::vector<std::vector<uint32_t>> m_cells;    //!< Buildings (index) overlapping every cell
+    uint32_t m_id;                                 //!< Identifies the grid in the scratch of the threads
+
+    /** Buildings already tested by the current query of a thread */
+    struct Scratch
+    {
+        uint32_t grid{0};               //!< m_id of the grid the marks belong to
+        uint32_t query{0};
+        std::vector<uint32_t> stamp;    //!< Last query that tested every building
+    };
+
+    /**
+     * @return Scratch of the calling thread for this grid, with the number of a new query
+     */
+    Scratch& BeginQuery() const;
+
+    static Ptr<ObstacleGrid> s_grid;
+    static uint32_t s_nextId;
+};
+
+#endif // OBSTACLE_GRID_H
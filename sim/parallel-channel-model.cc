@@ -0,0 +1,415 @@
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/nr-module.h"
+#include "ns3/spectrum-module.h"
+
+#include "parallel-channel-model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("ParallelChannelModel");
+
+NS_OBJECT_ENSURE_REGISTERED(ParallelChannelModel);
+
+IntraEventPool::IntraEventPool(uint32_t threads)
+    : m_job(nullptr),
+      m_n(0),
+      m_generation(0),
+      m_pending(0),
+      m_stop(false)
+{
+    for (uint32_t i = 1; i < threads; ++i)
+    {
+        m_threads.emplace_back(&IntraEventPool::Work, this, i);
+    }
+}
+
+IntraEventPool::~IntraEventPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+uint32_t
+IntraEventPool::GetN() const
+{
+    return m_threads.size() + 1;
+}
+
+std::pair<uint32_t, uint32_t>
+IntraEventPool::GetRange(uint32_t n, uint32_t parts, uint32_t index)
+{
+    return std::make_pair(static_cast<uint64_t>(n) * index / parts,
+                          static_cast<uint64_t>(n) * (index + 1) / parts);
+}
+
+void
+IntraEventPool::ParallelFor(uint32_t n, const Job& job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_n = n;
+        m_pending = m_threads.size();
+        m_generation++;
+    }
+    m_start.notify_all();
+
+    auto range = GetRange(n, GetN(), 0);
+    if (range.first < range.second)
+    {
+        job(range.first, range.second);
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_pending == 0; });
+    m_job = nullptr;
+}
+
+void
+IntraEventPool::Work(uint32_t index)
+{
+    uint64_t done = 0;
+    while (true)
+    {
+        const Job* job;
+        uint32_t n;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [this, done]() { return m_stop || m_generation != done; });
+            if (m_stop)
+            {
+                return;
+            }
+            done = m_generation;
+            job = m_job;
+            n = m_n;
+        }
+
+        auto range = GetRange(n, GetN(), index);
+        if (range.first < range.second)
+        {
+            (*job)(range.first, range.second);
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_pending == 0)
+        {
+            m_done.notify_one();
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+TypeId
+ParallelChannelModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::ParallelChannelModel")
+            .SetParent<ThreeGppChannelModel>()
+            .SetGroupName("MyAppComp")
+            .AddConstructor<ParallelChannelModel>()
+            .AddAttribute("Threads",
+                          "Threads that generate a channel matrix, 1: the calling thread only",
+                          UintegerValue(1),
+                          MakeUintegerAccessor(&ParallelChannelModel::m_threads),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("MinElementPairs",
+                          "Antenna element pairs of a link below which its matrix is generated serially",
+                          UintegerValue(256),
+                          MakeUintegerAccessor(&ParallelChannelModel::m_minPairs),
+                          MakeUintegerChecker<uint32_t>());
+    return tid;
+}
+
+ParallelChannelModel::ParallelChannelModel()
+    : m_threads(1),
+      m_minPairs(256)
+{
+}
+
+ParallelChannelModel::~ParallelChannelModel()
+{
+}
+
+void
+ParallelChannelModel::DoDispose()
+{
+    m_pool.reset();
+    ThreeGppChannelModel::DoDispose();
+}
+
+Ptr<MatrixBasedChannelModel::ChannelMatrix>
+ParallelChannelModel::GetNewChannel(Ptr<const ThreeGppChannelParams> channelParams,
+                                    Ptr<const ParamsTable> table3gpp,
+                                    const Ptr<const MobilityModel> sMob,
+                                    const Ptr<const MobilityModel> uMob,
+                                    Ptr<const PhasedArrayModel> sAntenna,
+                                    Ptr<const PhasedArrayModel> uAntenna) const
+{
+    const uint64_t uSize = uAntenna->GetNumberOfElements();
+    const uint64_t sSize = sAntenna->GetNumberOfElements();
+    if (uSize * sSize < m_minPairs)
+    {
+        return ThreeGppChannelModel::GetNewChannel(channelParams, table3gpp, sMob, uMob, sAntenna, uAntenna);
+    }
+    if (!m_pool || m_pool->GetN() != m_threads)
+    {
+        m_pool = std::make_unique<IntraEventPool>(m_threads);
+    }
+
+    Ptr<ChannelMatrix> channelMatrix = Create<ChannelMatrix>();
+    channelMatrix->m_nodeIds = std::make_pair(sMob->GetObject<Node>()->GetId(), uMob->GetObject<Node>()->GetId());
+    channelMatrix->m_antennaPair = std::make_pair(sAntenna->GetId(), uAntenna->GetId());
+    channelMatrix->m_generatedTime = Simulator::Now();
+
+    const uint8_t nClusters = channelParams->m_reducedClusterNumber;
+    const uint8_t nRays = table3gpp->m_raysPerCluster;
+    const uint8_t cluster1st = channelParams->m_cluster1st;
+    const uint8_t cluster2nd = channelParams->m_cluster2nd;
+    const uint8_t nPages = cluster1st != cluster2nd ? nClusters + 4 : nClusters + 2;
+    NS_ASSERT(nClusters <= channelParams->m_clusterPhase.size());
+
+    // Page of the 2nd and 3rd sub-clusters of the two strongest clusters (appended in cluster order)
+    std::vector<uint8_t> page2(nClusters, 0);
+    std::vector<uint8_t> page3(nClusters, 0);
+    uint8_t subClusters = 0;
+    for (uint8_t n = 0; n < nClusters; ++n)
+    {
+        if (n == cluster1st || n == cluster2nd)
+        {
+            page2[n] = nClusters + subClusters;
+            page3[n] = nClusters + subClusters + 1;
+            subClusters += 2;
+        }
+    }
+
+    // Sub-cluster of every ray of a strong cluster (TR 38.901 Table 7.5-5)
+    std::vector<uint8_t> subOfRay(nRays, 0);
+    for (uint8_t m = 0; m < nRays; ++m)
+    {
+        subOfRay[m] = (m >= 9 && m <= 12) || m == 17 || m == 18 ? 1 : (m >= 13 && m <= 16 ? 2 : 0);
+    }
+
+    // Per ray terms (as in ThreeGppChannelModel): direction cosines and the polarization/phase part
+    const size_t nTerms = static_cast<size_t>(nClusters) * nRays;
+    std::vector<double> sinCosA(nTerms), sinSinA(nTerms), cosZoA(nTerms);
+    std::vector<double> sinCosD(nTerms), sinSinD(nTerms), cosZoD(nTerms);
+    std::vector<std::complex<double>> raysPreComp(nTerms);
+    for (uint8_t n = 0; n < nClusters; ++n)
+    {
+        for (uint8_t m = 0; m < nRays; ++m)
+        {
+            size_t r = static_cast<size_t>(n) * nRays + m;
+            double zoa = channelParams->m_rayZoaRadian[n][m];
+            double aoa = channelParams->m_rayAoaRadian[n][m];
+            double zod = channelParams->m_rayZodRadian[n][m];
+            double aod = channelParams->m_rayAodRadian[n][m];
+            sinCosA[r] = sin(zoa) * cos(aoa);
+            sinSinA[r] = sin(zoa) * sin(aoa);
+            cosZoA[r] = cos(zoa);
+            sinCosD[r] = sin(zod) * cos(aod);
+            sinSinD[r] = sin(zod) * sin(aod);
+            cosZoD[r] = cos(zod);
+
+            const auto& phase = channelParams->m_clusterPhase[n][m];
+            double k = channelParams->m_crossPolarizationPowerRatios[n][m];
+            auto [rxFieldPatternPhi, rxFieldPatternTheta] = uAntenna->GetElementFieldPattern(Angles(aoa, zoa));
+            auto [txFieldPatternPhi, txFieldPatternTheta] = sAntenna->GetElementFieldPattern(Angles(aod, zod));
+            raysPreComp[r] =
+                std::complex<double>(cos(phase[0]), sin(phase[0])) * rxFieldPatternTheta * txFieldPatternTheta +
+                std::complex<double>(cos(phase[1]), sin(phase[1])) * std::sqrt(1.0 / k) * rxFieldPatternTheta * txFieldPatternPhi +
+                std::complex<double>(cos(phase[2]), sin(phase[2])) * std::sqrt(1.0 / k) * rxFieldPatternPhi * txFieldPatternTheta +
+                std::complex<double>(cos(phase[3]), sin(phase[3])) * rxFieldPatternPhi * txFieldPatternPhi;
+        }
+    }
+
+    // Element positions (PhasedArrayModel is not read by the workers)
+    std::vector<Vector> uLoc(uSize);
+    for (uint64_t u = 0; u < uSize; ++u)
+    {
+        uLoc[u] = uAntenna->GetElementLocation(u);
+    }
+
+    // Transmit phase of every ray and element, element index last so the inner loop is contiguous
+    std::vector<double> txRe(nTerms * sSize);
+    std::vector<double> txIm(nTerms * sSize);
+    std::vector<Vector> sLoc(sSize);
+    for (uint64_t s = 0; s < sSize; ++s)
+    {
+        sLoc[s] = sAntenna->GetElementLocation(s);
+        for (size_t r = 0; r < nTerms; ++r)
+        {
+            double txPhaseDiff = 2 * M_PI * (sinCosD[r] * sLoc[s].x + sinSinD[r] * sLoc[s].y + cosZoD[r] * sLoc[s].z);
+            txRe[r * sSize + s] = cos(txPhaseDiff);
+            txIm[r * sSize + s] = sin(txPhaseDiff);
+        }
+    }
+
+    // Direct path (7.5-29, 7.5-30): element phases and the part common to every pair
+    const bool los = channelParams->m_losCondition == ChannelCondition::LOS;
+    std::vector<std::complex<double>> rxLos;
+    std::vector<std::complex<double>> txLos;
+    std::complex<double> losBase;
+    double kLinear = 0;
+    if (los)
+    {
+        Angles sAngle(uMob->GetPosition(), sMob->GetPosition());
+        Angles uAngle(sMob->GetPosition(), uMob->GetPosition());
+        double lambda = 3e8 / GetFrequency();
+        std::complex<double> phaseDiffDueToDistance(cos(-2 * M_PI * channelParams->m_dis3D / lambda),
+                                                    sin(-2 * M_PI * channelParams->m_dis3D / lambda));
+        auto [rxFieldPatternPhi, rxFieldPatternTheta] =
+            uAntenna->GetElementFieldPattern(Angles(uAngle.GetAzimuth(), uAngle.GetInclination()));
+        auto [txFieldPatternPhi, txFieldPatternTheta] =
+            sAntenna->GetElementFieldPattern(Angles(sAngle.GetAzimuth(), sAngle.GetInclination()));
+        losBase = (rxFieldPatternTheta * txFieldPatternTheta - rxFieldPatternPhi * txFieldPatternPhi) *
+                  phaseDiffDueToDistance;
+        kLinear = pow(10, channelParams->m_K_factor / 10);
+
+        const double sinUAngleIncl = sin(uAngle.GetInclination());
+        const double cosUAngleIncl = cos(uAngle.GetInclination());
+        const double sinUAngleAz = sin(uAngle.GetAzimuth());
+        const double cosUAngleAz = cos(uAngle.GetAzimuth());
+        const double sinSAngleIncl = sin(sAngle.GetInclination());
+        const double cosSAngleIncl = cos(sAngle.GetInclination());
+        const double sinSAngleAz = sin(sAngle.GetAzimuth());
+        const double cosSAngleAz = cos(sAngle.GetAzimuth());
+        for (uint64_t u = 0; u < uSize; ++u)
+        {
+            double rxPhaseDiff = 2 * M_PI * (sinUAngleIncl * cosUAngleAz * uLoc[u].x +
+                                             sinUAngleIncl * sinUAngleAz * uLoc[u].y + cosUAngleIncl * uLoc[u].z);
+            rxLos.emplace_back(cos(rxPhaseDiff), sin(rxPhaseDiff));
+        }
+        for (uint64_t s = 0; s < sSize; ++s)
+        {
+            double txPhaseDiff = 2 * M_PI * (sinSAngleIncl * cosSAngleAz * sLoc[s].x +
+                                             sinSAngleIncl * sinSAngleAz * sLoc[s].y + cosSAngleIncl * sLoc[s].z);
+            txLos.emplace_back(cos(txPhaseDiff), sin(txPhaseDiff));
+        }
+    }
+
+    std::vector<double> scale(nClusters);
+    for (uint8_t n = 0; n < nClusters; ++n)
+    {
+        scale[n] = sqrt(channelParams->m_clusterPower[n] / nRays);
+    }
+    const double losAttenuation = los ? pow(10, channelParams->m_attenuation_dB[0] / 10) : 1;
+
+    MatrixBasedChannelModel::Complex3DVector hUsn(uSize, sSize, nPages);
+
+    // Rows of the matrix, each one written by a single thread
+    IntraEventPool::Job rows = [&](uint32_t begin, uint32_t end) {
+        std::vector<double> rxRe(nRays);
+        std::vector<double> rxIm(nRays);
+        std::vector<double> sumRe(3 * sSize);
+        std::vector<double> sumIm(3 * sSize);
+        for (uint32_t u = begin; u < end; ++u)
+        {
+            for (uint8_t n = 0; n < nClusters; ++n)
+            {
+                const bool strong = n == cluster1st || n == cluster2nd;
+                for (uint8_t m = 0; m < nRays; ++m)
+                {
+                    size_t r = static_cast<size_t>(n) * nRays + m;
+                    double rxPhaseDiff = 2 * M_PI * (sinCosA[r] * uLoc[u].x + sinSinA[r] * uLoc[u].y + cosZoA[r] * uLoc[u].z);
+                    std::complex<double> rx = raysPreComp[r] * std::complex<double>(cos(rxPhaseDiff), sin(rxPhaseDiff));
+                    rxRe[m] = rx.real();
+                    rxIm[m] = rx.imag();
+                }
+
+                // Sum of the rays (by sub-cluster), for all the transmit elements at once
+                std::fill(sumRe.begin(), sumRe.end(), 0.0);
+                std::fill(sumIm.begin(), sumIm.end(), 0.0);
+                for (uint8_t m = 0; m < nRays; ++m)
+                {
+                    size_t offset = (strong ? subOfRay[m] : 0) * sSize;
+                    double* accRe = sumRe.data() + offset;
+                    double* accIm = sumIm.data() + offset;
+                    const double* tRe = txRe.data() + (static_cast<size_t>(n) * nRays + m) * sSize;
+                    const double* tIm = txIm.data() + (static_cast<size_t>(n) * nRays + m) * sSize;
+                    const double pRe = rxRe[m];
+                    const double pIm = rxIm[m];
+                    for (uint64_t s = 0; s < sSize; ++s)
+                    {
+                        accRe[s] += pRe * tRe[s] - pIm * tIm[s];
+                        accIm[s] += pRe * tIm[s] + pIm * tRe[s];
+                    }
+                }
+
+                for (uint64_t s = 0; s < sSize; ++s)
+                {
+                    hUsn(u, s, n) = std::complex<double>(sumRe[s], sumIm[s]) * scale[n];
+                    if (strong)
+                    {
+                        hUsn(u, s, page2[n]) = std::complex<double>(sumRe[sSize + s], sumIm[sSize + s]) * scale[n];
+                        hUsn(u, s, page3[n]) = std::complex<double>(sumRe[2 * sSize + s], sumIm[2 * sSize + s]) * scale[n];
+                    }
+                }
+            }
+
+            if (los)
+            {
+                for (uint64_t s = 0; s < sSize; ++s)
+                {
+                    std::complex<double> ray = losBase * rxLos[u] * txLos[s];
+                    hUsn(u, s, 0) = sqrt(1 / (kLinear + 1)) * hUsn(u, s, 0) +
+                                    sqrt(kLinear / (1 + kLinear)) * ray / losAttenuation;
+                    for (uint8_t n = 1; n < nPages; ++n)
+                    {
+                        hUsn(u, s, n) *= sqrt(1 / (kLinear + 1));
+                    }
+                }
+            }
+        }
+    };
+    m_pool->ParallelFor(uSize, rows);
+
+    NS_LOG_DEBUG("Channel " << uSize << "x" << sSize << "x" << +nPages << " on " << m_pool->GetN() << " threads");
+    channelMatrix->m_channel = hUsn;
+    return channelMatrix;
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+void
+InstallParallelChannelModel(const BandwidthPartInfoPtrVector& bwps, uint32_t threads)
+{
+    for (const auto& bwp : bwps)
+    {
+        Ptr<ThreeGppSpectrumPropagationLossModel> spectrumLoss =
+            DynamicCast<ThreeGppSpectrumPropagationLossModel>(bwp.get()->m_3gppChannel);
+        NS_ABORT_MSG_IF(!spectrumLoss, "The BWP has no 3GPP spectrum propagation loss model");
+
+        PointerValue current;
+        spectrumLoss->GetAttribute("ChannelModel", current);
+        Ptr<ThreeGppChannelModel> old = current.Get<ThreeGppChannelModel>();
+        NS_ABORT_MSG_IF(!old, "The BWP channel model is not a ThreeGppChannelModel");
+
+        DoubleValue frequency;
+        StringValue scenario;
+        PointerValue condition;
+        old->GetAttribute("Frequency", frequency);
+        old->GetAttribute("Scenario", scenario);
+        old->GetAttribute("ChannelConditionModel", condition);
+
+        Ptr<ParallelChannelModel> model = CreateObject<ParallelChannelModel>();
+        model->SetAttribute("Frequency", frequency);
+        model->SetAttribute("Scenario", scenario);
+        model->SetAttribute("ChannelConditionModel", condition);
+        model->SetAttribute("Threads", UintegerValue(threads));
+        spectrumLoss->SetAttribute("ChannelModel", PointerValue(model));
+    }
+}
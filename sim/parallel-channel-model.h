@@ -0,0 +1,116 @@
+#ifndef PARALLEL_CHANNEL_MODEL_H
+#define PARALLEL_CHANNEL_MODEL_H
+
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/nr-module.h"
+#include "ns3/spectrum-module.h"
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Small pool of threads that splits a loop of one event among them. The range [0, n) is always cut
+ * in the same GetN() contiguous parts (the first one runs on the calling thread), so what every
+ * index computes does not depend on the scheduling of the threads.
+ */
+class IntraEventPool
+{
+public:
+    /** Body of the loop, called with [begin, end) */
+    using Job = std::function<void(uint32_t, uint32_t)>;
+
+    /**
+     * @param threads Threads of the pool, the calling one included
+     */
+    explicit IntraEventPool(uint32_t threads);
+    ~IntraEventPool();
+
+    /**
+     * @return Threads of the pool, the calling one included
+     */
+    uint32_t GetN() const;
+
+    /**
+     * @brief Runs job on [0, n) split among the threads, returns when every part is done
+     */
+    void ParallelFor(uint32_t n, const Job& job);
+
+private:
+    /**
+     * @return Part index of [0, n) split in parts
+     */
+    static std::pair<uint32_t, uint32_t> GetRange(uint32_t n, uint32_t parts, uint32_t index);
+
+    void Work(uint32_t index);
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    const Job* m_job;
+    uint32_t m_n;
+    uint64_t m_generation;  //!< Loops started, a worker runs each one once
+    uint32_t m_pending;     //!< Workers still running the current loop
+    bool m_stop;
+};
+
+/* ------------------------------------------------------------------------------------------------- */
+
+/**
+ * 3GPP channel model that generates the channel matrix of large arrays with an IntraEventPool.
+ *
+ * Step 11 of TR 38.901 (what ThreeGppChannelModel::GetNewChannel does) sums, for every pair of
+ * antenna elements and every cluster, the rays of the cluster with the phase of each element; with
+ * the 8x8 gNB and the 2x4 UE arrays that is 512 pairs x ~24 clusters x 20 rays, two sin/cos per
+ * term. Here the element phases are computed once per element and ray instead of once per pair and
+ * ray, and the rows of the matrix (receive elements) are split among the threads. The inner loop is
+ * a complex multiply-accumulate over the transmit elements, on separate real and imaginary arrays so
+ * the compiler vectorizes it.
+ *
+ * Every coefficient is the same sum, in the same order, whatever the number of threads (Threads at 1
+ * runs the same code on the calling thread), so a run gives the same results with Threads at 1 or
+ * at 8. The channel parameters (the random draws) are still generated by ThreeGppChannelModel, only
+ * the matrix is computed here. Links with less than MinElementPairs element pairs use the serial
+ * ThreeGppChannelModel code. The sums do not run in the order of ThreeGppChannelModel, so against a
+ * run without this model the coefficients differ in the last bits.
+ */
+class ParallelChannelModel : public ThreeGppChannelModel
+{
+public:
+    static TypeId GetTypeId();
+    ParallelChannelModel();
+    ~ParallelChannelModel() override;
+
+    void DoDispose() override;
+
+protected:
+    Ptr<ChannelMatrix> GetNewChannel(Ptr<const ThreeGppChannelParams> channelParams,
+                                     Ptr<const ParamsTable> table3gpp,
+                                     const Ptr<const MobilityModel> sMob,
+                                     const Ptr<const MobilityModel> uMob,
+                                     Ptr<const PhasedArrayModel> sAntenna,
+                                     Ptr<const PhasedArrayModel> uAntenna) const override;
+
+private:
+    uint32_t m_threads;     //!< Attribute Threads
+    uint32_t m_minPairs;    //!< Attribute MinElementPairs
+
+    mutable std::unique_ptr<IntraEventPool> m_pool;    //!< Created by the first parallel channel
+};
+
+/**
+ * @brief Replaces the channel model of the 3GPP spectrum propagation model of every BWP by a
+ * ParallelChannelModel with the same frequency, scenario and channel condition model. Call it after
+ * NrHelper::InitializeOperationBand and before installing the devices
+ * @param threads Threads of the pool
+ */
+void InstallParallelChannelModel(const BandwidthPartInfoPtrVector& bwps, uint32_t threads);
+
+#endif // PARALLEL_CHANNEL_MODEL_H
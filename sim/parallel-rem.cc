@@ -0,0 +1,406 @@
+#include "ns3/core-module.h"
+#include "ns3/buildings-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/network-module.h"
+#include "ns3/propagation-module.h"
+
+#include "parallel-rem.h"
+#include "cmdline-colors.h"
+
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("ParallelRemHelper");
+
+NS_OBJECT_ENSURE_REGISTERED(RemChannelConditionModel);
+NS_OBJECT_ENSURE_REGISTERED(ParallelRemHelper);
+
+// Attributes of the path loss copied to the models of the workers, and so part of the cache key
+static const std::vector<std::string> PATHLOSS_ATTRIBUTES = {"Frequency",
+                                                             "ShadowingEnabled",
+                                                             "BuildingPenetrationLossesEnabled",
+                                                             "EnforceParameterRanges"};
+
+TypeId
+RemChannelConditionModel::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::RemChannelConditionModel")
+                            .SetParent<ChannelConditionModel>()
+                            .SetGroupName("MyAppComp")
+                            .AddConstructor<RemChannelConditionModel>();
+    return tid;
+}
+
+RemChannelConditionModel::RemChannelConditionModel()
+    : m_condition(CreateObject<ChannelCondition>())
+{
+    m_condition->SetO2iLowHighCondition(ChannelCondition::LOW);
+}
+
+RemChannelConditionModel::~RemChannelConditionModel()
+{
+}
+
+void
+RemChannelConditionModel::Set(ChannelCondition::LosConditionValue los, ChannelCondition::O2iConditionValue o2i)
+{
+    m_condition->SetLosCondition(los);
+    m_condition->SetO2iCondition(o2i);
+}
+
+Ptr<ChannelCondition>
+RemChannelConditionModel::GetChannelCondition(Ptr<const MobilityModel> a [[maybe_unused]],
+                                              Ptr<const MobilityModel> b [[maybe_unused]]) const
+{
+    return m_condition;
+}
+
+int64_t
+RemChannelConditionModel::AssignStreams(int64_t stream [[maybe_unused]])
+{
+    return 0;
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+TypeId
+ParallelRemHelper::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::ParallelRemHelper")
+            .SetParent<Object>()
+            .SetGroupName("MyAppComp")
+            .AddConstructor<ParallelRemHelper>()
+            .AddAttribute("MinX", "Minimum x of the map (m)", DoubleValue(0),
+                          MakeDoubleAccessor(&ParallelRemHelper::m_minX), MakeDoubleChecker<double>())
+            .AddAttribute("MaxX", "Maximum x of the map (m)", DoubleValue(40),
+                          MakeDoubleAccessor(&ParallelRemHelper::m_maxX), MakeDoubleChecker<double>())
+            .AddAttribute("ResX", "Points along the x axis", UintegerValue(40),
+                          MakeUintegerAccessor(&ParallelRemHelper::m_resX), MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("MinY", "Minimum y of the map (m)", DoubleValue(0),
+                          MakeDoubleAccessor(&ParallelRemHelper::m_minY), MakeDoubleChecker<double>())
+            .AddAttribute("MaxY", "Maximum y of the map (m)", DoubleValue(170),
+                          MakeDoubleAccessor(&ParallelRemHelper::m_maxY), MakeDoubleChecker<double>())
+            .AddAttribute("ResY", "Points along the y axis (rows)", UintegerValue(170),
+                          MakeUintegerAccessor(&ParallelRemHelper::m_resY), MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("Z", "Height of the map (m)", DoubleValue(1.5),
+                          MakeDoubleAccessor(&ParallelRemHelper::m_z), MakeDoubleChecker<double>())
+            .AddAttribute("Threads", "Worker threads, 0: one per hardware thread", UintegerValue(0),
+                          MakeUintegerAccessor(&ParallelRemHelper::m_threads), MakeUintegerChecker<uint32_t>())
+            .AddAttribute("CacheDir", "Directory of the cached maps, empty: no cache", StringValue("../rem-cache"),
+                          MakeStringAccessor(&ParallelRemHelper::m_cacheDir), MakeStringChecker())
+            .AddAttribute("OutputFile", "Map written by Generate", StringValue("nr-rem-rem.out"),
+                          MakeStringAccessor(&ParallelRemHelper::m_output), MakeStringChecker());
+    return tid;
+}
+
+ParallelRemHelper::ParallelRemHelper()
+    : m_minX(0),
+      m_maxX(40),
+      m_resX(40),
+      m_minY(0),
+      m_maxY(170),
+      m_resY(170),
+      m_z(1.5),
+      m_threads(0),
+      m_gnbGain(0),
+      m_ueGain(0)
+{
+}
+
+ParallelRemHelper::~ParallelRemHelper()
+{
+}
+
+void
+ParallelRemHelper::SetAntennaGains(double gnbGainDb, double ueGainDb)
+{
+    m_gnbGain = gnbGainDb;
+    m_ueGain = ueGainDb;
+}
+
+void
+ParallelRemHelper::SetVegetationModel(Ptr<VegetationPropagationLossModel> vegetation)
+{
+    m_vegetation = vegetation;
+}
+
+std::string
+ParallelRemHelper::GetKey(NodeContainer gnbNodes,
+                          Ptr<PropagationLossModel> pathloss,
+                          double txPowerDbm,
+                          double frequency,
+                          double bandwidth,
+                          double noiseFigure) const
+{
+    std::ostringstream key;
+    key << std::setprecision(17);
+    key << "rem3 grid " << m_minX << " " << m_maxX << " " << m_resX << " " << m_minY << " " << m_maxY << " "
+        << m_resY << " " << m_z;
+    key << " radio " << txPowerDbm << " " << frequency << " " << bandwidth << " " << noiseFigure << " "
+        << m_gnbGain << " " << m_ueGain;
+    key << " rng " << RngSeedManager::GetSeed() << " " << RngSeedManager::GetRun();
+
+    auto attributes = [&key](Ptr<Object> object, const std::vector<std::string>& names) {
+        TypeId tid = object->GetInstanceTypeId();
+        key << " " << tid.GetName();
+        for (const std::string& name : names)
+        {
+            TypeId::AttributeInformation info;
+            if (tid.LookupAttributeByName(name, &info))
+            {
+                Ptr<AttributeValue> value = info.checker->Create();
+                object->GetAttribute(name, *value);
+                key << " " << name << "=" << value->SerializeToString(info.checker);
+            }
+        }
+    };
+    attributes(pathloss, PATHLOSS_ATTRIBUTES);
+
+    for (const Vector& pos : m_gnbPositions)
+    {
+        key << " gnb " << pos;
+    }
+    for (BuildingList::Iterator it = BuildingList::Begin(); it != BuildingList::End(); ++it)
+    {
+        Box box = (*it)->GetBoundaries();
+        key << " bld " << box.xMin << " " << box.xMax << " " << box.yMin << " " << box.yMax << " " << box.zMin
+            << " " << box.zMax << " " << (*it)->GetExtWallsType() << " " << +(*it)->GetNFloors();
+    }
+    if (m_vegetation)
+    {
+        attributes(m_vegetation, {"Frequency", "SpecificAttenuation", "MaxAttenuation"});
+        for (uint32_t i = 0; i < VegetationList::GetN(); ++i)
+        {
+            const VegetationObstacle& tree = VegetationList::Get(i);
+            key << " tree " << tree.x << " " << tree.y << " " << tree.radius << " " << tree.zMin << " " << tree.zMax;
+        }
+    }
+    return key.str();
+}
+
+void
+ParallelRemHelper::SetCondition(Worker& worker, const Vector& gnb, const Vector& ue) const
+{
+    // Same geometry as BuildingsChannelConditionModel
+    int32_t gnbIn = -1;
+    int32_t ueIn = -1;
+    bool los = true;
+    for (uint32_t i = 0; i < m_buildings.size(); ++i)
+    {
+        const Box& box = m_buildings[i];
+        if (box.IsInside(gnb))
+        {
+            gnbIn = i;
+        }
+        if (box.IsInside(ue))
+        {
+            ueIn = i;
+        }
+        if (los && box.IsIntersect(gnb, ue))
+        {
+            los = false;
+        }
+    }
+
+    if (gnbIn < 0 && ueIn < 0)
+    {
+        worker.condition->Set(los ? ChannelCondition::LOS : ChannelCondition::NLOS, ChannelCondition::O2O);
+    }
+    else if (gnbIn >= 0 && ueIn >= 0)
+    {
+        worker.condition->Set(gnbIn == ueIn ? ChannelCondition::LOS : ChannelCondition::NLOS, ChannelCondition::I2I);
+    }
+    else
+    {
+        worker.condition->Set(ChannelCondition::NLOS, ChannelCondition::O2I);
+    }
+}
+
+std::string
+ParallelRemHelper::ComputeRow(Worker& worker, uint32_t row, double txPowerDbm, double noiseDbm, double bandwidth) const
+{
+    double stepX = m_resX > 1 ? (m_maxX - m_minX) / (m_resX - 1) : 0;
+    double stepY = m_resY > 1 ? (m_maxY - m_minY) / (m_resY - 1) : 0;
+    double y = m_minY + row * stepY;
+    double noiseMw = std::pow(10, noiseDbm / 10);
+
+    std::ostringstream out;
+    for (uint32_t col = 0; col < m_resX; ++col)
+    {
+        Vector pos(m_minX + col * stepX, y, m_z);
+        worker.ue->SetPosition(pos);
+
+        double bestMw = 0;
+        double totalMw = 0;
+        for (uint32_t g = 0; g < worker.gnbs.size(); ++g)
+        {
+            SetCondition(worker, m_gnbPositions[g], pos);
+            double rxDbm = worker.pathloss->CalcRxPower(txPowerDbm, worker.gnbs[g], worker.ue) + m_gnbGain + m_ueGain;
+            if (m_vegetation)
+            {
+                rxDbm -= m_vegetation->GetLoss(m_gnbPositions[g], pos);
+            }
+            double rxMw = std::pow(10, rxDbm / 10);
+            bestMw = std::max(bestMw, rxMw);
+            totalMw += rxMw;
+        }
+        // Floor of -300 dBm, so a map with one gNB writes numbers instead of -inf/inf
+        double interferenceMw = std::max(totalMw - bestMw, 1e-30);
+
+        out << pos.x << "\t" << pos.y << "\t" << pos.z << "\t" << 10 * std::log10(bestMw / noiseMw) << "\t"
+            << 10 * std::log10(bestMw / (noiseMw + interferenceMw)) << "\t"
+            << 10 * std::log10(interferenceMw / bandwidth) << "\t" << 10 * std::log10(bestMw / interferenceMw)
+            << "\n";
+    }
+    return out.str();
+}
+
+void
+ParallelRemHelper::Generate(NodeContainer gnbNodes,
+                            Ptr<PropagationLossModel> pathloss,
+                            double txPowerDbm,
+                            double frequency,
+                            double bandwidth,
+                            double noiseFigure)
+{
+    auto tic = std::chrono::high_resolution_clock::now();
+
+    m_gnbPositions.clear();
+    for (auto gnb = gnbNodes.Begin(); gnb != gnbNodes.End(); ++gnb)
+    {
+        m_gnbPositions.push_back((*gnb)->GetObject<MobilityModel>()->GetPosition());
+    }
+    m_buildings.clear();
+    for (BuildingList::Iterator it = BuildingList::Begin(); it != BuildingList::End(); ++it)
+    {
+        m_buildings.push_back((*it)->GetBoundaries());
+    }
+
+    uint32_t nThreads = m_threads > 0 ? m_threads : std::max(1u, std::thread::hardware_concurrency());
+    nThreads = std::min(nThreads, m_resY);
+
+    // Cached map
+    std::string cacheFile;
+    if (!m_cacheDir.empty())
+    {
+        std::string key = GetKey(gnbNodes, pathloss, txPowerDbm, frequency, bandwidth, noiseFigure);
+        uint64_t hash = 14695981039346656037ULL;    // FNV-1a
+        for (unsigned char c : key)
+        {
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+        std::ostringstream name;
+        name << m_cacheDir << "/rem-" << std::hex << std::setw(16) << std::setfill('0') << hash << ".out";
+        cacheFile = name.str();
+
+        if (std::filesystem::exists(cacheFile))
+        {
+            std::filesystem::copy_file(cacheFile, m_output, std::filesystem::copy_options::overwrite_existing);
+            std::cout << TXT_CYAN << "REM from cache: " << cacheFile << TXT_CLEAR << std::endl;
+            return;
+        }
+    }
+
+    // Everything a worker uses is created here, ns-3 objects are not thread safe. Every row has its
+    // own loss model and streams, so the shadowing of a row does not depend on the rows computed
+    // before it by the same worker, nor the map on the number of threads
+    NS_ABORT_MSG_IF(!DynamicCast<ThreeGppPropagationLossModel>(pathloss),
+                    "The REM clones a 3GPP propagation loss model, got " << pathloss->GetInstanceTypeId().GetName());
+    std::vector<Worker> workers(nThreads);
+    ObjectFactory factory;
+    factory.SetTypeId(pathloss->GetInstanceTypeId());
+    for (const std::string& name : PATHLOSS_ATTRIBUTES)
+    {
+        TypeId::AttributeInformation info;
+        if (pathloss->GetInstanceTypeId().LookupAttributeByName(name, &info))
+        {
+            Ptr<AttributeValue> value = info.checker->Create();
+            pathloss->GetAttribute(name, *value);
+            factory.Set(name, *value);
+        }
+    }
+    for (uint32_t w = 0; w < nThreads; ++w)
+    {
+        Worker& worker = workers[w];
+        Ptr<Node> ue = CreateObject<Node>();
+        worker.ue = CreateObject<ConstantPositionMobilityModel>();
+        ue->AggregateObject(worker.ue);
+        for (const Vector& pos : m_gnbPositions)
+        {
+            Ptr<Node> gnb = CreateObject<Node>();
+            Ptr<MobilityModel> mobility = CreateObject<ConstantPositionMobilityModel>();
+            mobility->SetPosition(pos);
+            gnb->AggregateObject(mobility);
+            worker.gnbs.push_back(mobility);
+        }
+        worker.condition = CreateObject<RemChannelConditionModel>();
+    }
+    std::vector<Ptr<PropagationLossModel>> rowPathloss(m_resY);
+    for (uint32_t row = 0; row < m_resY; ++row)
+    {
+        rowPathloss[row] = factory.Create<PropagationLossModel>();
+        rowPathloss[row]->SetAttribute("ChannelConditionModel", PointerValue(workers[row % nThreads].condition));
+        rowPathloss[row]->AssignStreams(1000000 + 1000 * row);
+    }
+    VegetationList::BuildIndex(); // Before the threads read it
+
+    double noiseDbm = -174 + 10 * std::log10(bandwidth) + noiseFigure;
+    std::ofstream out(m_output);
+    NS_ABORT_MSG_IF(!out.is_open(), "Can't open file " << m_output);
+
+    // Rows interleaved between the workers and written in order as they finish
+    std::mutex mutex;
+    std::map<uint32_t, std::string> done;
+    uint32_t nextRow = 0;
+    std::vector<std::thread> threads;
+    for (uint32_t w = 0; w < nThreads; ++w)
+    {
+        threads.emplace_back([&, w]() {
+            for (uint32_t row = w; row < m_resY; row += nThreads)
+            {
+                workers[w].pathloss = rowPathloss[row];
+                std::string text = ComputeRow(workers[w], row, txPowerDbm, noiseDbm, bandwidth);
+                std::lock_guard<std::mutex> lock(mutex);
+                done[row] = std::move(text);
+                for (auto it = done.find(nextRow); it != done.end(); it = done.find(nextRow))
+                {
+                    out << it->second;
+                    done.erase(it);
+                    nextRow++;
+                }
+                out.flush();
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    out.close();
+
+    if (!cacheFile.empty())
+    {
+        // Copied under another name and renamed, a map in the cache is always complete
+        std::filesystem::create_directories(m_cacheDir);
+        std::string tmp = cacheFile + ".tmp" + std::to_string(getpid());
+        std::filesystem::copy_file(m_output, tmp, std::filesystem::copy_options::overwrite_existing);
+        std::filesystem::rename(tmp, cacheFile);
+    }
+
+    auto toc = std::chrono::high_resolution_clock::now();
+    std::cout << TXT_CYAN << "REM: " << m_resX << "x" << m_resY << " points, " << m_gnbPositions.size() << " gNbs, "
+              << nThreads << " threads, "
+              << 1.e-9 * std::chrono::duration_cast<std::chrono::nanoseconds>(toc - tic).count() << " s"
+              << TXT_CLEAR << std::endl;
+}
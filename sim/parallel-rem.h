@@ -0,0 +1,138 @@
+#ifndef PARALLEL_REM_H
+#define PARALLEL_REM_H
+
+#include "ns3/core-module.h"
+#include "ns3/buildings-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/network-module.h"
+#include "ns3/propagation-module.h"
+
+#include "vegetation.h"
+
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Channel condition set by hand before each link of the map (the worker computes it from the
+ * buildings), ThreeGpp condition models would draw it once per link and keep it for every point.
+ */
+class RemChannelConditionModel : public ChannelConditionModel
+{
+public:
+    static TypeId GetTypeId();
+    RemChannelConditionModel();
+    ~RemChannelConditionModel() override;
+
+    void Set(ChannelCondition::LosConditionValue los, ChannelCondition::O2iConditionValue o2i);
+
+    Ptr<ChannelCondition> GetChannelCondition(Ptr<const MobilityModel> a,
+                                              Ptr<const MobilityModel> b) const override;
+
+    int64_t AssignStreams(int64_t stream) override;
+
+private:
+    Ptr<ChannelCondition> m_condition;
+};
+
+/**
+ * Radio environment map of the gNBs over a grid at a fixed height, computed by a pool of threads.
+ *
+ * Every point is an independent link budget: the propagation loss model of the BWP (3GPP path loss
+ * and shadowing), the LoS/O2I condition from the buildings, the foliage loss and the array gain of
+ * the (ideal, direct path) beams. The point gets the SNR of its best gNB and the SINR with every
+ * other gNB transmitting, in the format of NrRadioEnvironmentMapHelper (X Y Z SNR SINR IPSD SIR,
+ * tab separated), so graph.py plots it as before.
+ *
+ * ns-3 objects are not thread safe, so each worker owns its condition model and the nodes of its
+ * links, and each row its 3GPP propagation loss model (with its own random streams, the map does not
+ * depend on the number of threads), all created before the threads start. The workers read the
+ * buildings from a copy of their geometry. The rows are written in order as soon as they are done.
+ *
+ * The map is cached in CacheDir under a hash of everything it depends on (buildings, vegetation,
+ * gNB positions, antenna gains, power, frequency, bandwidth, grid, propagation model and RngRun),
+ * so another run of the same scenario (other AMC, other traffic) copies it instead of computing it.
+ */
+class ParallelRemHelper : public Object
+{
+public:
+    static TypeId GetTypeId();
+    ParallelRemHelper();
+    ~ParallelRemHelper() override;
+
+    /**
+     * @brief Array gain (dB) of the gNB and UE beams
+     */
+    void SetAntennaGains(double gnbGainDb, double ueGainDb);
+
+    /**
+     * @brief Adds the foliage loss of the vegetation to every link
+     */
+    void SetVegetationModel(Ptr<VegetationPropagationLossModel> vegetation);
+
+    /**
+     * @brief Writes the map to OutputFile, from the cache when possible
+     * @param gnbNodes Transmitters
+     * @param pathloss 3GPP propagation loss model of the BWP (its type and attributes are cloned)
+     * @param txPowerDbm Transmission power of every gNB
+     * @param frequency Carrier frequency (Hz)
+     * @param bandwidth Bandwidth (Hz), for the noise power
+     * @param noiseFigure Noise figure of the receiver (dB)
+     */
+    void Generate(NodeContainer gnbNodes,
+                  Ptr<PropagationLossModel> pathloss,
+                  double txPowerDbm,
+                  double frequency,
+                  double bandwidth,
+                  double noiseFigure);
+
+private:
+    /** Propagation state owned by one thread */
+    struct Worker
+    {
+        Ptr<MobilityModel> ue;
+        std::vector<Ptr<MobilityModel>> gnbs;
+        Ptr<PropagationLossModel> pathloss;     //!< Model of the row being computed
+        Ptr<RemChannelConditionModel> condition;
+    };
+
+    /**
+     * @return Key of the map, everything its values depend on
+     */
+    std::string GetKey(NodeContainer gnbNodes,
+                       Ptr<PropagationLossModel> pathloss,
+                       double txPowerDbm,
+                       double frequency,
+                       double bandwidth,
+                       double noiseFigure) const;
+
+    /**
+     * @brief Computes one row of the map
+     */
+    std::string ComputeRow(Worker& worker, uint32_t row, double txPowerDbm, double noiseDbm, double bandwidth) const;
+
+    /**
+     * @brief LoS and O2I condition of a link from the copy of the buildings
+     */
+    void SetCondition(Worker& worker, const Vector& gnb, const Vector& ue) const;
+
+    double m_minX;          //!< Attribute MinX
+    double m_maxX;          //!< Attribute MaxX
+    uint32_t m_resX;        //!< Attribute ResX
+    double m_minY;          //!< Attribute MinY
+    double m_maxY;          //!< Attribute MaxY
+    uint32_t m_resY;        //!< Attribute ResY
+    double m_z;             //!< Attribute Z
+    uint32_t m_threads;     //!< Attribute Threads
+    std::string m_cacheDir; //!< Attribute CacheDir
+    std::string m_output;   //!< Attribute OutputFile
+
+    double m_gnbGain;
+    double m_ueGain;
+    Ptr<VegetationPropagationLossModel> m_vegetation;
+    std::vector<Box> m_buildings;           //!< Copy of the buildings, read by every thread
+    std::vector<Vector> m_gnbPositions;
+};
+
+#endif // PARALLEL_REM_H
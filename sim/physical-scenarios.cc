@@ -9,11 +9,63 @@
 #include "cmdline-colors.h"
 
 #include "physical-scenarios.h"
+#include "vegetation.h"
+
+#include <random>
+#include <set>
 
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("PhysicalDistro");
 
+// Buildings that model trees (legacy trees, when the vegetation model is not used)
+static std::set<uint32_t> s_treeBuildings;
+
+/**
+ * @brief Creates a grid of trees (same layout as a ROW_FIRST GridBuildingAllocator). With vegetation
+ * every tree is a cylinder of foliage of the VegetationList inscribed in its box, if not it is a Wood
+ * building with nRooms x nRooms rooms
+ */
+static void
+CreateTrees(bool vegetation, uint32_t numOfTrees, uint32_t gridWidth, double minX, double minY,
+            double lx, double ly, double dx, double dy, double height, uint32_t nRooms)
+{
+    if (vegetation)
+    {
+        for (uint32_t i = 0; i < numOfTrees; ++i)
+        {
+            double x = minX + (i % gridWidth) * (lx + dx);
+            double y = minY + (i / gridWidth) * (ly + dy);
+            VegetationList::Add(x + lx / 2, y + ly / 2, std::min(lx, ly) / 2, 0, height);
+        }
+        return;
+    }
+
+    uint32_t before = BuildingList::GetNBuildings();
+
+    Ptr<GridBuildingAllocator> gridBuildingAllocator = CreateObject<GridBuildingAllocator>();
+    gridBuildingAllocator->SetAttribute("GridWidth", UintegerValue(gridWidth)); // The number of objects laid out on a line. 1 as a column of building
+    gridBuildingAllocator->SetAttribute("MinX", DoubleValue(minX)); // The x coordinate where the grid starts.
+    gridBuildingAllocator->SetAttribute("MinY", DoubleValue(minY)); // The y coordinate where the grid starts.
+    gridBuildingAllocator->SetAttribute("LengthX", DoubleValue(lx)); // the length of the wall of each building along the X axis.
+    gridBuildingAllocator->SetAttribute("LengthY", DoubleValue(ly)); // the length of the wall of each building along the Y axis.
+    gridBuildingAllocator->SetAttribute("DeltaX", DoubleValue(dx)); // The x space between buildings.
+    gridBuildingAllocator->SetAttribute("DeltaY", DoubleValue(dy)); // The y space between buildings.
+    gridBuildingAllocator->SetAttribute("Height", DoubleValue(height)); // The height of the building (roof level)
+    gridBuildingAllocator->SetAttribute("LayoutType", EnumValue (GridPositionAllocator::ROW_FIRST)); // The type of layout. ROW_FIRST COLUMN_FIRST
+
+    gridBuildingAllocator->SetBuildingAttribute("NRoomsX", UintegerValue(nRooms));
+    gridBuildingAllocator->SetBuildingAttribute("NRoomsY", UintegerValue(nRooms));
+    gridBuildingAllocator->SetBuildingAttribute("NFloors", UintegerValue(1));
+    gridBuildingAllocator->SetBuildingAttribute("ExternalWallsType", EnumValue(Building::Wood));
+    gridBuildingAllocator->Create(numOfTrees);
+
+    for (uint32_t i = before; i < BuildingList::GetNBuildings(); ++i)
+    {
+        s_treeBuildings.insert(BuildingList::GetBuilding(i)->GetId());
+    }
+}
+
 // Currently creates a gnuplot file, to be updated later into a json file that will be 
 // parseable by matplotlib. 
 void 
@@ -29,12 +81,16 @@ PrintPhysicalDistributionToJson(NodeContainer& gnbNodes, std::string extraData)
     }
     outFile << predata << std::endl;
     uint32_t index = 0;
+    uint32_t total = BuildingList::GetNBuildings() + VegetationList::GetN();
     for (BuildingList::Iterator it = BuildingList::Begin(); it != BuildingList::End(); ++it)
     {
         ++index;
         Ptr<Building> blding = *it;
         Box box = blding->GetBoundaries();
+        bool isTree = s_treeBuildings.count(blding->GetId()) > 0;
         outFile << "\t{\n\t\t\"id\" : " << index << ", " << std::endl;
+        outFile << "\t\t\"type\" : \"" << (isTree ? "tree" : "building") << "\"," << std::endl;
+        outFile << "\t\t\"shape\" : \"box\"," << std::endl;
         outFile << "\t\t\"xmin\" : " << box.xMin << "," << std::endl;
         outFile << "\t\t\"xmax\" : " << box.xMax << "," << std::endl;
         outFile << "\t\t\"xwidth\" : " << box.xMax - box.xMin << "," << std::endl;
@@ -49,7 +105,7 @@ PrintPhysicalDistributionToJson(NodeContainer& gnbNodes, std::string extraData)
         outFile << "\t\t\"nroomsY\" : " << blding->GetNRoomsY() << "," << std::endl;
         outFile << "\t\t\"nfloors\" : " << blding->GetNFloors() << "\n\t}";
         
-        if (index == BuildingList::GetNBuildings())
+        if (index == total)
         {
             outFile << std::endl;
         }
@@ -60,6 +116,27 @@ PrintPhysicalDistributionToJson(NodeContainer& gnbNodes, std::string extraData)
 
     }
 
+    // Vegetation, same fields as a building (its bounding box) plus its radius
+    for (uint32_t v = 0; v < VegetationList::GetN(); ++v)
+    {
+        ++index;
+        const VegetationObstacle& tree = VegetationList::Get(v);
+        outFile << "\t{\n\t\t\"id\" : " << index << ", " << std::endl;
+        outFile << "\t\t\"type\" : \"tree\"," << std::endl;
+        outFile << "\t\t\"shape\" : \"cylinder\"," << std::endl;
+        outFile << "\t\t\"radius\" : " << tree.radius << "," << std::endl;
+        outFile << "\t\t\"xmin\" : " << tree.x - tree.radius << "," << std::endl;
+        outFile << "\t\t\"xmax\" : " << tree.x + tree.radius << "," << std::endl;
+        outFile << "\t\t\"xwidth\" : " << 2 * tree.radius << "," << std::endl;
+        outFile << "\t\t\"ymin\" : " << tree.y - tree.radius << "," << std::endl;
+        outFile << "\t\t\"ymax\" : " << tree.y + tree.radius << "," << std::endl;
+        outFile << "\t\t\"ywidth\" : " << 2 * tree.radius << "," << std::endl;
+        outFile << "\t\t\"zmin\" : " << tree.zMin << "," << std::endl;
+        outFile << "\t\t\"zmax\" : " << tree.zMax << "," << std::endl;
+        outFile << "\t\t\"zwidth\" : " << tree.zMax - tree.zMin << "\n\t}";
+        outFile << (index == total ? "" : ",") << std::endl;
+    }
+
     // Close building dict
     outFile << "]," << std::endl;
 
@@ -85,7 +162,12 @@ PrintPhysicalDistributionToJson(NodeContainer& gnbNodes, std::string extraData)
 
     }
 
-    outFile << "],\n" << extraData << "\n}" << std::endl;
+    outFile << "]";
+    if (!extraData.empty())
+    {
+        outFile << ",\n" << extraData;
+    }
+    outFile << "\n}" << std::endl;
     outFile.close();
 }
 
@@ -219,7 +301,7 @@ DefaultPhysicalDistribution(ns3::NodeContainer& gnbNodes, ns3::NodeContainer& ue
 }
 
 void 
-TreePhysicalDistribution(ns3::NodeContainer& gnbNodes, ns3::NodeContainer& ueNodes, double mobility)
+TreePhysicalDistribution(ns3::NodeContainer& gnbNodes, ns3::NodeContainer& ueNodes, double mobility, bool vegetation)
 {
     
     double speed = 1;               // in m/s for walking UT.
@@ -302,23 +384,7 @@ TreePhysicalDistribution(ns3::NodeContainer& gnbNodes, ns3::NodeContainer& ueNod
     {
         std::cout << TXT_CYAN << "Installing Building" << TXT_CLEAR << std::endl;
 
-        Ptr<GridBuildingAllocator> gridBuildingAllocator;
-        gridBuildingAllocator = CreateObject<GridBuildingAllocator>();
-        gridBuildingAllocator->SetAttribute("GridWidth", UintegerValue(gridWidth)); // The number of objects laid out on a line. 1 as a column of building
-        gridBuildingAllocator->SetAttribute("MinX", DoubleValue(buildX)); // The x coordinate where the grid starts.
-        gridBuildingAllocator->SetAttribute("MinY", DoubleValue(buildY)); // The y coordinate where the grid starts.
-        gridBuildingAllocator->SetAttribute("LengthX", DoubleValue(buildLx)); // the length of the wall of each building along the X axis.
-        gridBuildingAllocator->SetAttribute("LengthY", DoubleValue(buildLy)); // the length of the wall of each building along the X axis.
-        gridBuildingAllocator->SetAttribute("DeltaX", DoubleValue(buildDx)); // The x space between buildings.
-        gridBuildingAllocator->SetAttribute("DeltaY", DoubleValue(buildDy)); // The y space between buildings.
-        gridBuildingAllocator->SetAttribute("Height", DoubleValue(height)); // The height of the building (roof level)
-        gridBuildingAllocator->SetAttribute("LayoutType", EnumValue (GridPositionAllocator::ROW_FIRST)); // The type of layout. ROW_FIRST COLUMN_FIRST
-
-        gridBuildingAllocator->SetBuildingAttribute("NRoomsX", UintegerValue(nApartments));
-        gridBuildingAllocator->SetBuildingAttribute("NRoomsY", UintegerValue(nApartments));
-        gridBuildingAllocator->SetBuildingAttribute("NFloors", UintegerValue(nFloors));
-        gridBuildingAllocator->SetBuildingAttribute("ExternalWallsType", EnumValue(Building::Wood));
-        gridBuildingAllocator->Create(numOfTrees);
+        CreateTrees(vegetation, numOfTrees, gridWidth, buildX, buildY, buildLx, buildLy, buildDx, buildDy, height, nApartments);
 
         // // position of the Buildings
         // Ptr<ListPositionAllocator> buildingPositionAlloc = CreateObject<ListPositionAllocator>();
@@ -333,23 +399,7 @@ TreePhysicalDistribution(ns3::NodeContainer& gnbNodes, ns3::NodeContainer& ueNod
         double buildX=12; // Initial X Position
         double buildY=35.0; // Initial Y Position
 
-        Ptr<GridBuildingAllocator> gridBuildingAllocator_2;
-        gridBuildingAllocator_2 = CreateObject<GridBuildingAllocator>();
-        gridBuildingAllocator_2->SetAttribute("GridWidth", UintegerValue(gridWidth)); // The number of objects laid out on a line. 1 as a column of building
-        gridBuildingAllocator_2->SetAttribute("MinX", DoubleValue(buildX)); // The x coordinate where the grid starts.
-        gridBuildingAllocator_2->SetAttribute("MinY", DoubleValue(buildY)); // The y coordinate where the grid starts.
-        gridBuildingAllocator_2->SetAttribute("LengthX", DoubleValue(buildLx)); // the length of the wall of each building along the X axis.
-        gridBuildingAllocator_2->SetAttribute("LengthY", DoubleValue(buildLy)); // the length of the wall of each building along the X axis.
-        gridBuildingAllocator_2->SetAttribute("DeltaX", DoubleValue(buildDx)); // The x space between buildings.
-        gridBuildingAllocator_2->SetAttribute("DeltaY", DoubleValue(buildDy)); // The y space between buildings.
-        gridBuildingAllocator_2->SetAttribute("Height", DoubleValue(height)); // The height of the building (roof level)
-        gridBuildingAllocator_2->SetAttribute("LayoutType", EnumValue (GridPositionAllocator::ROW_FIRST)); // The type of layout. ROW_FIRST COLUMN_FIRST
-
-        gridBuildingAllocator_2->SetBuildingAttribute("NRoomsX", UintegerValue(nApartments));
-        gridBuildingAllocator_2->SetBuildingAttribute("NRoomsY", UintegerValue(nApartments));
-        gridBuildingAllocator_2->SetBuildingAttribute("NFloors", UintegerValue(nFloors));
-        gridBuildingAllocator_2->SetBuildingAttribute("ExternalWallsType", EnumValue(Building::Wood));
-        gridBuildingAllocator_2->Create(numOfTrees);
+        CreateTrees(vegetation, numOfTrees, gridWidth, buildX, buildY, buildLx, buildLy, buildDx, buildDy, height, nApartments);
         
         BuildingsHelper::Install(gnbNodes);
         BuildingsHelper::Install(ueNodes);
@@ -357,7 +407,7 @@ TreePhysicalDistribution(ns3::NodeContainer& gnbNodes, ns3::NodeContainer& ueNod
         std::cout << TXT_CYAN << "Installed Tree distribution." << TXT_CLEAR << std::endl;
     }
 
-    PrintPhysicalDistributionToJson(gnbNodes, "\"istree\" : 1");
+    PrintPhysicalDistributionToJson(gnbNodes);
 }
 
 void 
@@ -492,7 +542,7 @@ IndoorRouterPhysicalDistribution(ns3::NodeContainer& gnbNodes, ns3::NodeContaine
 }
 
 void 
-NeighborhoodPhysicalDistribution(ns3::NodeContainer& gnbNodes, ns3::NodeContainer& ueNodes)
+NeighborhoodPhysicalDistribution(ns3::NodeContainer& gnbNodes, ns3::NodeContainer& ueNodes, bool vegetation)
 {
     
     std::string scenario = "UMa";   // scenario
@@ -635,40 +685,10 @@ NeighborhoodPhysicalDistribution(ns3::NodeContainer& gnbNodes, ns3::NodeContaine
         gridBuildingAllocator1->Create(numOfBuildings);
 
         std::cout << TXT_CYAN << "Installing Trees" << TXT_CLEAR << std::endl;
-        Ptr<GridBuildingAllocator> gridBuildingAllocator2;
-        gridBuildingAllocator2 = CreateObject<GridBuildingAllocator>();
-        gridBuildingAllocator2->SetAttribute("LayoutType", EnumValue (GridPositionAllocator::ROW_FIRST)); // The type of layout. ROW_FIRST COLUMN_FIRST
-        gridBuildingAllocator2->SetAttribute("GridWidth", UintegerValue(treegridWidth));
-        gridBuildingAllocator2->SetAttribute("MinX", DoubleValue(treeX));
-        gridBuildingAllocator2->SetAttribute("MinY", DoubleValue(treeY));
-        gridBuildingAllocator2->SetAttribute("LengthX", DoubleValue(treeLx)); // the length of the wall of each building along the X axis.
-        gridBuildingAllocator2->SetAttribute("LengthY", DoubleValue(treeLy)); // the length of the wall of each building along the Y axis.
-        gridBuildingAllocator2->SetAttribute("DeltaX", DoubleValue(treeDx)); // The x space between buildings.
-        gridBuildingAllocator2->SetAttribute("DeltaY", DoubleValue(treeDy)); // The y space between buildings.
-        gridBuildingAllocator2->SetAttribute("Height", DoubleValue(treeLz)); // The height of the building (roof level)
-        gridBuildingAllocator2->SetBuildingAttribute("NRoomsX", UintegerValue(1));
-        gridBuildingAllocator2->SetBuildingAttribute("NRoomsY", UintegerValue(1));
-        gridBuildingAllocator2->SetBuildingAttribute("NFloors", UintegerValue(1));
-        gridBuildingAllocator2->SetBuildingAttribute("ExternalWallsType", EnumValue(Building::Wood));
-        gridBuildingAllocator2->Create(numOfTrees);
+        CreateTrees(vegetation, numOfTrees, treegridWidth, treeX, treeY, treeLx, treeLy, treeDx, treeDy, treeLz, 1);
 
         treeY = treeY+0.6 + 14 + 0.6; // Initial Y Position
-        Ptr<GridBuildingAllocator> gridBuildingAllocator3;
-        gridBuildingAllocator3 = CreateObject<GridBuildingAllocator>();
-        gridBuildingAllocator3->SetAttribute("LayoutType", EnumValue (GridPositionAllocator::ROW_FIRST)); // The type of layout. ROW_FIRST COLUMN_FIRST
-        gridBuildingAllocator3->SetAttribute("GridWidth", UintegerValue(treegridWidth));
-        gridBuildingAllocator3->SetAttribute("MinX", DoubleValue(treeX));
-        gridBuildingAllocator3->SetAttribute("MinY", DoubleValue(treeY));
-        gridBuildingAllocator3->SetAttribute("LengthX", DoubleValue(treeLx)); // the length of the wall of each building along the X axis.
-        gridBuildingAllocator3->SetAttribute("LengthY", DoubleValue(treeLy)); // the length of the wall of each building along the Y axis.
-        gridBuildingAllocator3->SetAttribute("DeltaX", DoubleValue(treeDx)); // The x space between buildings.
-        gridBuildingAllocator3->SetAttribute("DeltaY", DoubleValue(treeDy)); // The y space between buildings.
-        gridBuildingAllocator3->SetAttribute("Height", DoubleValue(treeLz)); // The height of the building (roof level)
-        gridBuildingAllocator3->SetBuildingAttribute("NRoomsX", UintegerValue(1));
-        gridBuildingAllocator3->SetBuildingAttribute("NRoomsY", UintegerValue(1));
-        gridBuildingAllocator3->SetBuildingAttribute("NFloors", UintegerValue(1));
-        gridBuildingAllocator3->SetBuildingAttribute("ExternalWallsType", EnumValue(Building::Wood));
-        gridBuildingAllocator3->Create(numOfTrees);
+        CreateTrees(vegetation, numOfTrees, treegridWidth, treeX, treeY, treeLx, treeLy, treeDx, treeDy, treeLz, 1);
 
         BuildingsHelper::Install(gnbNodes);
         BuildingsHelper::Install(ueNodes);
@@ -679,3 +699,176 @@ NeighborhoodPhysicalDistribution(ns3::NodeContainer& gnbNodes, ns3::NodeContaine
 
     PrintPhysicalDistributionToJson(gnbNodes);
 }
+
+/**
+ * @brief Turns a pedestrian back at the end of its sidewalk and schedules the next turn, after
+ * walking the whole sidewalk again
+ */
+static void
+TurnPedestrian(Ptr<ConstantVelocityMobilityModel> model, Time walk)
+{
+    Vector v = model->GetVelocity();
+    model->SetVelocity(Vector(-v.x, -v.y, -v.z));
+    Simulator::Schedule(walk, &TurnPedestrian, model, walk);
+}
+
+void
+StreetGridPhysicalDistribution(ns3::NodeContainer& gnbNodes, ns3::NodeContainer& ueNodes, const StreetGridOptions& options)
+{
+    double hBS = 25;        // base station antenna height in meters (UMa)
+    double hUE = 1.5;       // user antenna height in meters
+    double speed = options.mobility ? 1.4 : 0; // walking speed in m/s
+
+    double treeL = 2;       // Side of the box of a tree (m)
+    double treeHeight = 7;  // Height of the trees (m)
+    double buildGap = 4;    // Distance between the buildings of a block (m)
+
+    NS_ABORT_MSG_IF(options.blocksX == 0 || options.blocksY == 0, "The street grid needs at least one block");
+    NS_ABORT_MSG_IF(options.blockSize <= 2 * options.sidewalkWidth + (options.buildingsPerSide + 1) * buildGap,
+                    "Blocks too small for their sidewalks and buildings");
+    NS_ABORT_MSG_IF(options.treeSpacing > 0 && (options.treeSpacing < treeL || options.sidewalkWidth <= treeL),
+                    "Trees closer than their size or wider than the sidewalk");
+
+    double period = options.blockSize + options.streetWidth;    // One block and one street
+    double sizeX = options.blocksX * period + options.streetWidth;
+    double sizeY = options.blocksY * period + options.streetWidth;
+    std::mt19937 rng(options.seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    // Set position of the base stations, every gNbD meters from the first intersection
+    std::cout << TXT_CYAN << "Positioning Nodes" << TXT_CLEAR << std::endl;
+    uint32_t gnbCols = std::max<uint32_t>(1, static_cast<uint32_t>(sizeX / options.gNbD) + 1);
+    Ptr<ListPositionAllocator> gnbPositionAlloc = CreateObject<ListPositionAllocator>();
+    for (uint32_t u = 0; u < gnbNodes.GetN(); ++u)
+    {
+        double x = options.streetWidth / 2 + (u % gnbCols) * options.gNbD;
+        double y = options.streetWidth / 2 + (u / gnbCols) * options.gNbD;
+        std::cout << "gNb: " << u << "\t" << "(" << x << "," << y << ")" << std::endl;
+        gnbPositionAlloc->Add(Vector(x, y, hBS));
+    }
+
+    MobilityHelper enbmobility;
+    enbmobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    enbmobility.SetPositionAllocator(gnbPositionAlloc);
+    enbmobility.Install(gnbNodes);
+
+    /********************************************************************************************************************
+     * Create and install buildings
+     ********************************************************************************************************************/
+    std::cout << TXT_CYAN << "Installing Buildings" << TXT_CLEAR << std::endl;
+    double inner = options.blockSize - 2 * options.sidewalkWidth;     // Side of the block without sidewalks
+    double buildL = (inner - (options.buildingsPerSide + 1) * buildGap) / options.buildingsPerSide;
+    std::vector<Ptr<Building>> buildings;
+    buildings.reserve(options.blocksX * options.blocksY * options.buildingsPerSide * options.buildingsPerSide);
+
+    for (uint32_t bx = 0; bx < options.blocksX; ++bx)
+    {
+        for (uint32_t by = 0; by < options.blocksY; ++by)
+        {
+            double blockX = options.streetWidth + bx * period;
+            double blockY = options.streetWidth + by * period;
+
+            for (uint32_t i = 0; i < options.buildingsPerSide * options.buildingsPerSide; ++i)
+            {
+                double x = blockX + options.sidewalkWidth + buildGap + (i % options.buildingsPerSide) * (buildL + buildGap);
+                double y = blockY + options.sidewalkWidth + buildGap + (i / options.buildingsPerSide) * (buildL + buildGap);
+                Ptr<Building> building = CreateObject<Building>();
+                building->SetBoundaries(Box(x, x + buildL, y, y + buildL, 0, 3 * options.nFloors));
+                building->SetBuildingType(Building::Residential);
+                building->SetExtWallsType(Building::ConcreteWithWindows);
+                building->SetNFloors(options.nFloors);
+                building->SetNRoomsX(2);
+                building->SetNRoomsY(2);
+                buildings.push_back(building);
+            }
+
+            // Trees on the curb side of the four sidewalks
+            if (options.treeSpacing > 0)
+            {
+                uint32_t nTrees = static_cast<uint32_t>((options.blockSize - treeL) / options.treeSpacing) + 1;
+                double gap = options.treeSpacing - treeL;
+                double far = options.blockSize - treeL;
+                CreateTrees(options.vegetation, nTrees, nTrees, blockX, blockY, treeL, treeL, gap, gap, treeHeight, 1);
+                CreateTrees(options.vegetation, nTrees, nTrees, blockX, blockY + far, treeL, treeL, gap, gap, treeHeight, 1);
+                if (nTrees > 2)
+                {
+                    CreateTrees(options.vegetation, nTrees - 2, 1, blockX, blockY + options.treeSpacing, treeL, treeL, gap, gap, treeHeight, 1);
+                    CreateTrees(options.vegetation, nTrees - 2, 1, blockX + far, blockY + options.treeSpacing, treeL, treeL, gap, gap, treeHeight, 1);
+                }
+            }
+        }
+    }
+
+    // position the mobile terminals and enable the mobility
+    MobilityHelper uemobility;
+    uemobility.SetMobilityModel("ns3::ConstantVelocityMobilityModel");
+    uemobility.Install(ueNodes);
+
+    uint32_t nIndoor = static_cast<uint32_t>(std::round(ueNodes.GetN() * options.indoorRatio));
+    for (uint32_t u = 0; u < ueNodes.GetN(); ++u)
+    {
+        Vector pos;
+        Vector velocity(0, 0, 0);
+        if (u < nIndoor)
+        {
+            // Random building, floor and position inside (away from the walls)
+            Box box = buildings[static_cast<size_t>(uniform(rng) * buildings.size()) % buildings.size()]->GetBoundaries();
+            uint32_t floor = static_cast<uint32_t>(uniform(rng) * options.nFloors) % options.nFloors;
+            pos = Vector(box.xMin + 1 + uniform(rng) * (box.xMax - box.xMin - 2),
+                         box.yMin + 1 + uniform(rng) * (box.yMax - box.yMin - 2),
+                         3 * floor + hUE);
+        }
+        else
+        {
+            // Random block and side, in the free part of the sidewalk and walking along it. The
+            // sidewalk ends at the corners of the block, there the pedestrian turns back
+            uint32_t block = static_cast<uint32_t>(uniform(rng) * options.blocksX * options.blocksY) % (options.blocksX * options.blocksY);
+            double blockX = options.streetWidth + (block % options.blocksX) * period;
+            double blockY = options.streetWidth + (block / options.blocksX) * period;
+            double middle = options.treeSpacing > 0 ? (treeL + options.sidewalkWidth) / 2 : options.sidewalkWidth / 2;
+            double along = middle + uniform(rng) * (options.blockSize - 2 * middle);
+            double direction = uniform(rng) < 0.5 ? -speed : speed;
+            switch (static_cast<uint32_t>(uniform(rng) * 4) % 4)
+            {
+            case 0:
+                pos = Vector(blockX + along, blockY + middle, hUE);
+                velocity = Vector(direction, 0, 0);
+                break;
+            case 1:
+                pos = Vector(blockX + along, blockY + options.blockSize - middle, hUE);
+                velocity = Vector(direction, 0, 0);
+                break;
+            case 2:
+                pos = Vector(blockX + middle, blockY + along, hUE);
+                velocity = Vector(0, direction, 0);
+                break;
+            default:
+                pos = Vector(blockX + options.blockSize - middle, blockY + along, hUE);
+                velocity = Vector(0, direction, 0);
+                break;
+            }
+
+            if (speed > 0)
+            {
+                // First turn at the end it walks to, in the context of the UE so in the distributed
+                // mode the turns only run in its rank
+                double toEnd = direction > 0 ? options.blockSize - middle - along : along - middle;
+                Time walk = Seconds((options.blockSize - 2 * middle) / speed);
+                Simulator::ScheduleWithContext(ueNodes.Get(u)->GetId(), Seconds(toEnd / speed), &TurnPedestrian,
+                                               ueNodes.Get(u)->GetObject<ConstantVelocityMobilityModel>(), walk);
+            }
+        }
+        ueNodes.Get(u)->GetObject<MobilityModel>()->SetPosition(pos);
+        ueNodes.Get(u)->GetObject<ConstantVelocityMobilityModel>()->SetVelocity(velocity);
+    }
+
+    BuildingsHelper::Install(gnbNodes);
+    BuildingsHelper::Install(ueNodes);
+
+    std::cout << TXT_CYAN << "Installed Street grid distribution: " << options.blocksX << "x" << options.blocksY
+              << " blocks, " << buildings.size() << " buildings, " << BuildingList::GetNBuildings() - buildings.size()
+              << " + " << VegetationList::GetN() << " trees, " << gnbNodes.GetN() << " gNbs, "
+              << ueNodes.GetN() - nIndoor << " pedestrian and " << nIndoor << " indoor UEs" << TXT_CLEAR << std::endl;
+
+    PrintPhysicalDistributionToJson(gnbNodes);
+}
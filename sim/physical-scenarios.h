@@ -13,14 +13,36 @@ using namespace ns3;
         DEFAULT,
         TREES,
         IND_ROUTER,
-        NEIGHBORHOOD
+        NEIGHBORHOOD,
+        STREET_GRID
+    };
+
+    /**
+     * Parameters of the STREET_GRID scenario (see StreetGridPhysicalDistribution)
+    */
+    struct StreetGridOptions
+    {
+        uint32_t blocksX = 3;           // Blocks along the x axis (N)
+        uint32_t blocksY = 3;           // Blocks along the y axis (M)
+        double blockSize = 60;          // Side of a block, sidewalks included (m)
+        double streetWidth = 14;        // Width of the streets between blocks (m)
+        double sidewalkWidth = 3;       // Width of the sidewalk around a block (m)
+        uint32_t buildingsPerSide = 2;  // A block has buildingsPerSide x buildingsPerSide buildings
+        uint32_t nFloors = 4;           // Floors of every building (3 m each)
+        double treeSpacing = 10;        // Distance between the trees of a sidewalk, 0: no trees (m)
+        double indoorRatio = 0.3;       // Fraction of the UEs that are static inside a building
+        double gNbD = 80;               // Distance between gNbs (m)
+        uint32_t seed = 1;              // Seed of the positions of the UEs, the layout only depends on it
+        bool mobility = true;           // Pedestrians walk (1.4 m/s) back and forth along their sidewalk
+        bool vegetation = false;        // Trees as cylinders of foliage instead of wood buildings
     };
     
     /**
      * @brief Function to print a distribution information as a JSON file so we can graph the
-     * scenario later, it should be function agnostic
+     * scenario later, it should be function agnostic. Every obstacle has a "type" ("building" or
+     * "tree") and a "shape" ("box" or "cylinder" for the vegetation)
     */
-    void PrintPhysicalDistributionToJson(NodeContainer& gnbNodes, std::string extraData="\"istree\" : 0" );
+    void PrintPhysicalDistributionToJson(NodeContainer& gnbNodes, std::string extraData="" );
 
     /**
      * The DEFAULT scenario, it is 2 buildings with one or more UEs that move in the same path
@@ -39,7 +61,8 @@ using namespace ns3;
     /**
      * Tree scenario, it is a row of 7 trees with one or more UEs that move in the same path
      * - Distance between trees: 2 meters (x axis)
-     * - Each tree is modeled as a wood building of 0.5x0.5 m^2 with no internal apartments
+     * - Each tree is modeled as a wood building of 0.5x0.5 m^2 with no internal apartments, or with
+     *   vegetation as a cylinder of foliage (VegetationPropagationLossModel)
      * - Tree height is 7 meters
      * 
      *                  Antenna
@@ -51,7 +74,7 @@ using namespace ns3;
      *     UE --> .  .  .  .  .  .  .  .  .  .  .     -
      * 
     */
-    void TreePhysicalDistribution(ns3::NodeContainer& gnbNodes, ns3::NodeContainer& ueNodes, double mobility);
+    void TreePhysicalDistribution(ns3::NodeContainer& gnbNodes, ns3::NodeContainer& ueNodes, double mobility, bool vegetation = false);
 
     /**
      * Indoor router distribution, there is a 5G Router located and fixed inside an apartment in a
@@ -82,7 +105,8 @@ using namespace ns3;
      * - Sidewalk Width: 3 meters
      * - Frontyard: 5 meters 
      * - Distance between trees: 10 meters (x axis)
-     * - Each tree is modeled as a wood building of x*y m^2 with no internal apartments
+     * - Each tree is modeled as a wood building of x*y m^2 with no internal apartments, or with
+     *   vegetation as a cylinder of foliage (VegetationPropagationLossModel)
      * - Tree height is 7 meters
      * 
      *     ----------------------------------------
@@ -103,4 +127,23 @@ using namespace ns3;
      *    |   UE  |  |    |   UE  |    |   |   UE  |
      * 
     */
-    void NeighborhoodPhysicalDistribution(ns3::NodeContainer& gnbNodes, ns3::NodeContainer& ueNodes);
\ No newline at end of file
+    void NeighborhoodPhysicalDistribution(ns3::NodeContainer& gnbNodes, ns3::NodeContainer& ueNodes, bool vegetation = false);
+
+    /**
+     * Street grid, N x M square blocks separated by streets. Every block has a sidewalk along its
+     * border with a row of trees on the curb side and a grid of residential buildings inside. The
+     * gNbs are placed every gNbD meters (row first) from the first street intersection, and the UEs
+     * are split between pedestrians on the sidewalks (walking along them and turning back at the
+     * corners of their block) and indoor users (static, random building and floor). Everything is driven by StreetGridOptions, to study how a study
+     * scales before taking it to a whole city.
+     *
+     *        street     street     street
+     *     |        | |        | |        |
+     *     | T T T  | | T T T  | | T T T  |
+     *     | [B][B] | | [B][B] | | [B][B] |  ...
+     *     | [B][B] | | [B][B] | | [B][B] |
+     *     | T T T  | | T T T  | | T T T  |
+     *     ----------------------------------  street (gNb)
+     *                    ...
+    */
+    void StreetGridPhysicalDistribution(ns3::NodeContainer& gnbNodes, ns3::NodeContainer& ueNodes, const StreetGridOptions& options);
@@ -17,7 +17,12 @@ MyApp::MyApp ()
     m_dataRate (0),
     m_sendEvent (),
     m_running (false),
-    m_packetsSent (0)
+    m_packetsSent (0),
+    m_template (nullptr),
+    m_enablePrinting (false),
+    m_burstInterval (0),
+    m_lastBurst (0),
+    m_credit (0)
 {
 }
 
@@ -26,6 +31,8 @@ MyApp::~MyApp ()
   m_socket = nullptr;
 }
 
+NS_OBJECT_ENSURE_REGISTERED(MyApp);
+
 TypeId
 MyApp::GetTypeId()
 {
@@ -37,7 +44,19 @@ MyApp::GetTypeId()
                           "DataRate of the app",
                           DataRateValue(0),
                           MakeDataRateAccessor(&MyApp::m_dataRate),
-                          MakeDataRateChecker());
+                          MakeDataRateChecker())
+            .AddAttribute("EnablePrinting",
+                          "Enable the packet metadata so the sent packets can be printed in the logs (slow)",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&MyApp::m_enablePrinting),
+                          MakeBooleanChecker())
+            .AddAttribute("BurstInterval",
+                          "If not zero, every BurstInterval the app writes all the segments the data "
+                          "rate allows for the elapsed time (limited by the socket GetTxAvailable) "
+                          "instead of scheduling one event per segment",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&MyApp::m_burstInterval),
+                          MakeTimeChecker(Seconds(0)));
     return tid;
 }
 
@@ -68,7 +87,23 @@ MyApp::StartApplication()
   m_socket->Bind ();
   int result = m_socket->Connect (m_peer);
   std::clog << "App Connect Result " << result << std::endl;
-  SendPacket ();
+
+  if (m_enablePrinting)
+    {
+      Packet::EnablePrinting ();
+    }
+  m_template = Create<Packet> (m_packetSize);
+
+  if (m_burstInterval.IsStrictlyPositive ())
+    {
+      m_lastBurst = Simulator::Now ();
+      m_credit = m_packetSize;  // first segment right away, as in the per packet mode
+      SendBurst ();
+    }
+  else
+    {
+      SendPacket ();
+    }
 }
 
 void
@@ -90,17 +125,60 @@ MyApp::StopApplication()
     }
 }
 
-void
-MyApp::SendPacket()
+bool
+MyApp::SendOne()
 {
-    NS_LOG_FUNCTION(this);
-    Ptr<Packet> packet = Create<Packet>(m_packetSize);
+    Ptr<Packet> packet = m_template->Copy();
     //MyAppTag tag (Simulator::Now ());
-    packet->EnablePrinting();
     // NS_LOG_DEBUG("txBuff before: " << m_socket->GetTxAvailable());
     NS_LOG_DEBUG("Will send a packet at " << Simulator::Now().GetSeconds());
-    NS_LOG_DEBUG("Packet sent " << packet->ToString());
-    m_socket->Send (packet);
+    if (m_enablePrinting)
+    {
+        NS_LOG_DEBUG("Packet sent " << packet->ToString());
+    }
+    return m_socket->Send (packet) >= 0;
+}
+
+void
+MyApp::SendBurst()
+{
+    NS_LOG_FUNCTION(this);
+    Time now = Simulator::Now();
+    m_credit += static_cast<double>(m_dataRate.GetBitRate()) / 8 * (now - m_lastBurst).GetSeconds();
+    m_lastBurst = now;
+
+    // What does not fit in the socket buffer is not sent, like the per packet mode does (only
+    // keeps up to two ticks of credit so a full buffer does not end in a huge burst later)
+    m_credit = std::min(m_credit, std::max<double>(m_packetSize, 2.0 * m_dataRate.GetBitRate() / 8 * m_burstInterval.GetSeconds()));
+
+    uint32_t fits = m_socket->GetTxAvailable() / m_packetSize;
+    while (m_credit >= m_packetSize && fits > 0 && m_packetsSent < m_nPackets)
+    {
+        if (!SendOne())
+        {
+            break;
+        }
+        m_credit -= m_packetSize;
+        m_packetsSent++;
+        fits--;
+    }
+    NS_LOG_DEBUG("Burst at " << now.GetSeconds() << " credit left " << m_credit << " B");
+
+    if (m_packetsSent >= m_nPackets)
+    {
+        std::cout  <<  TXT_RED << "APP END" << TXT_CLEAR << std::endl;
+    }
+    else if (m_running)
+    {
+        m_sendEvent = Simulator::Schedule (m_burstInterval, &MyApp::SendBurst, this);
+    }
+}
+
+void
+MyApp::SendPacket()
+{
+    NS_LOG_FUNCTION(this);
+    SendOne();
     // NS_LOG_DEBUG("Packet just sent information: ");
     // packet->Print(std::clog);
     // NS_LOG_DEBUG(" ");
@@ -131,3 +209,134 @@ MyApp::ScheduleTx()
     }
 }
 
+NS_OBJECT_ENSURE_REGISTERED(SlotBurstUdpClient);
+
+SlotBurstUdpClient::SlotBurstUdpClient ()
+  : m_socket (nullptr),
+    m_peer (),
+    m_peerPort (0),
+    m_packetSize (0),
+    m_dataRate (0),
+    m_burstPeriod (0),
+    m_sendEvent (),
+    m_payload (nullptr),
+    m_credit (0),
+    m_seq (0),
+    m_sent (0)
+{
+}
+
+SlotBurstUdpClient::~SlotBurstUdpClient ()
+{
+  m_socket = nullptr;
+}
+
+TypeId
+SlotBurstUdpClient::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::SlotBurstUdpClient")
+            .SetParent<Application>()
+            .SetGroupName("MyAppComp")
+            .AddConstructor<SlotBurstUdpClient>()
+            .AddAttribute("RemoteAddress",
+                          "The destination Address of the outbound packets",
+                          AddressValue(),
+                          MakeAddressAccessor(&SlotBurstUdpClient::m_peer),
+                          MakeAddressChecker())
+            .AddAttribute("RemotePort",
+                          "The destination port of the outbound packets",
+                          UintegerValue(100),
+                          MakeUintegerAccessor(&SlotBurstUdpClient::m_peerPort),
+                          MakeUintegerChecker<uint16_t>())
+            .AddAttribute("PacketSize",
+                          "Size of the packets, SeqTsHeader included (min. 12 bytes)",
+                          UintegerValue(1024),
+                          MakeUintegerAccessor(&SlotBurstUdpClient::m_packetSize),
+                          MakeUintegerChecker<uint32_t>(12))
+            .AddAttribute("DataRate",
+                          "DataRate of the app",
+                          DataRateValue(DataRate("100Mb/s")),
+                          MakeDataRateAccessor(&SlotBurstUdpClient::m_dataRate),
+                          MakeDataRateChecker())
+            .AddAttribute("BurstPeriod",
+                          "Time between bursts, use the slot duration to align them to the NR slots",
+                          TimeValue(MicroSeconds(125)),
+                          MakeTimeAccessor(&SlotBurstUdpClient::m_burstPeriod),
+                          MakeTimeChecker(NanoSeconds(1)));
+    return tid;
+}
+
+uint64_t
+SlotBurstUdpClient::GetSent () const
+{
+  return m_sent;
+}
+
+void
+SlotBurstUdpClient::StartApplication()
+{
+  NS_LOG_FUNCTION(this);
+
+  if (!m_socket)
+    {
+      m_socket = Socket::CreateSocket (GetNode (), UdpSocketFactory::GetTypeId ());
+      if (Ipv4Address::IsMatchingType (m_peer))
+        {
+          m_socket->Bind ();
+          m_socket->Connect (InetSocketAddress (Ipv4Address::ConvertFrom (m_peer), m_peerPort));
+        }
+      else if (InetSocketAddress::IsMatchingType (m_peer))
+        {
+          m_socket->Bind ();
+          m_socket->Connect (m_peer);
+        }
+      else
+        {
+          NS_FATAL_ERROR ("Incompatible address type: " << m_peer);
+        }
+      m_socket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket>> ());
+      m_socket->SetAllowBroadcast (true);
+    }
+
+  SeqTsHeader seqTs;
+  m_payload = Create<Packet> (m_packetSize - seqTs.GetSerializedSize ());
+  m_credit = 1;   // first packet right away, as UdpClient does
+  SendBurst ();
+}
+
+void
+SlotBurstUdpClient::StopApplication()
+{
+  NS_LOG_FUNCTION(this);
+  Simulator::Cancel (m_sendEvent);
+  if (m_socket)
+    {
+      m_socket->Close ();
+    }
+}
+
+void
+SlotBurstUdpClient::SendBurst()
+{
+  NS_LOG_FUNCTION(this);
+
+  uint32_t n = static_cast<uint32_t> (m_credit);
+  m_credit -= n;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      SeqTsHeader seqTs;
+      seqTs.SetSeq (m_seq++);
+      Ptr<Packet> p = m_payload->Copy ();
+      p->AddHeader (seqTs);
+      if (m_socket->Send (p) >= 0)
+        {
+          m_sent++;
+        }
+    }
+  NS_LOG_DEBUG ("Burst of " << n << " packets at " << Simulator::Now ().GetSeconds ());
+
+  // Packets (and fraction of) the rate allows until the next burst
+  m_credit += static_cast<double> (m_dataRate.GetBitRate ()) * m_burstPeriod.GetSeconds () / (8.0 * m_packetSize);
+  m_sendEvent = Simulator::Schedule (m_burstPeriod, &SlotBurstUdpClient::SendBurst, this);
+}
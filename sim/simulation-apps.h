@@ -19,6 +19,13 @@ private:
 
   void ScheduleTx();
   void SendPacket();
+  void SendBurst();
+
+  /**
+   * Sends one segment, a copy of m_template (the copies share the same buffer)
+   * \return false if the socket did not accept it
+   */
+  bool SendOne();
 
   Ptr<Socket>     m_socket;
   Address         m_peer;
@@ -28,4 +35,46 @@ private:
   EventId         m_sendEvent;
   bool            m_running;
   uint32_t        m_packetsSent;
-};
\ No newline at end of file
+  Ptr<Packet>     m_template;       //!< Payload shared by every segment
+  bool            m_enablePrinting; //!< Whether to enable the packet metadata (needed by ToString)
+  Time            m_burstInterval;  //!< Burst mode tick, zero sends one packet per event
+  Time            m_lastBurst;      //!< Time of the last burst
+  double          m_credit;         //!< Bytes allowed by the data rate and not sent yet
+};
+
+/**
+ * UDP source that sends its packets in bursts: every BurstPeriod (by default an NR slot) it sends the
+ * packets the data rate allows for the period. The fractional part of a packet is carried to the next
+ * burst, so the long run rate is exact. Every packet carries a SeqTsHeader, like UdpClient, so the
+ * UdpServer at the UE can compute losses and delays.
+ */
+class SlotBurstUdpClient : public Application
+{
+public:
+  SlotBurstUdpClient ();
+  ~SlotBurstUdpClient() override;
+  static TypeId GetTypeId();
+
+  /**
+   * \return Number of packets sent
+   */
+  uint64_t GetSent () const;
+
+private:
+  void StartApplication() override;
+  void StopApplication() override;
+
+  void SendBurst();
+
+  Ptr<Socket>     m_socket;
+  Address         m_peer;
+  uint16_t        m_peerPort;
+  uint32_t        m_packetSize;     //!< Size of the packet including the SeqTsHeader
+  DataRate        m_dataRate;
+  Time            m_burstPeriod;
+  EventId         m_sendEvent;
+  Ptr<Packet>     m_payload;        //!< Payload shared by every packet (m_packetSize - SeqTsHeader)
+  double          m_credit;         //!< Packets the data rate allows and were not sent yet
+  uint32_t        m_seq;
+  uint64_t        m_sent;
+};
@@ -19,13 +19,35 @@
 #include <ns3/hybrid-buildings-propagation-loss-model.h>
 
 /* Include systems libraries */
+#include <sys/resource.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <functional>
 
 /* Include custom libraries (aux files for the simulation) */
 #include "cmdline-colors.h"
 #include "simulation-apps.h"
 #include "physical-scenarios.h"
+#include "tcp-trace-analyzer.h"
+#include "udp-rx-aggregator.h"
+#include "flow-probe.h"
+#include "backhaul-aggregation.h"
+#include "epc-bypass.h"
+#include "traffic-engine.h"
+#include "trace-replay.h"
+#include "slot-bucket-scheduler.h"
+#include "idle-slot-monitor.h"
+#include "displacement-channel-model.h"
+#include "binned-beamforming.h"
+#include "trajectory-condition.h"
+#include "obstacle-grid.h"
+#include "vegetation.h"
+#include "parallel-rem.h"
+#include "coarse-spectrum.h"
+#include "parallel-channel-model.h"
+#include "memo-propagation-loss.h"
+#include "mac-scheduler-profiler.h"
+#include "distributed-mode.h"
 
 using namespace ns3;
 
@@ -64,11 +86,17 @@ static void UdpServerTracer(Ptr<OutputStreamWrapper> stream, Ptr<const Packet> p
 
 /* Helper functions, definitions are at EOF */
 static void InstallTCP2 (Ptr<Node> remoteHost, Ptr<Node> receiver, uint16_t sinkPort, float startTime, float stopTime, float dataRate);
+static Address InstallTcpSink(Ptr<Node> receiver, uint16_t sinkPort, double startTime, double stopTime);
+static ApplicationContainer InstallUdpSink(Ptr<Node> receiver, uint16_t port, Time aggInterval, std::vector<Ptr<UdpRxAggregator>>& aggregators);
 static void CalculatePosition(NodeContainer* ueNodes, NodeContainer* gnbNodes, std::ostream* os);
 static void AddRandomNoise(Ptr<NrPhy> ue_phy);
 static void PrintNodeAddressInfo(bool ignore_localh);
 static void processFlowMonitor(Ptr<FlowMonitor> monitor, Ptr<ns3::FlowClassifier> flowmonHelper, double AppStartTime);
+static void processFlowStats(const FlowMonitor::FlowStatsContainer& stats, std::function<Ipv4FlowClassifier::FiveTuple(FlowId)> findFlow, double AppStartTime);
 static void UdpServerMakeCallback(uint32_t nodeId);
+static Ptr<UdpRxAggregator> UdpServerMakeAggregator(uint32_t nodeId, Time interval);
+static void WriteRunStats(std::string filename, double setupTime, double runTime, const std::vector<std::pair<std::string, uint64_t>>& counters);
+static Time GetTrafficEnd(Ptr<Node> node, Time simEnd);
 
 
 int main(int argc, char* argv[]) {
@@ -106,6 +134,9 @@ int main(int argc, char* argv[]) {
     // Trace activation
     bool NRTrace = true;    // whether to enable Trace NR
     bool TCPTrace = true;   // whether to enable Trace TCP
+    bool asciiTrace = false; // whether to dump every IPv4 event to tcp-all-ascii.txt (huge)
+    Time udpAggInterval = Seconds(0); // if > 0, UDP rx stats are aggregated per interval instead of per packet
+    bool flowProbe = true;  // whether to write FlowProbe.json (per flow delay/jitter quantiles and throughput series)
 
     // RB Info and position
     uint16_t gNbNum = 1;    // Numbers of RB
@@ -115,6 +146,8 @@ int main(int argc, char* argv[]) {
 
     // UE Info and position
     uint16_t ueNumPergNb = 1;   // Numbers of User per RB
+    uint32_t gridUes = 10;      // UEs of the street grid scenario (all the gNbs)
+    StreetGridOptions streetGrid; // Street grid scenario (phyDistro 4)
     // double ueDistance = .50;    //Distance between UE
     // double xUE=30;  //Initial X Position UE
     // double yUE=10;  //Initial Y Position UE
@@ -137,6 +170,40 @@ int main(int argc, char* argv[]) {
     std::string flowType = "UDP";       // Transport Protocol
     std::string tcpTypeId = "TcpBbr";   // TCP Type
     double AppStartTime = 0.2;          // APP start time
+    Time appBurstInterval = Seconds(0);  // MyApp burst tick, 0: one event per segment
+    bool appPrinting = false;           // Packet metadata of MyApp packets (to print them in the logs)
+    bool udpBurst = true;               // UDP flow: SlotBurstUdpClient instead of UdpClient
+    Time udpBurstPeriod = Seconds(0);   // SlotBurstUdpClient period, 0: NR slot duration
+    Time backhaulAggWindow = Seconds(0); // RH<->PGW super packet aggregation window, 0: disabled
+    std::string replayTrace = "";       // Binary trace replayed instead of the CBR sources (trace_converter.py)
+    double replayTimeScale = 1.0;       // Time scale of the replayed trace
+    bool replayLoop = true;             // Loop the replayed trace
+    bool trafficEngine = false;         // TCP flows sent by one TrafficEngine (timer wheel) instead of a MyApp per UE
+    bool epcBypass = false;             // Downlink from the RH straight to the gNB (delay line instead of the EPC)
+    std::string scheduler = "Map";      // Event scheduler: Map, Heap, List, Calendar, PriorityQueue, SlotBucket, NodeOrder
+    std::string schedulerTrace = "";    // If set, the scheduler operations are written there (scheduler-benchmark)
+    bool macProfile = false;            // Wall time of the MAC scheduler per slot and phase (SchedulerProfile.txt)
+    bool macFastAssign = false;         // Profiled scheduler assigns the RBGs with its UE list and single UE fast path
+    bool mpi = false;                   // Distributed run (mpirun -np 2): RAN and EPC in rank 0, remote host in rank 1
+    bool vegetation = false;            // Trees as cylinders of foliage (ITU-R P.833 loss) instead of wood buildings
+    double obstacleGridCell = 0;        // If > 0, buildings indexed in a grid of cells of this size (m) for the LoS queries
+    double conditionResolution = 0;     // If > 0, LoS/NLoS precomputed along the UE trajectories every this meters
+    double channelUpdateDistance = 0;   // If > 0, channel regenerated when a UE moves this distance (m) instead of never
+    double channelUpdateAngle = 10;     // ... or the gNB-UE direction rotates this angle (deg)
+    uint32_t channelThreads = 1;        // Threads that generate the channel matrices of large arrays
+    bool hybridPathloss = false;        // Path loss of the HybridBuildingsPropagationLossModel instead of the 3GPP UMa one
+    double pathlossMemo = 0;            // If > 0, loss of every link memoized while its ends stay in cells of this size (m)
+    double bfAngleResolution = 0;       // If > 0, direct path beams quantized to this angle (deg) and cached
+    bool idleEarlyStop = false;         // Count idle gNB slots and stop once every gNB is idle after the traffic
+    uint32_t rbPerBand = 1;             // If > 1, fading evaluated once per group of this many RBs (rounded up to whole RBGs)
+    uint32_t rbSamples = 2;             // ... at this many frequencies of the group, with the mean gain applied to all its RBs
+    bool rem = false;                   // Radio environment map (nr-rem-rem.out) computed by a thread pool and cached
+    double remMaxX = 40;                // REM area [0, remMaxX] x [0, remMaxY] (m)
+    double remMaxY = 170;
+    double remResolution = 1;           // Distance between the REM points (m)
+    double remZ = 1.5;                  // Height of the REM (m)
+    uint32_t remThreads = 0;            // REM worker threads, 0: one per hardware thread
+    std::string remCacheDir = "../rem-cache"; // Cached REMs (relative to the simulation folder), empty: no cache
 
     #pragma endregion Variables
 
@@ -164,10 +231,83 @@ int main(int argc, char* argv[]) {
     cmd.AddValue("addNoise", "Add normal distributed noise to the simulation", addNoise);
     cmd.AddValue("blerTarget", "Set the bler target for the AMC (Default: 0.1)", blerTarget);
     cmd.AddValue("amcAlgo", "Choose the algorithm to be used in the amc possible values:\n\t0:Original\n\t1:ProbeCqi\n\t2:NewBlerTarget\n\t3:ExpBlerTarget\n\t4:HybridBlerTarget\nCurrent value: ", amcAlgorithm);
-    cmd.AddValue("phyDistro", "Physical distribution of the Buildings-UEs-gNbs. Options:\n\t0:Default\n\t1:Trees\n\t2:Indoor Router\nCurrent value: ", phyDistro);   
+    cmd.AddValue("phyDistro", "Physical distribution of the Buildings-UEs-gNbs. Options:\n\t0:Default\n\t1:Trees\n\t2:Indoor Router\n\t4:Street grid\nCurrent value: ", phyDistro);   
+    cmd.AddValue("gNbNum", "Number of gNbs", gNbNum);
+    cmd.AddValue("gNbD", "Distance between gNbs in m (street grid)", gNbD);
+    cmd.AddValue("gridBlocksX", "Street grid: blocks along the x axis", streetGrid.blocksX);
+    cmd.AddValue("gridBlocksY", "Street grid: blocks along the y axis", streetGrid.blocksY);
+    cmd.AddValue("gridBlockSize", "Street grid: side of a block in m", streetGrid.blockSize);
+    cmd.AddValue("gridBuildings", "Street grid: a block has gridBuildings x gridBuildings buildings", streetGrid.buildingsPerSide);
+    cmd.AddValue("gridFloors", "Street grid: floors of the buildings", streetGrid.nFloors);
+    cmd.AddValue("gridTreeSpacing", "Street grid: distance in m between the trees of a sidewalk, 0: no trees", streetGrid.treeSpacing);
+    cmd.AddValue("gridUes", "Street grid: number of UEs", gridUes);
+    cmd.AddValue("gridIndoorRatio", "Street grid: fraction of the UEs that are static inside a building, the rest walk on the sidewalks", streetGrid.indoorRatio);
+    cmd.AddValue("gridSeed", "Street grid: seed of the UE positions", streetGrid.seed);
+
+    cmd.AddValue("replayTrace", "Binary packet trace (OtherScripts/trace_converter.py) replayed to every UE with the flowType protocol instead of the constant rate sources", replayTrace);
+    cmd.AddValue("replayTimeScale", "Factor applied to the replayed trace timestamps", replayTimeScale);
+    cmd.AddValue("replayLoop", "If set to 1, the replayed trace starts again when it ends", replayLoop);
+    cmd.AddValue("trafficEngine", "If set to 1, the TCP flows of every UE are sent by a single timer wheel application in the RH", trafficEngine);
+    cmd.AddValue("epcBypass", "If set to 1, the downlink skips the EPC: RH packets go through a delay line (server delay) to the PDCP of the UE's gNB", epcBypass);
+    cmd.AddValue("backhaulAggWindow", "If > 0, back-to-back packets of a flow that queue up on the RemoteHost<->PGW link travel as one super packet (Ex: 20us), a packet with nothing queued in front is sent right away", backhaulAggWindow);
+    cmd.AddValue("appBurstInterval", "If > 0, the TCP app writes every interval the segments its data rate allows (Ex: 1ms) instead of one event per segment", appBurstInterval);
+    cmd.AddValue("udpBurst", "If set to 1, the UDP flow sends its packets in bursts (one per udpBurstPeriod) instead of one per interval", udpBurst);
+    cmd.AddValue("udpBurstPeriod", "Period of the UDP bursts, 0 means one NR slot", udpBurstPeriod);
+    cmd.AddValue("appPrinting", "If set to 1, the TCP app enables packet metadata printing", appPrinting);
+    cmd.AddValue("TCPTrace", "If set to 1, the TCP PER and RTT tables (tcp-per.txt, tcp-delay.txt) are written", TCPTrace);
+    cmd.AddValue("asciiTrace", "If set to 1, every IPv4 event is also written to tcp-all-ascii.txt", asciiTrace);
+    cmd.AddValue("flowProbe", "If set to 1, per flow quantiles and throughput series are written to FlowProbe.json and FlowOutput.txt is computed by the same probe, without a FlowMonitor", flowProbe);
+    cmd.AddValue("udpAggInterval", "If > 0, UDP rx stats are written per interval (UdpRecvAgg_NodeN.txt) instead of per packet (UdpRecv_NodeN.txt). Ex: 100ms", udpAggInterval);
+
+    cmd.AddValue("vegetation", "Trees modeled as cylinders of foliage with the ITU-R P.833 attenuation per meter crossed, instead of wood buildings", vegetation);
+    cmd.AddValue("obstacleGridCell", "If > 0 (and buildings enabled), buildings and trees are indexed in a uniform grid with cells of this size in m, and the channel condition is computed with it", obstacleGridCell);
+    cmd.AddValue("conditionResolution", "If > 0 (and buildings enabled), the LoS/NLoS condition and wall penetration are precomputed along the UE trajectories every this meters (ConditionProfile.txt) and read from that table", conditionResolution);
+    cmd.AddValue("channelUpdateDistance", "If > 0, the 3GPP channel of a link is regenerated when an end moves this distance in m (or the link rotates channelUpdateAngle) and cached by position bins of this size", channelUpdateDistance);
+    cmd.AddValue("channelUpdateAngle", "Rotation in degrees of the gNB-UE direction that regenerates the channel (with channelUpdateDistance > 0)", channelUpdateAngle);
+    cmd.AddValue("channelThreads", "Threads that generate the 3GPP channel matrices of large arrays (ns3::ParallelChannelModel::MinElementPairs), the calling one included, with the same results for any value", channelThreads);
+    cmd.AddValue("hybridPathloss", "If set to 1 (and buildings enabled), the path loss of the channel is the HybridBuildingsPropagationLossModel (shadowing and internal walls configured below) instead of the 3GPP UMa one", hybridPathloss);
+    cmd.AddValue("pathlossMemo", "If > 0, the propagation loss of every link is computed again only when an end leaves its cell of this size in m or changes course (static links: once per run)", pathlossMemo);
+    cmd.AddValue("bfAngleResolution", "If > 0, the direct path beams point to angular bins of this size in degrees and are cached (same bin, same beam)", bfAngleResolution);
+    cmd.AddValue("idleEarlyStop", "If set to 1, idle gNB slots are counted (IdleSlots.txt) and the simulation ends once every gNB is idle after the apps stop", idleEarlyStop);
+    cmd.AddValue("rbPerBand", "Experimental. If > 1, the fading is computed once per group of this many RBs (rounded up to a multiple of the RBG size) and applied to all of them. Faster, less frequency selective", rbPerBand);
+    cmd.AddValue("rbSamples", "With rbPerBand > 1, frequencies of each group where the fading is computed, the group gets the mean of their gains (at most rbPerBand)", rbSamples);
+    cmd.AddValue("rem", "If set to 1, the radio environment map (nr-rem-rem.out) is computed by a thread pool before the run (3GPP path loss, also with hybridPathloss), or copied from remCacheDir if the scenario did not change", rem);
+    cmd.AddValue("remMaxX", "REM: maximum x in m (from 0)", remMaxX);
+    cmd.AddValue("remMaxY", "REM: maximum y in m (from 0)", remMaxY);
+    cmd.AddValue("remResolution", "REM: distance between points in m", remResolution);
+    cmd.AddValue("remZ", "REM: height in m", remZ);
+    cmd.AddValue("remThreads", "REM: worker threads, 0 means one per hardware thread", remThreads);
+    cmd.AddValue("remCacheDir", "REM: directory of the cached maps, empty disables the cache", remCacheDir);
+    cmd.AddValue("scheduler", "Event scheduler: Map, Heap, List, Calendar, PriorityQueue, SlotBucket (slot sized buckets) or NodeOrder (simultaneous events by node, always used with mpi)", scheduler);
+    cmd.AddValue("schedulerTrace", "If set, every insert/remove of the event scheduler is written to this file, to replay it with scheduler-benchmark", schedulerTrace);
+    cmd.AddValue("macProfile", "If set to 1, the TDMA RR MAC scheduler measures its wall time per slot and per phase (sorting, RBG assignment, DCI, LCG bookkeeping) and writes the histograms to SchedulerProfile.txt and SchedulerHistogram.txt", macProfile);
+    cmd.AddValue("macFastAssign", "If set to 1 (with macProfile), the profiled scheduler assigns the RBGs with its own round robin loop: sorted once per slot, UEs already served leave the list, a single UE is not sorted", macFastAssign);
+    cmd.AddValue("mpi", "If set to 1, distributed run with mpirun -np 2 (ns-3 built with --enable-mpi): gNBs, UEs and EPC in rank 0, remote host and its apps in rank 1, split at the RemoteHost<->PGW link (server delay as lookahead). Rank 1 files end in -rank1", mpi);
 
     cmd.Parse(argc, argv);
 
+    // Before the first node or event, the simulator implementation is created on first use
+    if (mpi)
+    {
+        EnableDistributedMode(&argc, &argv);
+        NS_ABORT_MSG_IF(epcBypass, "epcBypass hands the packets of the remote host to the gNBs in the same process, it can not be used with mpi");
+        NS_ABORT_MSG_IF(backhaulAggWindow.IsStrictlyPositive(), "The aggregating RemoteHost<->PGW link has no MPI channel, backhaulAggWindow can not be used with mpi");
+        NS_ABORT_MSG_IF(idleEarlyStop, "idleEarlyStop stops the RAN rank alone, it can not be used with mpi");
+
+        // Simultaneous events ordered by node, so the packets that cross the cut (scheduled when the MPI
+        // message arrives) keep their place among them
+        if (scheduler != "NodeOrder")
+        {
+            std::cout << TXT_YELLOW << "mpi uses the NodeOrder event scheduler instead of " << scheduler
+                      << ", compare it with single process runs with --scheduler=NodeOrder" << TXT_CLEAR << std::endl;
+            scheduler = "NodeOrder";
+        }
+    }
+
+    // One bucket per NR slot
+    Config::SetDefault("ns3::SlotBucketScheduler::BucketWidth", TimeValue(NanoSeconds(1000000 >> numerology)));
+    SelectScheduler(scheduler, RankFileName(schedulerTrace));
+
     #pragma endregion SimArguments
     
     /********************************************************************************************************************
@@ -175,7 +315,7 @@ int main(int argc, char* argv[]) {
     ********************************************************************************************************************/
     #pragma region logs
     // Redirect logs to output file, clog -> LOG_FILENAME
-    std::ofstream ofLog(LOG_FILENAME);
+    std::ofstream ofLog(RankFileName(LOG_FILENAME));
     auto clog_buff = std::clog.rdbuf();
     std::clog.rdbuf(ofLog.rdbuf());
 
@@ -243,6 +383,9 @@ int main(int argc, char* argv[]) {
         Config::SetDefault("ns3::TcpSocket::DataRetries", UintegerValue(6)); // Number of data retransmission attempts. Default 6
         Config::SetDefault("ns3::TcpSocket::PersistTimeout", TimeValue (Seconds (2))); // Number of data retransmission attempts. Default 6
 
+        Config::SetDefault("ns3::MyAppComp::BurstInterval", TimeValue(appBurstInterval));
+        Config::SetDefault("ns3::MyAppComp::EnablePrinting", BooleanValue(appPrinting));
+
         // Config::Set ("/NodeList/*/DeviceList/*/TxQueue/MaxSize",  QueueSizeValue(QueueSize ("100p")));
         // Config::Set ("/NodeList/*/DeviceList/*/RxQueue/MaxSize",  QueueSizeValue(QueueSize ("100p")));
         // Config::SetDefault("ns3::DropTailQueue<Packet>::MaxSize", QueueSizeValue(QueueSize ("100p"))); //A FIFO packet queue that drops tail-end packets on overflow
@@ -282,8 +425,15 @@ int main(int argc, char* argv[]) {
 
     NodeContainer gnbNodes;
     NodeContainer ueNodes;
-    gnbNodes.Create(gNbNum, GNB_SYS_ID);
-    ueNodes.Create(gNbNum * ueNumPergNb, UE_SYS_ID);
+    gnbNodes.Create(gNbNum, RankSystemId(GNB_SYS_ID, RAN_RANK));
+    if (phyDistro == (int)PhysicalDistributionOptions::STREET_GRID)
+    {
+        ueNodes.Create(gridUes, RankSystemId(UE_SYS_ID, RAN_RANK));
+    }
+    else
+    {
+        ueNodes.Create(gNbNum * ueNumPergNb, RankSystemId(UE_SYS_ID, RAN_RANK));
+    }
 
     switch ((PhysicalDistributionOptions)phyDistro)
     {
@@ -292,7 +442,14 @@ int main(int argc, char* argv[]) {
         break;
 
     case PhysicalDistributionOptions::TREES:
-        TreePhysicalDistribution(gnbNodes, ueNodes, mobility);
+        TreePhysicalDistribution(gnbNodes, ueNodes, mobility, vegetation);
+        break;
+
+    case PhysicalDistributionOptions::STREET_GRID:
+        streetGrid.gNbD = gNbD;
+        streetGrid.mobility = mobility;
+        streetGrid.vegetation = vegetation;
+        StreetGridPhysicalDistribution(gnbNodes, ueNodes, streetGrid);
         break;
 
     case PhysicalDistributionOptions::DEFAULT:
@@ -320,8 +477,17 @@ int main(int argc, char* argv[]) {
     Ptr<NrHelper> nrHelper = CreateObject<NrHelper>();
 
     // Configure ideal beamforming method
-    idealBeamformingHelper->SetAttribute("BeamformingMethod",
-                                         TypeIdValue(DirectPathBeamforming::GetTypeId()));// dir at gNB, dir at UE
+    if (bfAngleResolution > 0)
+    {
+        Config::SetDefault("ns3::BinnedDirectPathBeamforming::AngleResolution", DoubleValue(bfAngleResolution * M_PI / 180));
+        idealBeamformingHelper->SetAttribute("BeamformingMethod",
+                                             TypeIdValue(BinnedDirectPathBeamforming::GetTypeId()));// dir at gNB, dir at UE, by angular bins
+    }
+    else
+    {
+        idealBeamformingHelper->SetAttribute("BeamformingMethod",
+                                             TypeIdValue(DirectPathBeamforming::GetTypeId()));// dir at gNB, dir at UE
+    }
 
     nrHelper->SetBeamformingHelper(idealBeamformingHelper);
     nrHelper->SetEpcHelper(epcHelper);
@@ -386,9 +552,92 @@ int main(int argc, char* argv[]) {
     // Initialize channel and pathloss, plus other things inside band.
     nrHelper->InitializeOperationBand(&band);
     BandwidthPartInfoPtrVector allBwps = CcBwpCreator::GetAllBwps({band});
+    Ptr<PropagationLossModel> threeGppPathloss = allBwps[0].get()->m_propagation; // Cloned by the REM
+
+    // Hybrid buildings path loss in place of the 3GPP one (the fading stays 3GPP)
+    if (hybridPathloss)
+    {
+        NS_ABORT_MSG_IF(!enableBuildings, "hybridPathloss needs the buildings (enableBuildings=1)");
+        propagationLossModel->SetAttribute("Frequency", DoubleValue(frequency));
+        // Every node of the channel needs its building info, whatever the scenario installed
+        for (NodeContainer nodes : {gnbNodes, ueNodes})
+        {
+            for (auto node = nodes.Begin(); node != nodes.End(); ++node)
+            {
+                if (!(*node)->GetObject<MobilityBuildingInfo>())
+                {
+                    BuildingsHelper::Install(*node);
+                }
+            }
+        }
+        for (const auto& bwp : allBwps)
+        {
+            bwp.get()->m_propagation = propagationLossModel;
+            bwp.get()->m_channel->SetAttribute("PropagationLossModel", PointerValue(propagationLossModel));
+        }
+    }
+
+    // Channel condition from a table along the (straight) UE trajectories and/or with the buildings in a grid
+    if (enableBuildings && obstacleGridCell > 0)
+    {
+        ObstacleGrid::Build(obstacleGridCell);
+    }
+    Ptr<TrajectoryChannelConditionModel> conditionModel;
+    if (enableBuildings && (conditionResolution > 0 || obstacleGridCell > 0))
+    {
+        conditionModel = CreateObject<TrajectoryChannelConditionModel>();
+        if (conditionResolution > 0)
+        {
+            conditionModel->SetAttribute("Resolution", DoubleValue(conditionResolution));
+            conditionModel->Build(ueNodes, gnbNodes, Seconds(simTime));
+            conditionModel->WriteProfile("ConditionProfile.txt");
+        }
+        conditionModel->InstallInBwps(allBwps);
+    }
+
+    // Foliage loss chained to the propagation loss of every channel
+    Ptr<VegetationPropagationLossModel> vegetationLoss;
+    if (VegetationList::GetN() > 0)
+    {
+        vegetationLoss = CreateObject<VegetationPropagationLossModel>();
+        vegetationLoss->SetAttribute("Frequency", DoubleValue(frequency));
+        for (const auto& bwp : allBwps)
+        {
+            bwp.get()->m_channel->AddPropagationLossModel(vegetationLoss);
+        }
+    }
+
+    // Loss of the whole chain (path loss and foliage) memoized by link
+    std::vector<Ptr<MemoPropagationLossModel>> pathlossMemos;
+    if (pathlossMemo > 0)
+    {
+        pathlossMemos = InstallMemoPropagationLoss(allBwps, pathlossMemo);
+    }
+
+    // Channel updated by displacement of the UEs (UpdatePeriod stays at 0), both models generate
+    // the matrices with channelThreads threads
+    Config::SetDefault("ns3::ParallelChannelModel::Threads", UintegerValue(channelThreads));
+    std::vector<Ptr<DisplacementChannelModel>> displacementChannels;
+    if (channelUpdateDistance > 0)
+    {
+        displacementChannels = InstallDisplacementChannelModel(allBwps, channelUpdateDistance, channelUpdateAngle, channelUpdateDistance);
+    }
+    else
+    {
+        // Also with a single thread, so the matrices are the same sums for any channelThreads
+        InstallParallelChannelModel(allBwps, channelThreads);
+    }
 
     // Configure scheduler
-    nrHelper->SetSchedulerTypeId(NrMacSchedulerTdmaRR::GetTypeId());
+    if (macProfile)
+    {
+        nrHelper->SetSchedulerTypeId(ProfiledMacSchedulerTdmaRR::GetTypeId());
+        nrHelper->SetSchedulerAttribute("FastAssignment", BooleanValue(macFastAssign));
+    }
+    else
+    {
+        nrHelper->SetSchedulerTypeId(NrMacSchedulerTdmaRR::GetTypeId());
+    }
 
     // Antennas for the UEs
     nrHelper->SetUeAntennaAttribute("NumRows", UintegerValue(2));
@@ -434,6 +683,23 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    // Fading at the granularity of groups of RBs, aligned with the RBGs of the scheduler (experimental)
+    if (rbPerBand > 1)
+    {
+        UintegerValue rbPerRbg;
+        nrHelper->GetGnbMac(enbNetDev.Get(0), 0)->GetAttribute("NumRbPerRbg", rbPerRbg);
+        uint32_t rbg = std::max<uint32_t>(1, rbPerRbg.Get());
+        if (rbPerBand % rbg != 0)
+        {
+            // Rounded up to whole RBGs, the last group of the band is the one that gets shorter
+            uint32_t requested = rbPerBand;
+            rbPerBand = (rbPerBand / rbg + 1) * rbg;
+            std::cout << TXT_YELLOW << "rbPerBand " << requested << " is not a multiple of the RBG size (" << rbg
+                      << "), using " << rbPerBand << TXT_CLEAR << std::endl;
+        }
+        InstallCoarseSpectrum(allBwps, rbPerBand, rbSamples);
+    }
+
     // Another way to add error to the receiver
     /*
     Ptr<RateErrorModel> em = CreateObject<RateErrorModel>();
@@ -461,10 +727,10 @@ int main(int argc, char* argv[]) {
     // Create the internet and install the IP stack on the UEs
     // Get SGW/PGW and create a single RemoteHost
     Ptr<Node> pgw = epcHelper->GetPgwNode();
-    epcHelper->GetSgwNode()->SetAttribute("SystemId", UintegerValue(SGW_SYS_ID)); // Set a Sys Id for the SGW Node
-    pgw->SetAttribute("SystemId", UintegerValue(PGW_SYS_ID));
+    epcHelper->GetSgwNode()->SetAttribute("SystemId", UintegerValue(RankSystemId(SGW_SYS_ID, RAN_RANK))); // Set a Sys Id for the SGW Node
+    pgw->SetAttribute("SystemId", UintegerValue(RankSystemId(PGW_SYS_ID, RAN_RANK)));
     NodeContainer remoteHostContainer;
-    remoteHostContainer.Create(1, RH_SYS_ID);
+    remoteHostContainer.Create(1, RankSystemId(RH_SYS_ID, SERVER_RANK)); // With mpi the p2p to the PGW is the MPI channel
     Ptr<Node> remoteHost = remoteHostContainer.Get(0);
     InternetStackHelper internet;
     internet.Install(remoteHostContainer);
@@ -474,7 +740,16 @@ int main(int argc, char* argv[]) {
     p2ph.SetDeviceAttribute("DataRate", DataRateValue(DataRate("100Gb/s")));
     p2ph.SetDeviceAttribute("Mtu", UintegerValue(1500)); //2500
     p2ph.SetChannelAttribute("Delay", TimeValue(Seconds(serverDelay)));
-    NetDeviceContainer internetDevices = p2ph.Install(pgw, remoteHost);
+    NetDeviceContainer internetDevices;
+    if (backhaulAggWindow.IsStrictlyPositive())
+    {
+        internetDevices = InstallAggregatingP2p(pgw, remoteHost, DataRate("100Gb/s"), 1500,
+                                                Seconds(serverDelay), backhaulAggWindow);
+    }
+    else
+    {
+        internetDevices = p2ph.Install(pgw, remoteHost);
+    }
 
     Ipv4AddressHelper ipv4h;
     ipv4h.SetBase("1.0.0.0", "255.0.0.0");
@@ -489,6 +764,41 @@ int main(int argc, char* argv[]) {
     Ipv4InterfaceContainer ueIpIface;
     ueIpIface = epcHelper->AssignUeIpv4Address(NetDeviceContainer(ueNetDev));
 
+    if (epcBypass)
+    {
+        // Downlink: RH -> delay line -> gNB PDCP/RLC. Uplink: UE -> EPC -> PGW -> p2p -> RH
+        Ptr<EpcBypassNetDevice> bypassDev = CreateObject<EpcBypassNetDevice>();
+        bypassDev->SetAttribute("Delay", TimeValue(Seconds(serverDelay)));
+        remoteHost->AddDevice(bypassDev);
+        for (uint32_t u = 0; u < ueNetDev.GetN(); ++u)
+        {
+            bypassDev->AddUe(ueIpIface.GetAddress(u), DynamicCast<NrUeNetDevice>(ueNetDev.Get(u)));
+        }
+
+        Ipv4AddressHelper bypassAddress;
+        bypassAddress.SetBase("2.0.0.0", "255.0.0.0");
+        bypassAddress.Assign(NetDeviceContainer(bypassDev));
+
+        Ptr<Ipv4> rhIpv4 = remoteHost->GetObject<Ipv4>();
+        for (uint32_t i = 0; i < remoteHostStaticRouting->GetNRoutes(); ++i)
+        {
+            // 7.0.0.0 through the p2p
+            if (remoteHostStaticRouting->GetRoute(i).GetDestNetwork() == Ipv4Address("7.0.0.0"))
+            {
+                remoteHostStaticRouting->RemoveRoute(i);
+                break;
+            }
+        }
+        remoteHostStaticRouting->AddNetworkRouteTo(Ipv4Address("7.0.0.0"), Ipv4Mask("255.0.0.0"),
+                                                   rhIpv4->GetInterfaceForDevice(bypassDev));
+
+        // The replies to the bypass address come back through the PGW
+        Ptr<Ipv4> pgwIpv4 = pgw->GetObject<Ipv4>();
+        ipv4RoutingHelper.GetStaticRouting(pgwIpv4)->AddNetworkRouteTo(
+            Ipv4Address("2.0.0.0"), Ipv4Mask("255.0.0.0"), internetIpIfaces.GetAddress(1),
+            pgwIpv4->GetInterfaceForDevice(internetDevices.Get(0)));
+    }
+
     // assign IP address to UEs
     for (uint32_t u = 0; u < ueNodes.GetN(); ++u)
     {
@@ -503,27 +813,54 @@ int main(int argc, char* argv[]) {
     nrHelper->AttachToClosestEnb(ueNetDev, enbNetDev);
 
     // Flow type properties and setup
+    std::vector<Ptr<UdpRxAggregator>> udpAggregators;
     if ( flowType == "UDP")
     {
         std::cout << "App:" << flowType << std::endl;
         uint16_t dlPort = 1234;
         double interval = SEGMENT_SIZE*8/dataRate; // MicroSeconds
+        if (udpBurstPeriod.IsZero())
+        {
+            udpBurstPeriod = NanoSeconds(1000000 >> numerology); // slot duration: 1 ms / 2^numerology
+        }
         // install downlink applications
         ApplicationContainer clientApps;
         ApplicationContainer serverApps;
 
         for (uint32_t u = 0; u < ueNodes.GetN(); ++u)
         {
-            UdpServerHelper dlPacketSinkHelper(dlPort);
-            serverApps.Add(dlPacketSinkHelper.Install(ueNodes.Get(u)));
-
-            UdpServerMakeCallback(ueNodes.Get(u)->GetId());
+            serverApps.Add(InstallUdpSink(ueNodes.Get(u), dlPort, udpAggInterval, udpAggregators));
 
-            UdpClientHelper dlClient(ueIpIface.GetAddress(u), dlPort);
-            dlClient.SetAttribute("Interval", TimeValue(MicroSeconds(interval)));
-            dlClient.SetAttribute("MaxPackets", UintegerValue(0xFFFFFFFF));
-            dlClient.SetAttribute("PacketSize", UintegerValue(SEGMENT_SIZE));
-            clientApps.Add(dlClient.Install(remoteHost));
+            if (!replayTrace.empty())
+            {
+                Ptr<TraceReplayApp> replay = CreateObject<TraceReplayApp>();
+                replay->SetAttribute("TraceFile", StringValue(replayTrace));
+                replay->SetAttribute("Protocol", TypeIdValue(UdpSocketFactory::GetTypeId()));
+                replay->SetAttribute("Remote", AddressValue(InetSocketAddress(ueIpIface.GetAddress(u), dlPort)));
+                replay->SetAttribute("TimeScale", DoubleValue(replayTimeScale));
+                replay->SetAttribute("Loop", BooleanValue(replayLoop));
+                remoteHost->AddApplication(replay);
+                clientApps.Add(replay);
+            }
+            else if (udpBurst)
+            {
+                Ptr<SlotBurstUdpClient> dlClient = CreateObject<SlotBurstUdpClient>();
+                dlClient->SetAttribute("RemoteAddress", AddressValue(ueIpIface.GetAddress(u)));
+                dlClient->SetAttribute("RemotePort", UintegerValue(dlPort));
+                dlClient->SetAttribute("PacketSize", UintegerValue(SEGMENT_SIZE));
+                dlClient->SetAttribute("DataRate", DataRateValue(DataRate(dataRate * 1e6)));
+                dlClient->SetAttribute("BurstPeriod", TimeValue(udpBurstPeriod));
+                remoteHost->AddApplication(dlClient);
+                clientApps.Add(dlClient);
+            }
+            else
+            {
+                UdpClientHelper dlClient(ueIpIface.GetAddress(u), dlPort);
+                dlClient.SetAttribute("Interval", TimeValue(NanoSeconds(interval * 1000))); // MicroSeconds() truncated it
+                dlClient.SetAttribute("MaxPackets", UintegerValue(0xFFFFFFFF));
+                dlClient.SetAttribute("PacketSize", UintegerValue(SEGMENT_SIZE));
+                clientApps.Add(dlClient.Install(remoteHost));
+            }
         }
         // start server and client apps
         serverApps.Start(Seconds(AppStartTime));
@@ -537,14 +874,48 @@ int main(int argc, char* argv[]) {
         std::cout << TXT_CYAN << "Install App: " << flowType << " " << tcpTypeId << TXT_CLEAR << std::endl;
         uint16_t sinkPort = 8080;
 
+        Ptr<TrafficEngine> engine;
+        if (trafficEngine)
+        {
+            engine = CreateObject<TrafficEngine>();
+            remoteHost->AddApplication(engine);
+            engine->SetStartTime(Seconds(AppStartTime));
+            engine->SetStopTime(Seconds(simTime));
+        }
+
         for (uint32_t u = 0; u < ueNodes.GetN(); ++u)
         {
             //firstRto[u + 1] = true;
             auto start = AppStartTime + 0.01 * u;
             auto end = std::max (start + 1., simTime - start);
 
-            // InstallTCP (remoteHostContainer.Get (0), ueNodes.Get (u), sinkPort++, start, end);
-            InstallTCP2 (remoteHostContainer.Get (0), ueNodes.Get (u), sinkPort++, start, end, dataRate);
+            if (!replayTrace.empty())
+            {
+                Address sinkAddress = InstallTcpSink(ueNodes.Get(u), sinkPort, start, end);
+
+                Ptr<TraceReplayApp> replay = CreateObject<TraceReplayApp>();
+                replay->SetAttribute("TraceFile", StringValue(replayTrace));
+                replay->SetAttribute("Protocol", TypeIdValue(TcpSocketFactory::GetTypeId()));
+                replay->SetAttribute("Remote", AddressValue(sinkAddress));
+                replay->SetAttribute("TimeScale", DoubleValue(replayTimeScale));
+                replay->SetAttribute("Loop", BooleanValue(replayLoop));
+                remoteHost->AddApplication(replay);
+                replay->SetStartTime(Seconds(start));
+                replay->SetStopTime(Seconds(end));
+                sinkPort++;
+            }
+            else if (engine)
+            {
+                Address sinkAddress = InstallTcpSink(ueNodes.Get(u), sinkPort, start, end);
+                engine->AddFlow(TrafficEngine::TCP, sinkAddress, DataRate(std::to_string(dataRate) + "Mb/s"),
+                                SEGMENT_SIZE, Seconds(start), Seconds(end));
+                sinkPort++;
+            }
+            else
+            {
+                // InstallTCP (remoteHostContainer.Get (0), ueNodes.Get (u), sinkPort++, start, end);
+                InstallTCP2 (remoteHostContainer.Get (0), ueNodes.Get (u), sinkPort++, start, end, dataRate);
+            }
 
             std::cout << TXT_CYAN << 
                     "Install TCP between nodes: " << std::to_string(remoteHostContainer.Get (0)->GetId()) << "<->"<< std::to_string(ueNodes.Get (u)->GetId()) <<
@@ -552,8 +923,11 @@ int main(int argc, char* argv[]) {
 
             // Hook TRACE SOURCE after application starts
             // this work because u is identical to socketid i this case
-            Simulator::Schedule(Seconds(AppStartTime + 0.01 *ueNodes.GetN()) , 
-                                &TraceTcp, remoteHostContainer.Get (0)->GetId(), u);
+            if (IsLocal(remoteHost))
+            {
+                Simulator::Schedule(Seconds(AppStartTime + 0.01 *ueNodes.GetN()) , 
+                                    &TraceTcp, remoteHostContainer.Get (0)->GetId(), u);
+            }
 
           
         }
@@ -565,17 +939,33 @@ int main(int argc, char* argv[]) {
      ********************************************************************************************************************/
     #pragma region trace_n_files
     // enable the traces provided by the nr module
-    if (NRTrace)
+    if (NRTrace && GetRank() == RAN_RANK)
     {
         nrHelper->EnableTraces();
     }
 
-    // All tcp trace
-    if(TCPTrace){
-        std::ofstream asciiTCP;
+    // TCP PER and RTT, computed online at the remote host
+    Ptr<TcpTraceAnalyzer> tcpAnalyzer;
+    if (TCPTrace && flowType == "TCP" && IsLocal(remoteHost))
+    {
+        tcpAnalyzer = CreateObject<TcpTraceAnalyzer>();
+        tcpAnalyzer->Install(remoteHost);
+    }
+
+    // Idle slots and early end of the simulation once the traffic is over
+    Ptr<IdleSlotMonitor> idleMonitor;
+    if (idleEarlyStop)
+    {
+        idleMonitor = CreateObject<IdleSlotMonitor>();
+        idleMonitor->Install(enbNetDev);
+        // Every source of traffic (UDP clients, TCP apps, engine and replays) runs on the remote host
+        idleMonitor->SetTrafficEnd(GetTrafficEnd(remoteHost, Seconds(simTime)), Seconds(simTime));
+    }
+
+    // All IPv4 trace, only needed to debug (it easily reaches GBs)
+    if(asciiTrace){
         Ptr<OutputStreamWrapper> ascii_wrap;
-        asciiTCP.open("tcp-all-ascii.txt");
-        ascii_wrap = new OutputStreamWrapper("tcp-all-ascii.txt", std::ios::out);
+        ascii_wrap = new OutputStreamWrapper(RankFileName("tcp-all-ascii.txt"), std::ios::out);
         internet.EnableAsciiIpv4All(ascii_wrap);
         // p2ph.EnablePcapAll("mypcapfile", true);
     }
@@ -584,33 +974,65 @@ int main(int argc, char* argv[]) {
     // Calculate the node positions
     std::string logMFile="mobilityPosition.txt";
     std::ofstream mymcf;
-    mymcf.open(logMFile);
-    mymcf  << "Time\t" << "UE\t" << "x\t" << "y\t"  << "D0" << std::endl;
-    Simulator::Schedule(MilliSeconds(100), &CalculatePosition, &ueNodes, &gnbNodes, &mymcf);
+    if (GetRank() == RAN_RANK)
+    {
+        mymcf.open(logMFile);
+        mymcf  << "Time\t" << "UE\t" << "x\t" << "y\t"  << "D0" << std::endl;
+        Simulator::Schedule(MilliSeconds(100), &CalculatePosition, &ueNodes, &gnbNodes, &mymcf);
+    }
 
     // 
     // generate graph.ini
     //
     std::string iniFile="graph.ini";
     std::ofstream inif;
-    inif.open(iniFile);
+    inif.open(RankFileName(iniFile));
     inif << "[general]" << std::endl;
     inif << "resamplePeriod = 100" << std::endl;
     inif << "simTime = " << simTime << std::endl;
     inif << "AppStartTime = " << AppStartTime << std::endl;
     inif << "NRTrace = " << NRTrace << std::endl;
     inif << "TCPTrace = " << TCPTrace << std::endl;
+    inif << "asciiTrace = " << asciiTrace << std::endl;
+    inif << "flowProbe = " << flowProbe << std::endl;
+    inif << "udpAggInterval = " << udpAggInterval.GetSeconds()*1000 << " ms" << std::endl;
     inif << "flowType = " << flowType << std::endl;
     inif << "tcpTypeId = " << tcpTypeId << std::endl;
     inif << "frequency = " << frequency << std::endl;
     inif << "bandwidth = " << bandwidth << std::endl;
-    inif << "serverID = " << (int)(ueNumPergNb+gNbNum+3) << std::endl;
-    inif << "UENum = " << (int)(ueNumPergNb) << std::endl;
+    inif << "serverID = " << (int)(ueNodes.GetN()+gNbNum+3) << std::endl;
+    // Total UEs (all the gNbs), it was ueNumPergNb before the street grid: the same with one gNb
+    inif << "UENum = " << (int)(ueNodes.GetN()) << std::endl;
     inif << "SegmentSize = " << SEGMENT_SIZE << std::endl;
     inif << "rlcBuffer = " << rlcBuffer << std::endl;
     inif << "rlcBufferPerc = " << rlcBufferPerc << std::endl;
     inif << "serverType = " << serverType << std::endl;
     inif << "dataRate = " << dataRate << std::endl;
+    inif << "udpBurst = " << udpBurst << std::endl;
+    inif << "udpBurstPeriod = " << udpBurstPeriod.GetSeconds()*1e6 << " us" << std::endl;
+    inif << "replayTrace = " << replayTrace << std::endl;
+    inif << "replayTimeScale = " << replayTimeScale << std::endl;
+    inif << "trafficEngine = " << trafficEngine << std::endl;
+    inif << "epcBypass = " << epcBypass << std::endl;
+    inif << "scheduler = " << scheduler << std::endl;
+    inif << "macProfile = " << macProfile << std::endl;
+    inif << "macFastAssign = " << macFastAssign << std::endl;
+    inif << "mpi = " << mpi << std::endl;
+    inif << "idleEarlyStop = " << idleEarlyStop << std::endl;
+    inif << "rem = " << rem << std::endl;
+    inif << "rbPerBand = " << rbPerBand << std::endl;
+    inif << "rbSamples = " << rbSamples << std::endl;
+    inif << "vegetation = " << vegetation << std::endl;
+    inif << "obstacleGridCell = " << obstacleGridCell << std::endl;
+    inif << "conditionResolution = " << conditionResolution << std::endl;
+    inif << "channelUpdateDistance = " << channelUpdateDistance << std::endl;
+    inif << "channelUpdateAngle = " << channelUpdateAngle << std::endl;
+    inif << "channelThreads = " << channelThreads << std::endl;
+    inif << "hybridPathloss = " << hybridPathloss << std::endl;
+    inif << "pathlossMemo = " << pathlossMemo << std::endl;
+    inif << "bfAngleResolution = " << bfAngleResolution << std::endl;
+    inif << "backhaulAggWindow = " << backhaulAggWindow.GetSeconds()*1e6 << " us" << std::endl;
+    inif << "appBurstInterval = " << appBurstInterval.GetSeconds()*1000 << " ms" << std::endl;
     inif << "amcAlgorithm = " << +amcAlgorithm << std::endl;
     inif << "cqiHighGain = " << +cqiHighGain << std::endl;
     inif << "ProbeCqiDuration = " << ProbeCqiDuration.GetSeconds()*1000 << " ms" << std::endl;
@@ -636,6 +1058,20 @@ int main(int argc, char* argv[]) {
     inif << "buildDy = " << buildDy << std::endl;
     inif << "buildLx = " << buildLx << std::endl;
     inif << "buildLy = " << buildLy << std::endl;
+
+    if (phyDistro == (int)PhysicalDistributionOptions::STREET_GRID)
+    {
+        inif << std::endl;
+        inif << "[streetGrid]" << std::endl;
+        inif << "blocksX = " << streetGrid.blocksX << std::endl;
+        inif << "blocksY = " << streetGrid.blocksY << std::endl;
+        inif << "blockSize = " << streetGrid.blockSize << std::endl;
+        inif << "buildingsPerSide = " << streetGrid.buildingsPerSide << std::endl;
+        inif << "nFloors = " << streetGrid.nFloors << std::endl;
+        inif << "treeSpacing = " << streetGrid.treeSpacing << std::endl;
+        inif << "indoorRatio = " << streetGrid.indoorRatio << std::endl;
+        inif << "seed = " << streetGrid.seed << std::endl;
+    }
     inif.close();
 
     PrintNodeAddressInfo(true);
@@ -647,34 +1083,137 @@ int main(int argc, char* argv[]) {
     endpointNodes.Add(remoteHost);
     endpointNodes.Add(ueNodes);
 
-    Ptr<ns3::FlowMonitor> monitor = flowmonHelper.Install(endpointNodes);
-    monitor->SetAttribute("DelayBinWidth", DoubleValue(0.001));
-    monitor->SetAttribute("JitterBinWidth", DoubleValue(0.001));
-    monitor->SetAttribute("PacketSizeBinWidth", DoubleValue(20));
-
-    // /* REM HELPER, uncomment for use  */
-    // Ptr<NrRadioEnvironmentMapHelper> remHelper = CreateObject<NrRadioEnvironmentMapHelper>();
-    // remHelper->SetMinX(0);
-    // remHelper->SetMaxX(40);
-    // remHelper->SetResX(40);
-    // remHelper->SetMinY(0);
-    // remHelper->SetMaxY(170);
-    // remHelper->SetResY(170);
-    // if (phyDistro == 1)
-    //     remHelper->SetZ(1.5);
-    // else if (phyDistro == 2)
-    //     remHelper->SetZ(25.5);
-    // remHelper->SetSimTag("rem");
-
-    // remHelper->SetRemMode(NrRadioEnvironmentMapHelper::COVERAGE_AREA);
-    // remHelper->CreateRem(enbNetDev.Get(0), ueNetDev.Get(0), 0);
+    // With the probe on, FlowOutput.txt is written from it and the FlowMonitor (per packet bookkeeping
+    // and histograms) is not installed. The mpi mode needs the probe: the FlowMonitor pairs the rx of a
+    // packet with its tx in memory, and with mpi they are in different processes
+    Ptr<ns3::FlowMonitor> monitor;
+    Ptr<StreamingFlowProbe> streamingProbe;
+    if (flowProbe || mpi)
+    {
+        streamingProbe = CreateObject<StreamingFlowProbe>();
+        streamingProbe->SetAttribute("FiveTupleRx", BooleanValue(mpi));
+        streamingProbe->Install(endpointNodes);
+    }
+    else
+    {
+        monitor = flowmonHelper.Install(endpointNodes);
+        monitor->SetAttribute("DelayBinWidth", DoubleValue(0.001));
+        monitor->SetAttribute("JitterBinWidth", DoubleValue(0.001));
+        monitor->SetAttribute("PacketSizeBinWidth", DoubleValue(20));
+    }
+
+    // REM (graphSinrHeatmap), from the cache when only the AMC, traffic, etc. changed
+    if (rem && GetRank() == RAN_RANK)
+    {
+        Ptr<ParallelRemHelper> remHelper = CreateObject<ParallelRemHelper>();
+        remHelper->SetAttribute("MaxX", DoubleValue(remMaxX));
+        remHelper->SetAttribute("ResX", UintegerValue(remMaxX / remResolution + 1));
+        remHelper->SetAttribute("MaxY", DoubleValue(remMaxY));
+        remHelper->SetAttribute("ResY", UintegerValue(remMaxY / remResolution + 1));
+        remHelper->SetAttribute("Z", DoubleValue(remZ));
+        remHelper->SetAttribute("Threads", UintegerValue(remThreads));
+        remHelper->SetAttribute("CacheDir", StringValue(remCacheDir));
+        remHelper->SetAntennaGains(10 * log10(8 * 8), 10 * log10(2 * 4)); // Arrays of the gNbs and UEs configured above
+        remHelper->SetVegetationModel(vegetationLoss);
+        remHelper->Generate(gnbNodes, threeGppPathloss, txPower, frequency, bandwidth, NOISE_MEAN);
+    }
 
     Simulator::Stop(Seconds(simTime));
+    auto setupToc = std::chrono::high_resolution_clock::now();
     Simulator::Run();
+    auto runToc = std::chrono::high_resolution_clock::now();
+
+    // Counters of the caches that are enabled, summed over the BWPs
+    std::vector<std::pair<std::string, uint64_t>> cacheCounters;
+    if (!displacementChannels.empty())
+    {
+        uint64_t generated = 0, binHits = 0, reused = 0;
+        for (const auto& channel : displacementChannels)
+        {
+            auto [g, h, r] = channel->GetStats();
+            generated += g;
+            binHits += h;
+            reused += r;
+        }
+        cacheCounters.emplace_back("channelGenerated", generated);
+        cacheCounters.emplace_back("channelBinHits", binHits);
+        cacheCounters.emplace_back("channelReused", reused);
+    }
+    if (bfAngleResolution > 0)
+    {
+        auto [hits, computed] = BinnedDirectPathBeamforming::GetCacheStats();
+        cacheCounters.emplace_back("beamCacheHits", hits);
+        cacheCounters.emplace_back("beamComputed", computed);
+    }
+    if (!pathlossMemos.empty())
+    {
+        uint64_t hits = 0, computed = 0;
+        for (const auto& memo : pathlossMemos)
+        {
+            auto [h, c] = memo->GetStats();
+            hits += h;
+            computed += c;
+        }
+        cacheCounters.emplace_back("pathlossMemoHits", hits);
+        cacheCounters.emplace_back("pathlossMemoComputed", computed);
+    }
+    if (conditionModel && conditionResolution > 0)
+    {
+        auto [hits, computed] = conditionModel->GetStats();
+        cacheCounters.emplace_back("conditionTableHits", hits);
+        cacheCounters.emplace_back("conditionComputed", computed);
+    }
+    WriteRunStats(RankFileName("RunStats.txt"), 1.e-9*std::chrono::duration_cast<std::chrono::nanoseconds>(setupToc-itime).count(),
+                  1.e-9*std::chrono::duration_cast<std::chrono::nanoseconds>(runToc-setupToc).count(), cacheCounters);
 
-    processFlowMonitor(monitor, flowmonHelper.GetClassifier(), AppStartTime);
+    if (tcpAnalyzer)
+    {
+        tcpAnalyzer->Finish();
+    }
+    for (auto& aggregator : udpAggregators)
+    {
+        aggregator->Finish();
+    }
+    if (macProfile && GetRank() == RAN_RANK)
+    {
+        ProfiledMacSchedulerTdmaRR::WriteProfile("SchedulerProfile.txt", "SchedulerHistogram.txt");
+    }
+    for (const auto& memo : pathlossMemos)
+    {
+        auto [hits, misses] = memo->GetStats();
+        std::cout << TXT_CYAN << "Path loss memo: " << hits << " hits, " << misses << " computed" << TXT_CLEAR << std::endl;
+    }
+    if (idleMonitor)
+    {
+        idleMonitor->Finish();
+        idleMonitor->WriteSummary("IdleSlots.txt");
+    }
+    if (monitor)
+    {
+        processFlowMonitor(monitor, flowmonHelper.GetClassifier(), AppStartTime);
+    }
+    else if (GetRank() == SERVER_RANK)
+    {
+        // Downlink tx and uplink rx of every flow
+        SendToRank(RAN_RANK, streamingProbe->Save());
+    }
+    else
+    {
+        if (mpi)
+        {
+            streamingProbe->Merge(ReceiveFromRank(SERVER_RANK));
+        }
+        processFlowStats(streamingProbe->GetFlowMonitorStats(),
+                         [&streamingProbe](FlowId flowId) { return streamingProbe->FindFlow(flowId); },
+                         AppStartTime);
+    }
+    if (streamingProbe && flowProbe && GetRank() == RAN_RANK)
+    {
+        streamingProbe->WriteJson("FlowProbe.json");
+    }
 
     Simulator::Destroy();
+    DisableDistributedMode();
 
     std::clog.rdbuf(clog_buff); // Redirect clog to original buffer
 
@@ -693,8 +1232,19 @@ processFlowMonitor(Ptr<FlowMonitor> monitor, Ptr<ns3::FlowClassifier> flowClassi
     monitor->CheckForLostPackets();
     Ptr<Ipv4FlowClassifier> classifier =
         DynamicCast<Ipv4FlowClassifier>(flowClassifier);
-    FlowMonitor::FlowStatsContainer stats = monitor->GetFlowStats();
+    processFlowStats(monitor->GetFlowStats(),
+                     [classifier](FlowId flowId) { return classifier->FindFlow(flowId); },
+                     AppStartTime);
+}
 
+/**
+ * Writes FlowOutput.txt: tx/rx packets and bytes, throughput, mean delay and jitter of every flow
+ * 
+ * \param findFlow     five tuple of a flow id of stats
+*/
+static void
+processFlowStats(const FlowMonitor::FlowStatsContainer& stats, std::function<Ipv4FlowClassifier::FiveTuple(FlowId)> findFlow, double AppStartTime)
+{
     double averageFlowThroughput = 0.0;
     double averageFlowDelay = 0.0;
 
@@ -713,7 +1263,7 @@ processFlowMonitor(Ptr<FlowMonitor> monitor, Ptr<ns3::FlowClassifier> flowClassi
          i != stats.end();
          ++i)
     {
-        Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow(i->first);
+        Ipv4FlowClassifier::FiveTuple t = findFlow(i->first);
         std::stringstream protoStream;
         protoStream << (uint16_t)t.protocol;
         if (t.protocol == 6)
@@ -775,14 +1325,15 @@ processFlowMonitor(Ptr<FlowMonitor> monitor, Ptr<ns3::FlowClassifier> flowClassi
 static void
 UdpServerTracer(Ptr<OutputStreamWrapper> stream, Ptr<const Packet> p, const Address &srcAdd, const Address &destAdd)
 {
+    // The trace is fired before UdpServer removes the header, so it can be read in place
     SeqTsHeader seqTs;
-    p->Copy()->RemoveHeader(seqTs);
+    p->PeekHeader(seqTs);
     *stream->GetStream() << Simulator::Now().GetNanoSeconds() / (double)1e9 
                          << "\t" << p->GetSize()
                          << "\t" << InetSocketAddress::ConvertFrom(srcAdd).GetIpv4()
                          << "\t" << seqTs.GetSeq()
                          << "\t" << (Simulator::Now() - seqTs.GetTs()).GetNanoSeconds() / (double)1e9
-                         << std::endl;
+                         << "\n";
 }
 
 static void
@@ -792,6 +1343,7 @@ UdpServerMakeCallback(uint32_t nodeId)
     Ptr<OutputStreamWrapper> udpServerStream = asciiUdpServer.CreateFileStream("UdpRecv_Node"
                                         + std::to_string(nodeId) + ".txt");
 
+    udpServerStream->GetStream()->setf(std::ios_base::fixed);
     *udpServerStream->GetStream() << "Time (s)" << "\tPacket Size" 
                                   << "\tSource Address" << "\tPacket Sequence" 
                                   << "\tDelay" << std::endl;
@@ -801,6 +1353,15 @@ UdpServerMakeCallback(uint32_t nodeId)
     MakeBoundCallback(&UdpServerTracer, udpServerStream));
 }
 
+static Ptr<UdpRxAggregator>
+UdpServerMakeAggregator(uint32_t nodeId, Time interval)
+{
+    Ptr<UdpRxAggregator> aggregator = Create<UdpRxAggregator>("UdpRecvAgg_Node"
+                                        + std::to_string(nodeId) + ".txt", interval);
+    aggregator->Connect(nodeId);
+    return aggregator;
+}
+
 /**
  * CWND tracer.
  *
@@ -995,6 +1556,27 @@ static void InstallTCP2 (Ptr<Node> remoteHost,
                         uint16_t sinkPort,
                         float startTime,
                         float stopTime, float dataRate)
+{
+    Address sinkAddress = InstallTcpSink (receiver, sinkPort, startTime, stopTime);
+
+    Ptr<Socket> ns3TcpSocket = Socket::CreateSocket (remoteHost, TcpSocketFactory::GetTypeId ());
+    Ptr<MyApp> app = CreateObject<MyApp> ();
+    app->Setup (ns3TcpSocket, sinkAddress, SEGMENT_SIZE, 0xFFFFFFFF, DataRate (std::to_string(dataRate) + "Mb/s"));
+
+    remoteHost->AddApplication (app);
+
+
+    app->SetStartTime (Seconds (startTime));
+    app->SetStopTime (Seconds (stopTime));
+    
+}
+
+/**
+ * Installs the TCP PacketSink of a UE, shared by every TCP source (MyApp, TrafficEngine, replay)
+ * \return The address the source has to connect to
+ */
+static Address
+InstallTcpSink(Ptr<Node> receiver, uint16_t sinkPort, double startTime, double stopTime)
 {
     //Address sinkAddress (InetSocketAddress (ueIpIface.GetAddress (0), sinkPort));
     Address sinkAddress (InetSocketAddress (receiver->GetObject<Ipv4> ()->GetAddress (1,0).GetLocal (), sinkPort));
@@ -1006,16 +1588,32 @@ static void InstallTCP2 (Ptr<Node> remoteHost,
     sinkApps.Start (Seconds (startTime * 0.02));
     sinkApps.Stop (Seconds ((simTime - stopTime)*0.9 + stopTime));
 
-    Ptr<Socket> ns3TcpSocket = Socket::CreateSocket (remoteHost, TcpSocketFactory::GetTypeId ());
-    Ptr<MyApp> app = CreateObject<MyApp> ();
-    app->Setup (ns3TcpSocket, sinkAddress, SEGMENT_SIZE, 0xFFFFFFFF, DataRate (std::to_string(dataRate) + "Mb/s"));
-
-    remoteHost->AddApplication (app);
+    return sinkAddress;
+}
 
+/**
+ * Installs the UdpServer of a UE, shared by every UDP source (UdpClient, SlotBurstUdpClient, replay),
+ * and its rx output: per packet (UdpRecv_NodeN.txt) or per aggInterval (UdpRecvAgg_NodeN.txt, the
+ * aggregator is added to aggregators)
+ */
+static ApplicationContainer
+InstallUdpSink(Ptr<Node> receiver, uint16_t port, Time aggInterval, std::vector<Ptr<UdpRxAggregator>>& aggregators)
+{
+    UdpServerHelper dlPacketSinkHelper(port);
+    ApplicationContainer serverApps = dlPacketSinkHelper.Install(receiver);
 
-    app->SetStartTime (Seconds (startTime));
-    app->SetStopTime (Seconds (stopTime));
-    
+    if (IsLocal(receiver)) // The rx files are written by the rank of the UEs
+    {
+        if (aggInterval.IsStrictlyPositive())
+        {
+            aggregators.push_back(UdpServerMakeAggregator(receiver->GetId(), aggInterval));
+        }
+        else
+        {
+            UdpServerMakeCallback(receiver->GetId());
+        }
+    }
+    return serverApps;
 }
 
 /**
@@ -1124,3 +1722,55 @@ static void PrintNodeAddressInfo(bool ignore_localh)
 }
 
 #pragma endregion trace_n_utils_functions
+
+/**
+ * @brief Time the last application of the node stops sending: its StopTime (simEnd if it has none),
+ * or for a TrafficEngine the stop of its last flow if that comes first
+ */
+static Time
+GetTrafficEnd(Ptr<Node> node, Time simEnd)
+{
+    Time end;
+    for (uint32_t i = 0; i < node->GetNApplications(); ++i)
+    {
+        Ptr<Application> app = node->GetApplication(i);
+        TimeValue stop;
+        app->GetAttribute("StopTime", stop);
+        Time appEnd = stop.Get().IsZero() ? simEnd : std::min(stop.Get(), simEnd);
+        if (Ptr<TrafficEngine> engine = DynamicCast<TrafficEngine>(app))
+        {
+            appEnd = std::min(appEnd, engine->GetLastStop());
+        }
+        end = std::max(end, appEnd);
+    }
+    return end;
+}
+
+/**
+ * @brief Writes the cost of the run (scaling-benchmark reads it): setup and run wall time, events
+ * executed, events per wall second, wall seconds per simulated second, peak RSS and the counters of
+ * the caches that are enabled
+ */
+static void
+WriteRunStats(std::string filename, double setupTime, double runTime, const std::vector<std::pair<std::string, uint64_t>>& counters)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    double simulated = Simulator::Now().GetSeconds();
+    uint64_t events = Simulator::GetEventCount();
+
+    std::ofstream out(filename);
+    out << "setupTime\t" << setupTime << std::endl;
+    out << "runTime\t" << runTime << std::endl;
+    out << "simulatedTime\t" << simulated << std::endl;
+    out << "events\t" << events << std::endl;
+    out << "eventsPerSecond\t" << (runTime > 0 ? events / runTime : 0) << std::endl;
+    out << "wallPerSimSecond\t" << (simulated > 0 ? runTime / simulated : 0) << std::endl;
+    out << "nodes\t" << NodeList::GetNNodes() << std::endl;
+    out << "buildings\t" << BuildingList::GetNBuildings() << std::endl;
+    out << "peakRssKb\t" << usage.ru_maxrss << std::endl;
+    for (const auto& [name, value] : counters)
+    {
+        out << name << "\t" << value << std::endl;
+    }
+}
@@ -0,0 +1,332 @@
+#include "ns3/core-module.h"
+
+#include "slot-bucket-scheduler.h"
+
+#include <algorithm>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("SlotBucketScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED(SlotBucketScheduler);
+NS_OBJECT_ENSURE_REGISTERED(RecordingScheduler);
+
+TypeId
+SlotBucketScheduler::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::SlotBucketScheduler")
+            .SetParent<Scheduler>()
+            .SetGroupName("MyAppComp")
+            .AddConstructor<SlotBucketScheduler>()
+            .AddAttribute("BucketWidth",
+                          "Width of a bucket, the NR slot duration is a good value",
+                          TimeValue(MicroSeconds(125)),
+                          MakeTimeAccessor(&SlotBucketScheduler::SetBucketWidth),
+                          MakeTimeChecker(TimeStep(1)))
+            .AddAttribute("NBuckets",
+                          "Number of buckets, events after NBuckets*BucketWidth go to the overflow heap",
+                          UintegerValue(1024),
+                          MakeUintegerAccessor(&SlotBucketScheduler::SetNBuckets),
+                          MakeUintegerChecker<uint32_t>(1));
+    return tid;
+}
+
+SlotBucketScheduler::SlotBucketScheduler()
+    : m_width(MicroSeconds(125).GetTimeStep()),
+      m_nBuckets(1024),
+      m_base(0),
+      m_baseIdx(0),
+      m_inWindow(0),
+      m_cursor(0)
+{
+    Reset();
+}
+
+SlotBucketScheduler::~SlotBucketScheduler()
+{
+}
+
+void
+SlotBucketScheduler::SetBucketWidth(Time width)
+{
+    m_width = std::max<uint64_t>(1, width.GetTimeStep());
+    Reset();
+}
+
+void
+SlotBucketScheduler::SetNBuckets(uint32_t n)
+{
+    m_nBuckets = n;
+    Reset();
+}
+
+void
+SlotBucketScheduler::Reset()
+{
+    for (auto& bucket : m_buckets)
+    {
+        for (const Event& ev : bucket)
+        {
+            m_overflow.push_back(ev);
+        }
+    }
+    std::make_heap(m_overflow.begin(), m_overflow.end(), Later());
+
+    m_buckets.assign(m_nBuckets, std::vector<Event>());
+    m_base = 0;
+    m_baseIdx = 0;
+    m_inWindow = 0;
+    m_cursor = 0;
+}
+
+void
+SlotBucketScheduler::Insert(const Event& ev)
+{
+    NS_LOG_FUNCTION(this << ev.key.m_ts << ev.key.m_uid);
+    uint64_t ts = ev.key.m_ts;
+    NS_ASSERT_MSG(ts >= m_base, "Event before the window");
+
+    uint64_t offset = (ts - m_base) / m_width;
+    if (offset < m_nBuckets)
+    {
+        auto& bucket = m_buckets[(m_baseIdx + offset) % m_nBuckets];
+        bucket.push_back(ev);
+        std::push_heap(bucket.begin(), bucket.end(), Later());
+        if (m_inWindow == 0 || offset < m_cursor)
+        {
+            m_cursor = offset;
+        }
+        m_inWindow++;
+    }
+    else
+    {
+        m_overflow.push_back(ev);
+        std::push_heap(m_overflow.begin(), m_overflow.end(), Later());
+    }
+}
+
+bool
+SlotBucketScheduler::IsEmpty() const
+{
+    return m_inWindow == 0 && m_overflow.empty();
+}
+
+uint32_t
+SlotBucketScheduler::FindNextBucket() const
+{
+    NS_ASSERT(m_inWindow > 0);
+    while (m_buckets[(m_baseIdx + m_cursor) % m_nBuckets].empty())
+    {
+        m_cursor++;
+        NS_ASSERT(m_cursor < m_nBuckets);
+    }
+    return (m_baseIdx + m_cursor) % m_nBuckets;
+}
+
+Scheduler::Event
+SlotBucketScheduler::PeekNext() const
+{
+    NS_ASSERT(!IsEmpty());
+    if (m_inWindow == 0)
+    {
+        // Every event in the overflow is after the window, so the window minimum is the global one
+        return m_overflow.front();
+    }
+    return m_buckets[FindNextBucket()].front();
+}
+
+void
+SlotBucketScheduler::AdvanceTo(uint64_t ts)
+{
+    uint64_t newBase = ts - ts % m_width;
+    if (newBase > m_base)
+    {
+        uint64_t shift = (newBase - m_base) / m_width;
+        m_base = newBase;
+        m_baseIdx = (m_baseIdx + shift % m_nBuckets) % m_nBuckets;
+        m_cursor = (m_inWindow == 0 || shift > m_cursor) ? 0 : m_cursor - shift;
+    }
+
+    // Bring the overflow events the window now covers
+    uint64_t end = m_base + m_width * m_nBuckets;
+    while (!m_overflow.empty() && m_overflow.front().key.m_ts < end)
+    {
+        std::pop_heap(m_overflow.begin(), m_overflow.end(), Later());
+        Event ev = m_overflow.back();
+        m_overflow.pop_back();
+
+        uint64_t offset = (ev.key.m_ts - m_base) / m_width;
+        auto& bucket = m_buckets[(m_baseIdx + offset) % m_nBuckets];
+        bucket.push_back(ev);
+        std::push_heap(bucket.begin(), bucket.end(), Later());
+        if (m_inWindow == 0 || offset < m_cursor)
+        {
+            m_cursor = offset;
+        }
+        m_inWindow++;
+    }
+}
+
+Scheduler::Event
+SlotBucketScheduler::RemoveNext()
+{
+    NS_ASSERT(!IsEmpty());
+    if (m_inWindow == 0)
+    {
+        AdvanceTo(m_overflow.front().key.m_ts);
+    }
+
+    uint32_t idx = FindNextBucket();
+    auto& bucket = m_buckets[idx];
+    std::pop_heap(bucket.begin(), bucket.end(), Later());
+    Event ev = bucket.back();
+    bucket.pop_back();
+    m_inWindow--;
+
+    // The simulator time is now ev's, nothing can be inserted before its bucket
+    AdvanceTo(ev.key.m_ts);
+    NS_LOG_FUNCTION(this << ev.key.m_ts << ev.key.m_uid);
+    return ev;
+}
+
+void
+SlotBucketScheduler::Remove(const Event& ev)
+{
+    NS_LOG_FUNCTION(this << ev.key.m_ts << ev.key.m_uid);
+    auto same = [&ev](const Event& e) { return e.key.m_uid == ev.key.m_uid; };
+
+    uint64_t offset = (ev.key.m_ts - m_base) / m_width;
+    std::vector<Event>& heap =
+        offset < m_nBuckets ? m_buckets[(m_baseIdx + offset) % m_nBuckets] : m_overflow;
+    auto it = std::find_if(heap.begin(), heap.end(), same);
+    NS_ASSERT_MSG(it != heap.end(), "Event not found");
+    heap.erase(it);
+    std::make_heap(heap.begin(), heap.end(), Later());
+    if (offset < m_nBuckets)
+    {
+        m_inWindow--;
+    }
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+TypeId
+RecordingScheduler::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::RecordingScheduler")
+            .SetParent<Scheduler>()
+            .SetGroupName("MyAppComp")
+            .AddConstructor<RecordingScheduler>()
+            .AddAttribute("Inner",
+                          "TypeId of the scheduler that does the work",
+                          StringValue("ns3::MapScheduler"),
+                          MakeStringAccessor(&RecordingScheduler::SetInner),
+                          MakeStringChecker())
+            .AddAttribute("TraceFile",
+                          "File where the operations are written",
+                          StringValue("scheduler-trace.bin"),
+                          MakeStringAccessor(&RecordingScheduler::SetTraceFile),
+                          MakeStringChecker());
+    return tid;
+}
+
+RecordingScheduler::RecordingScheduler()
+{
+}
+
+RecordingScheduler::~RecordingScheduler()
+{
+}
+
+void
+RecordingScheduler::SetInner(std::string typeId)
+{
+    NS_ABORT_MSG_IF(m_inner && !m_inner->IsEmpty(), "Can't change the inner scheduler when in use");
+    ObjectFactory factory;
+    factory.SetTypeId(typeId);
+    m_inner = factory.Create<Scheduler>();
+}
+
+void
+RecordingScheduler::SetTraceFile(std::string filename)
+{
+    if (m_out.is_open())
+    {
+        m_out.close();
+    }
+    m_out.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    NS_ABORT_MSG_IF(!m_out.is_open(), "Can't open " << filename);
+}
+
+void
+RecordingScheduler::Write(const EventKey& key, Op op)
+{
+    Record record{key.m_ts, key.m_uid, op};
+    m_out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+}
+
+void
+RecordingScheduler::Insert(const Event& ev)
+{
+    Write(ev.key, INSERT);
+    m_inner->Insert(ev);
+}
+
+bool
+RecordingScheduler::IsEmpty() const
+{
+    return m_inner->IsEmpty();
+}
+
+Scheduler::Event
+RecordingScheduler::PeekNext() const
+{
+    return m_inner->PeekNext();
+}
+
+Scheduler::Event
+RecordingScheduler::RemoveNext()
+{
+    Event ev = m_inner->RemoveNext();
+    Write(ev.key, REMOVE_NEXT);
+    return ev;
+}
+
+void
+RecordingScheduler::Remove(const Event& ev)
+{
+    Write(ev.key, REMOVE);
+    m_inner->Remove(ev);
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+std::string
+SchedulerTypeName(std::string name)
+{
+    if (name == "Map" || name == "Heap" || name == "List" || name == "Calendar" ||
+        name == "PriorityQueue" || name == "SlotBucket" || name == "NodeOrder")
+    {
+        return "ns3::" + name + "Scheduler";
+    }
+    return name;
+}
+
+void
+SelectScheduler(std::string name, std::string traceFile)
+{
+    ObjectFactory factory;
+    if (traceFile.empty())
+    {
+        factory.SetTypeId(SchedulerTypeName(name));
+    }
+    else
+    {
+        factory.SetTypeId(RecordingScheduler::GetTypeId());
+        factory.Set("Inner", StringValue(SchedulerTypeName(name)));
+        factory.Set("TraceFile", StringValue(traceFile));
+    }
+    Simulator::SetScheduler(factory);
+}
@@ -0,0 +1,125 @@
+#ifndef SLOT_BUCKET_SCHEDULER_H
+#define SLOT_BUCKET_SCHEDULER_H
+
+#include "ns3/core-module.h"
+
+#include <fstream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Bucket (calendar) event queue tuned for NR: the near future is split in NBuckets buckets of
+ * BucketWidth (by default an NR slot at numerology 3, 125 us), each one a small binary heap, so the
+ * dense per slot/symbol events are inserted and removed in a bucket of a few events. Events beyond the
+ * buckets horizon (TCP timers, CalculatePosition, app start/stop...) wait in an overflow heap and are
+ * moved to their bucket when the window reaches them.
+ *
+ * Select it with Simulator::SetScheduler or --scheduler=SlotBucket.
+ */
+class SlotBucketScheduler : public Scheduler
+{
+public:
+    static TypeId GetTypeId();
+    SlotBucketScheduler();
+    ~SlotBucketScheduler() override;
+
+    void Insert(const Event& ev) override;
+    bool IsEmpty() const override;
+    Event PeekNext() const override;
+    Event RemoveNext() override;
+    void Remove(const Event& ev) override;
+
+private:
+    /** Min-heap order */
+    struct Later
+    {
+        bool operator()(const Event& a, const Event& b) const
+        {
+            return b.key < a.key;
+        }
+    };
+
+    void SetBucketWidth(Time width);
+    void SetNBuckets(uint32_t n);
+
+    /**
+     * @brief (Re)creates the buckets, every event is moved to the overflow heap
+     */
+    void Reset();
+
+    /**
+     * @brief Index of the first non empty bucket from the cursor, the window must have events
+     */
+    uint32_t FindNextBucket() const;
+
+    /**
+     * @brief Moves the window so it starts at the bucket of ts, and brings the overflow events that
+     * now fall inside it
+     */
+    void AdvanceTo(uint64_t ts);
+
+    uint64_t m_width;                           //!< Bucket width in time steps
+    uint32_t m_nBuckets;
+    std::vector<std::vector<Event>> m_buckets;  //!< Heaps of the events in the window
+    std::vector<Event> m_overflow;              //!< Heap of the events after the window
+    uint64_t m_base;                            //!< Start of the window (multiple of m_width)
+    uint32_t m_baseIdx;                         //!< Bucket of m_base
+    uint64_t m_inWindow;                        //!< Events in the buckets
+    mutable uint32_t m_cursor;                  //!< Offset from m_baseIdx of the first non empty bucket
+};
+
+/**
+ * Scheduler that forwards everything to another one (Inner) and writes every operation to a binary
+ * file, to replay the event pattern of a scenario in scheduler-benchmark. Records are
+ * { uint64_t ts; uint32_t uid; uint32_t op } with op 0: Insert, 1: RemoveNext, 2: Remove.
+ */
+class RecordingScheduler : public Scheduler
+{
+public:
+    enum Op : uint32_t
+    {
+        INSERT = 0,
+        REMOVE_NEXT = 1,
+        REMOVE = 2
+    };
+
+    struct Record
+    {
+        uint64_t ts;
+        uint32_t uid;
+        uint32_t op;
+    };
+
+    static TypeId GetTypeId();
+    RecordingScheduler();
+    ~RecordingScheduler() override;
+
+    void Insert(const Event& ev) override;
+    bool IsEmpty() const override;
+    Event PeekNext() const override;
+    Event RemoveNext() override;
+    void Remove(const Event& ev) override;
+
+private:
+    void SetInner(std::string typeId);
+    void SetTraceFile(std::string filename);
+    void Write(const EventKey& key, Op op);
+
+    Ptr<Scheduler> m_inner;
+    std::ofstream m_out;
+};
+
+/**
+ * @brief Sets the simulator scheduler from a short name: Map, Heap, List, Calendar, PriorityQueue,
+ * SlotBucket or NodeOrder (or a full TypeId). If traceFile is not empty the scheduler is wrapped in a
+ * RecordingScheduler that writes its operations there
+ */
+void SelectScheduler(std::string name, std::string traceFile = "");
+
+/**
+ * @brief TypeId name of a scheduler short name (see SelectScheduler)
+ */
+std::string SchedulerTypeName(std::string name);
+
+#endif // SLOT_BUCKET_SCHEDULER_H
@@ -0,0 +1,42 @@
+#include "ns3/core-module.h"
+#include "ns3/spectrum-module.h"
+
+#include "spectrum-pool.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("SpectrumValuePool");
+
+Ptr<SpectrumValue>
+SpectrumValuePool::Get(Ptr<const SpectrumModel> model)
+{
+    Buffers& buffers = m_buffers[model->GetUid()];
+    uint32_t n = buffers.values.size();
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        uint32_t index = (buffers.next + i) % n;
+        Ptr<SpectrumValue>& value = buffers.values[index];
+        if (value->GetReferenceCount() == 1)
+        {
+            buffers.next = (index + 1) % n;
+            *value = 0.0;
+            return value;
+        }
+    }
+
+    buffers.values.push_back(Create<SpectrumValue>(model));
+    buffers.next = 0;
+    NS_LOG_INFO("Spectrum model " << model->GetUid() << ": " << buffers.values.size() << " buffers");
+    return buffers.values.back();
+}
+
+uint32_t
+SpectrumValuePool::GetN() const
+{
+    uint32_t n = 0;
+    for (const auto& [uid, buffers] : m_buffers)
+    {
+        n += buffers.values.size();
+    }
+    return n;
+}
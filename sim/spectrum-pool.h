@@ -0,0 +1,48 @@
+#ifndef SPECTRUM_POOL_H
+#define SPECTRUM_POOL_H
+
+#include "ns3/core-module.h"
+#include "ns3/spectrum-module.h"
+
+#include <map>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Recycled SpectrumValue buffers of fixed spectrum models.
+ *
+ * A SpectrumValue allocates its vector of values when it is created, and the PHY path creates
+ * several per signal (PSDs, gains) that die a few events later. The pool keeps the buffers it hands
+ * out and gives one back once nobody else references it, so after the first slots (when the buffers
+ * in flight are created) Get does not allocate.
+ *
+ * Only the buffers of this project come from the pool (CoarseSpectrumPropagationLossModel); the
+ * PSDs created by the LENA PHYs (NrUePhy, NrGnbPhy, NrSpectrumPhy) are still allocated per signal,
+ * since those sources are not among the patched copies of to_replace_in_src.
+ */
+class SpectrumValuePool
+{
+public:
+    /**
+     * @return Buffer of the spectrum model with every value at 0, only referenced by the pool
+     */
+    Ptr<SpectrumValue> Get(Ptr<const SpectrumModel> model);
+
+    /**
+     * @return Buffers created by the pool
+     */
+    uint32_t GetN() const;
+
+private:
+    /** Buffers of one spectrum model */
+    struct Buffers
+    {
+        std::vector<Ptr<SpectrumValue>> values;
+        uint32_t next{0};   //!< Where the search of a free one starts (the oldest one handed out)
+    };
+
+    std::map<SpectrumModelUid_t, Buffers> m_buffers;
+};
+
+#endif // SPECTRUM_POOL_H
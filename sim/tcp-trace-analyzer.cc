@@ -0,0 +1,221 @@
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include "tcp-trace-analyzer.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("TcpTraceAnalyzer");
+
+NS_OBJECT_ENSURE_REGISTERED(TcpTraceAnalyzer);
+
+TcpTraceAnalyzer::TcpTraceAnalyzer()
+    : m_ackTimeout(Seconds(3)),
+      m_maxPending(1 << 20),
+      m_finished(false)
+{
+}
+
+TcpTraceAnalyzer::~TcpTraceAnalyzer()
+{
+}
+
+TypeId
+TcpTraceAnalyzer::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::TcpTraceAnalyzer")
+            .SetParent<Object>()
+            .SetGroupName("MyAppComp")
+            .AddConstructor<TcpTraceAnalyzer>()
+            .AddAttribute("AckTimeout",
+                          "Time a segment waits for its ACK before being counted as dropped",
+                          TimeValue(Seconds(3)),
+                          MakeTimeAccessor(&TcpTraceAnalyzer::m_ackTimeout),
+                          MakeTimeChecker())
+            .AddAttribute("MaxPending",
+                          "Maximum number of segments waiting for an ACK, older ones are counted as dropped",
+                          UintegerValue(1 << 20),
+                          MakeUintegerAccessor(&TcpTraceAnalyzer::m_maxPending),
+                          MakeUintegerChecker<uint32_t>(1));
+    return tid;
+}
+
+void
+TcpTraceAnalyzer::DoDispose()
+{
+    Finish();
+    Object::DoDispose();
+}
+
+void
+TcpTraceAnalyzer::Install(Ptr<Node> node, std::string perFile, std::string delayFile)
+{
+    m_perOut.open(perFile, std::ofstream::out | std::ofstream::trunc);
+    m_delayOut.open(delayFile, std::ofstream::out | std::ofstream::trunc);
+    if (!m_perOut.is_open() || !m_delayOut.is_open())
+    {
+        NS_FATAL_ERROR("Can't open " << perFile << " or " << delayFile);
+    }
+
+    // Fixed notation (microseconds) as the other outputs, the default 6 digits lose the sub ms part
+    m_perOut.setf(std::ios_base::fixed);
+    m_delayOut.setf(std::ios_base::fixed);
+    m_perOut << "Time\tBytesTx\tBytesDroped\tPacketsTx\tPacketsDroped\n";
+    m_delayOut << "Time\tseq\trtt\n";
+
+    Ptr<Ipv4L3Protocol> ipv4 = node->GetObject<Ipv4L3Protocol>();
+    NS_ABORT_MSG_IF(!ipv4, "Node " << node->GetId() << " has no IPv4 stack");
+    // These sources hand the IPv4 header apart from the packet, so the TCP header can be peeked in place
+    ipv4->TraceConnectWithoutContext("SendOutgoing", MakeCallback(&TcpTraceAnalyzer::TxTrace, this));
+    ipv4->TraceConnectWithoutContext("LocalDeliver", MakeCallback(&TcpTraceAnalyzer::RxTrace, this));
+}
+
+void
+TcpTraceAnalyzer::Finish()
+{
+    if (m_finished || !m_perOut.is_open())
+    {
+        return;
+    }
+    m_finished = true;
+
+    Flush(true);
+    m_perOut.close();
+    m_delayOut.close();
+}
+
+bool
+TcpTraceAnalyzer::ParseTcp(const Ipv4Header& ipHeader, Ptr<const Packet> packet, TcpHeader& tcpHeader)
+{
+    if (ipHeader.GetProtocol() != TcpL4Protocol::PROT_NUMBER)
+    {
+        return false;
+    }
+    packet->PeekHeader(tcpHeader);
+    return true;
+}
+
+uint64_t
+TcpTraceAnalyzer::MakeKey(uint16_t port, uint32_t seq)
+{
+    return (static_cast<uint64_t>(port) << 32) | seq;
+}
+
+void
+TcpTraceAnalyzer::TxTrace(const Ipv4Header& ipHeader, Ptr<const Packet> packet, uint32_t interface [[maybe_unused]])
+{
+    TcpHeader tcpHeader;
+    if (m_finished || !ParseTcp(ipHeader, packet, tcpHeader))
+    {
+        return;
+    }
+
+    Time now = Simulator::Now();
+    uint32_t payload = ipHeader.GetPayloadSize() - tcpHeader.GetLength() * 4;
+    uint32_t expectedAck = tcpHeader.GetSequenceNumber().GetValue() + payload;
+    uint64_t key = MakeKey(tcpHeader.GetDestinationPort(), expectedAck);
+    uint32_t size = ipHeader.GetPayloadSize() + ipHeader.GetSerializedSize();
+
+    // Every transmission counts as dropped until its ACK shows up
+    PerRow& row = m_perRows[now.GetTimeStep()];
+    row.bytesTx += size;
+    row.bytesDrop += size;
+    row.packetsTx++;
+    row.packetsDrop++;
+
+    auto it = m_segments.find(key);
+    if (it == m_segments.end())
+    {
+        m_segments.emplace(key, Segment{now, now, Time(0), size, false});
+    }
+    else
+    {
+        // Retransmission: the previous one stays dropped, the RTT keeps the first transmission
+        it->second.lastTx = now;
+        it->second.size = size;
+        it->second.acked = false;
+    }
+    m_txOrder.emplace_back(key, now);
+
+    Flush(false);
+}
+
+void
+TcpTraceAnalyzer::RxTrace(const Ipv4Header& ipHeader, Ptr<const Packet> packet, uint32_t interface [[maybe_unused]])
+{
+    TcpHeader tcpHeader;
+    if (m_finished || !ParseTcp(ipHeader, packet, tcpHeader) ||
+        !(tcpHeader.GetFlags() & TcpHeader::ACK))
+    {
+        return;
+    }
+
+    uint64_t key = MakeKey(tcpHeader.GetSourcePort(), tcpHeader.GetAckNumber().GetValue());
+    auto it = m_segments.find(key);
+    if (it == m_segments.end() || it->second.acked)
+    {
+        return;
+    }
+
+    Segment& seg = it->second;
+    seg.acked = true;
+    if (seg.rtt.IsZero())
+    {
+        seg.rtt = Simulator::Now() - seg.firstTx;
+    }
+
+    auto rowIt = m_perRows.find(seg.lastTx.GetTimeStep());
+    if (rowIt != m_perRows.end())
+    {
+        rowIt->second.bytesDrop -= seg.size;
+        rowIt->second.packetsDrop--;
+    }
+}
+
+void
+TcpTraceAnalyzer::Flush(bool force)
+{
+    Time now = Simulator::Now();
+
+    while (!m_txOrder.empty())
+    {
+        auto [key, txTime] = m_txOrder.front();
+        auto it = m_segments.find(key);
+
+        if (it != m_segments.end() && it->second.lastTx == txTime)
+        {
+            const Segment& seg = it->second;
+            bool expired = now - txTime > m_ackTimeout || m_txOrder.size() > m_maxPending;
+            if (!seg.acked && !expired && !force)
+            {
+                break;
+            }
+            if (!seg.rtt.IsZero())
+            {
+                m_delayOut << seg.firstTx.GetSeconds() << "\t" << (key & 0xFFFFFFFF) << "\t"
+                           << seg.rtt.GetSeconds() << "\n";
+            }
+            m_segments.erase(it);
+        }
+        // else: stale entry of a retransmitted segment, its row is already final
+        m_txOrder.pop_front();
+    }
+
+    // Rows older than the oldest segment still waiting can not change anymore
+    int64_t limit = m_txOrder.empty() ? now.GetTimeStep() + 1 : m_txOrder.front().second.GetTimeStep();
+    if (force)
+    {
+        limit = std::numeric_limits<int64_t>::max();
+    }
+
+    auto rowIt = m_perRows.begin();
+    while (rowIt != m_perRows.end() && rowIt->first < limit)
+    {
+        const PerRow& row = rowIt->second;
+        m_perOut << Time(rowIt->first).GetSeconds() << "\t" << row.bytesTx << "\t" << row.bytesDrop
+                 << "\t" << row.packetsTx << "\t" << row.packetsDrop << "\n";
+        rowIt = m_perRows.erase(rowIt);
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef TCP_TRACE_ANALYZER_H
+#define TCP_TRACE_ANALYZER_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <deque>
+#include <fstream>
+#include <map>
+#include <unordered_map>
+
+using namespace ns3;
+
+/**
+ * Online replacement of the "tcp-all-ascii.txt + packet-error-rate.sh" post-process.
+ *
+ * It listens to the Ipv4L3Protocol SendOutgoing/LocalDeliver trace sources of the TCP sender (the
+ * remote host) and matches every transmitted segment (expected ACK = Seq + payload) with the ACKs received back.
+ * It writes the same tables the awk script used to build:
+ *
+ *  - tcp-per.txt:   Time BytesTx BytesDroped PacketsTx PacketsDroped  (per tx timestamp)
+ *  - tcp-delay.txt: Time seq rtt                                      (per acked segment)
+ *
+ * Memory is bounded: a segment waits at most AckTimeout for its ACK (and there are at most
+ * MaxPending segments waiting), after that it is counted as dropped and its rows are written.
+ */
+class TcpTraceAnalyzer : public Object
+{
+public:
+    TcpTraceAnalyzer();
+    ~TcpTraceAnalyzer() override;
+    static TypeId GetTypeId();
+
+    /**
+     * @brief Opens the output files and connects to the SendOutgoing/LocalDeliver traces of the node's
+     * IPv4 stack
+     * @param node The TCP sender (remote host)
+     * @param perFile Output file of the per time PER table
+     * @param delayFile Output file of the RTT table
+     */
+    void Install(Ptr<Node> node, std::string perFile = "tcp-per.txt", std::string delayFile = "tcp-delay.txt");
+
+    /**
+     * @brief Flushes every pending segment and row and closes the files. Call it after Simulator::Run()
+     */
+    void Finish();
+
+private:
+    void DoDispose() override;
+
+    void TxTrace(const Ipv4Header& ipHeader, Ptr<const Packet> packet, uint32_t interface);
+    void RxTrace(const Ipv4Header& ipHeader, Ptr<const Packet> packet, uint32_t interface);
+
+    /**
+     * @brief Peeks the TCP header of an IPv4 payload (the packet without its IPv4 header)
+     * @return false if the packet is not TCP
+     */
+    static bool ParseTcp(const Ipv4Header& ipHeader, Ptr<const Packet> packet, TcpHeader& tcpHeader);
+
+    /**
+     * @brief Key of a segment: the data port of the connection and the expected ACK number, so
+     * parallel flows towards several UEs do not mix their sequence numbers
+     */
+    static uint64_t MakeKey(uint16_t port, uint32_t seq);
+
+    /**
+     * @brief Retires segments that got their ACK, timed out or overflow MaxPending, and writes every
+     * row that can no longer change. If force is set everything is retired (end of simulation)
+     */
+    void Flush(bool force);
+
+    /** Segment waiting to be retired */
+    struct Segment
+    {
+        Time firstTx;           //!< First transmission, used for the RTT
+        Time lastTx;            //!< Last (re)transmission, row of the PER table accounting the segment
+        Time rtt;               //!< RTT of the first ACK, zero while not acked
+        uint32_t size;          //!< IPv4 total length
+        bool acked;             //!< Whether the last transmission was acked
+    };
+
+    /** Row of tcp-per.txt */
+    struct PerRow
+    {
+        uint64_t bytesTx{0};
+        int64_t bytesDrop{0};
+        uint32_t packetsTx{0};
+        int32_t packetsDrop{0};
+    };
+
+    std::unordered_map<uint64_t, Segment> m_segments;       //!< Segments by key
+    std::deque<std::pair<uint64_t, Time>> m_txOrder;        //!< (key, tx time) in transmission order
+    std::map<int64_t, PerRow> m_perRows;                    //!< Open PER rows by tx time (ns)
+
+    Time m_ackTimeout;          //!< Time a segment waits for its ACK
+    uint32_t m_maxPending;      //!< Max number of segments waiting for an ACK
+    bool m_finished;
+
+    std::ofstream m_perOut;
+    std::ofstream m_delayOut;
+};
+
+#endif // TCP_TRACE_ANALYZER_H
@@ -0,0 +1,315 @@
+#include "ns3/core-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include "trace-replay.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("TraceReplayApp");
+
+NS_OBJECT_ENSURE_REGISTERED(TraceReplayApp);
+
+TypeId
+TraceReplayApp::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::TraceReplayApp")
+            .SetParent<Application>()
+            .SetGroupName("MyAppComp")
+            .AddConstructor<TraceReplayApp>()
+            .AddAttribute("TraceFile",
+                          "Binary trace to replay (see OtherScripts/trace_converter.py)",
+                          StringValue(""),
+                          MakeStringAccessor(&TraceReplayApp::m_traceFile),
+                          MakeStringChecker())
+            .AddAttribute("Protocol",
+                          "The type of protocol to use: ns3::TcpSocketFactory or ns3::UdpSocketFactory",
+                          TypeIdValue(UdpSocketFactory::GetTypeId()),
+                          MakeTypeIdAccessor(&TraceReplayApp::m_protocol),
+                          MakeTypeIdChecker())
+            .AddAttribute("Remote",
+                          "The address of the destination",
+                          AddressValue(),
+                          MakeAddressAccessor(&TraceReplayApp::m_peer),
+                          MakeAddressChecker())
+            .AddAttribute("TimeScale",
+                          "Factor applied to the trace timestamps (0.5 replays twice as fast)",
+                          DoubleValue(1.0),
+                          MakeDoubleAccessor(&TraceReplayApp::m_timeScale),
+                          MakeDoubleChecker<double>(1e-9))
+            .AddAttribute("Loop",
+                          "Start again from the beginning when the trace ends",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&TraceReplayApp::m_loop),
+                          MakeBooleanChecker())
+            .AddAttribute("Flow",
+                          "Flow of the trace to replay, 4294967295 replays every flow",
+                          UintegerValue(std::numeric_limits<uint32_t>::max()),
+                          MakeUintegerAccessor(&TraceReplayApp::m_flowFilter),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("PrefetchBytes",
+                          "Bytes of the trace the kernel is asked to read ahead",
+                          UintegerValue(4 << 20),
+                          MakeUintegerAccessor(&TraceReplayApp::m_prefetchBytes),
+                          MakeUintegerChecker<uint32_t>(4096));
+    return tid;
+}
+
+TraceReplayApp::TraceReplayApp()
+    : m_socket(nullptr),
+      m_fd(-1),
+      m_map(nullptr),
+      m_mapSize(0),
+      m_records(nullptr),
+      m_nRecords(0),
+      m_next(0),
+      m_prefetched(0),
+      m_firstTs(0),
+      m_loopSpan(0),
+      m_loops(0),
+      m_seq(0),
+      m_tcpPending(0),
+      m_replayed(0)
+{
+}
+
+TraceReplayApp::~TraceReplayApp()
+{
+    CloseTrace();
+}
+
+void
+TraceReplayApp::DoDispose()
+{
+    CloseTrace();
+    m_socket = nullptr;
+    Application::DoDispose();
+}
+
+uint64_t
+TraceReplayApp::GetReplayed() const
+{
+    return m_replayed;
+}
+
+void
+TraceReplayApp::OpenTrace()
+{
+    m_fd = open(m_traceFile.c_str(), O_RDONLY);
+    NS_ABORT_MSG_IF(m_fd < 0, "Can't open trace " << m_traceFile << ": " << std::strerror(errno));
+
+    struct stat st;
+    fstat(m_fd, &st);
+    m_mapSize = st.st_size;
+    NS_ABORT_MSG_IF(m_mapSize < sizeof(TraceFileHeader), "Trace " << m_traceFile << " is too small");
+
+    void* map = mmap(nullptr, m_mapSize, PROT_READ, MAP_SHARED, m_fd, 0);
+    NS_ABORT_MSG_IF(map == MAP_FAILED, "Can't map trace " << m_traceFile << ": " << std::strerror(errno));
+    m_map = static_cast<uint8_t*>(map);
+    madvise(m_map, m_mapSize, MADV_SEQUENTIAL);
+
+    const TraceFileHeader* header = reinterpret_cast<const TraceFileHeader*>(m_map);
+    NS_ABORT_MSG_IF(std::memcmp(header->magic, "NSTR", 4) != 0 || header->version != 1,
+                    "Trace " << m_traceFile << " is not a version 1 NSTR trace");
+    m_records = reinterpret_cast<const TraceRecord*>(m_map + sizeof(TraceFileHeader));
+    m_nRecords = std::min<uint64_t>(header->records,
+                                    (m_mapSize - sizeof(TraceFileHeader)) / sizeof(TraceRecord));
+    NS_ABORT_MSG_IF(m_nRecords == 0, "Trace " << m_traceFile << " has no records");
+
+    // A loop lasts until the last record plus the mean gap between records
+    uint64_t first = m_records[0].timestampNs;
+    m_firstTs = first;
+    uint64_t last = m_records[m_nRecords - 1].timestampNs;
+    m_loopSpan = last - first + (m_nRecords > 1 ? (last - first) / (m_nRecords - 1) : 1);
+    m_loopSpan = std::max<uint64_t>(m_loopSpan, 1);
+
+    NS_LOG_INFO("Trace " << m_traceFile << ": " << m_nRecords << " records, "
+                         << (last - first) / 1e9 << " s");
+}
+
+void
+TraceReplayApp::CloseTrace()
+{
+    if (m_map)
+    {
+        munmap(m_map, m_mapSize);
+        m_map = nullptr;
+        m_records = nullptr;
+    }
+    if (m_fd >= 0)
+    {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+void
+TraceReplayApp::Prefetch()
+{
+    // Ask for the next window when half of the previous one was consumed
+    uint64_t window = std::max<uint64_t>(1, m_prefetchBytes / sizeof(TraceRecord));
+    if (m_next + window / 2 < m_prefetched && m_prefetched != 0)
+    {
+        return;
+    }
+
+    long page = sysconf(_SC_PAGESIZE);
+    auto pageOf = [page](const void* p) {
+        return reinterpret_cast<uint8_t*>(reinterpret_cast<uintptr_t>(p) & ~(static_cast<uintptr_t>(page) - 1));
+    };
+
+    uint64_t end = std::min(m_nRecords, m_next + window);
+    uint8_t* from = pageOf(m_records + m_next);
+    uint8_t* to = reinterpret_cast<uint8_t*>(const_cast<TraceRecord*>(m_records + end));
+    madvise(from, to - from, MADV_WILLNEED);
+
+    // What was already replayed is not needed anymore (unless looping, the kernel reads it again)
+    uint8_t* done = pageOf(m_records + m_next);
+    if (done > m_map)
+    {
+        madvise(m_map, done - m_map, MADV_DONTNEED);
+    }
+    m_prefetched = end;
+}
+
+void
+TraceReplayApp::StartApplication()
+{
+    NS_LOG_FUNCTION(this);
+    if (!m_map)
+    {
+        OpenTrace();
+    }
+    // Every loop must move the clock, otherwise Replay would wrap the trace forever in the same event
+    NS_ABORT_MSG_IF(m_loop && m_loopSpan * m_timeScale < 1,
+                    "The looped trace " << m_traceFile << " lasts less than 1 ns with TimeScale "
+                                        << m_timeScale);
+
+    if (!m_socket)
+    {
+        m_socket = Socket::CreateSocket(GetNode(), m_protocol);
+        m_socket->Bind();
+        m_socket->Connect(m_peer);
+        m_socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+        if (m_protocol == TcpSocketFactory::GetTypeId())
+        {
+            m_socket->SetSendCallback(MakeCallback(&TraceReplayApp::TcpSendPending, this));
+        }
+    }
+
+    m_next = 0;
+    m_prefetched = 0;
+    m_loops = 0;
+    m_startTime = Simulator::Now();
+    Prefetch();
+    Replay();
+}
+
+void
+TraceReplayApp::StopApplication()
+{
+    NS_LOG_FUNCTION(this);
+    m_event.Cancel();
+    if (m_socket)
+    {
+        m_socket->Close();
+    }
+}
+
+Time
+TraceReplayApp::RecordTime(const TraceRecord& record) const
+{
+    double ns = static_cast<double>(record.timestampNs - m_firstTs +
+                                    static_cast<uint64_t>(m_loops) * m_loopSpan);
+    return m_startTime + NanoSeconds(static_cast<int64_t>(ns * m_timeScale));
+}
+
+void
+TraceReplayApp::Replay()
+{
+    Time now = Simulator::Now();
+    while (true)
+    {
+        if (m_next >= m_nRecords)
+        {
+            if (!m_loop)
+            {
+                NS_LOG_INFO("Trace finished, " << m_replayed << " records replayed");
+                return;
+            }
+            m_next = 0;
+            m_prefetched = 0;
+            m_loops++;
+        }
+
+        const TraceRecord& record = m_records[m_next];
+        Time at = RecordTime(record);
+        if (at > now)
+        {
+            m_event = Simulator::Schedule(at - now, &TraceReplayApp::Replay, this);
+            break;
+        }
+
+        if (m_flowFilter == std::numeric_limits<uint32_t>::max() || record.flow == m_flowFilter)
+        {
+            SendRecord(record);
+        }
+        m_next++;
+        Prefetch();
+    }
+}
+
+void
+TraceReplayApp::SendRecord(const TraceRecord& record)
+{
+    m_replayed++;
+    if (record.size == 0)
+    {
+        return;
+    }
+
+    if (m_protocol == TcpSocketFactory::GetTypeId())
+    {
+        m_tcpPending += record.size;
+        TcpSendPending(m_socket, m_socket->GetTxAvailable());
+        return;
+    }
+
+    SeqTsHeader seqTs;
+    if (record.size >= seqTs.GetSerializedSize())
+    {
+        seqTs.SetSeq(m_seq++);
+        Ptr<Packet> p = Create<Packet>(record.size - seqTs.GetSerializedSize());
+        p->AddHeader(seqTs);
+        m_socket->Send(p);
+    }
+    else
+    {
+        m_socket->Send(Create<Packet>(record.size));
+    }
+}
+
+void
+TraceReplayApp::TcpSendPending(Ptr<Socket> socket, uint32_t available)
+{
+    while (m_tcpPending > 0 && available > 0)
+    {
+        uint32_t chunk = static_cast<uint32_t>(std::min<uint64_t>(m_tcpPending, available));
+        int sent = socket->Send(Create<Packet>(chunk));
+        if (sent <= 0)
+        {
+            break;
+        }
+        m_tcpPending -= sent;
+        available = socket->GetTxAvailable();
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef TRACE_REPLAY_H
+#define TRACE_REPLAY_H
+
+#include "ns3/core-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+using namespace ns3;
+
+/**
+ * Binary trace format read by TraceReplayApp (written by OtherScripts/trace_converter.py):
+ *
+ *  header: char magic[4] = "NSTR", uint32_t version = 1, uint64_t number of records
+ *  records: TraceRecord[n], little endian, sorted by timestamp
+ */
+struct TraceFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t records;
+};
+
+struct TraceRecord
+{
+    uint64_t timestampNs;   //!< Time of the packet since the start of the trace
+    uint32_t size;          //!< Application payload in bytes
+    uint32_t flow;          //!< Flow of the packet in the original capture
+};
+
+static_assert(sizeof(TraceFileHeader) == 16, "TraceFileHeader must be packed");
+static_assert(sizeof(TraceRecord) == 16, "TraceRecord must be packed");
+
+/**
+ * Application that replays a packet trace (timestamp, size, flow) through a TCP or UDP socket.
+ *
+ * The trace is memory mapped, never loaded: the application walks the mapping and asks the kernel to
+ * prefetch the next PrefetchBytes (and to drop what was already replayed), so multi hour traces only
+ * cost their working set. Timestamps can be scaled (TimeScale) and the trace looped (Loop), as long as
+ * the scaled trace lasts at least 1 ns (the app aborts otherwise). All the records due at the same
+ * time are sent in the same event. UDP packets carry a SeqTsHeader (when they are big enough), TCP
+ * data that does not fit in the socket buffer waits for the send callback.
+ */
+class TraceReplayApp : public Application
+{
+public:
+    static TypeId GetTypeId();
+    TraceReplayApp();
+    ~TraceReplayApp() override;
+
+    /**
+     * @return Number of records replayed (packets or TCP writes)
+     */
+    uint64_t GetReplayed() const;
+
+private:
+    void DoDispose() override;
+    void StartApplication() override;
+    void StopApplication() override;
+
+    void OpenTrace();
+    void CloseTrace();
+
+    /**
+     * @brief Sends every record due and schedules the next one
+     */
+    void Replay();
+
+    /**
+     * @brief Time (since the start of the app) of a record, with the scale and loop offset
+     */
+    Time RecordTime(const TraceRecord& record) const;
+
+    void Prefetch();
+    void SendRecord(const TraceRecord& record);
+    void TcpSendPending(Ptr<Socket> socket, uint32_t available);
+
+    // Attributes
+    std::string m_traceFile;
+    TypeId m_protocol;
+    Address m_peer;
+    double m_timeScale;
+    bool m_loop;
+    uint32_t m_flowFilter;          //!< Flow to replay, UINT32_MAX replays all
+    uint32_t m_prefetchBytes;
+
+    Ptr<Socket> m_socket;
+    EventId m_event;
+
+    // Mapping
+    int m_fd;
+    uint8_t* m_map;
+    size_t m_mapSize;
+    const TraceRecord* m_records;
+    uint64_t m_nRecords;
+    uint64_t m_next;                //!< Next record to replay
+    uint64_t m_prefetched;          //!< Records up to this one were prefetched
+
+    Time m_startTime;               //!< Time of the first record of the current loop
+    uint64_t m_firstTs;             //!< Timestamp of the first record (the header page can be dropped)
+    uint64_t m_loopSpan;            //!< Duration of the trace in ns (loop offset)
+    uint32_t m_loops;
+    uint32_t m_seq;
+    uint64_t m_tcpPending;          //!< TCP bytes waiting for room in the socket buffer
+    uint64_t m_replayed;
+};
+
+#endif // TRACE_REPLAY_H
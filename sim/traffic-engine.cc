@@ -0,0 +1,317 @@
+#include "ns3/core-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include "traffic-engine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("TrafficEngine");
+
+NS_OBJECT_ENSURE_REGISTERED(TrafficEngine);
+
+static constexpr uint64_t NO_TICK = std::numeric_limits<uint64_t>::max();
+
+TypeId
+TrafficEngine::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::TrafficEngine")
+            .SetParent<Application>()
+            .SetGroupName("MyAppComp")
+            .AddConstructor<TrafficEngine>()
+            .AddAttribute("Tick",
+                          "Granularity of the timer wheel, flows are served at most once per tick",
+                          TimeValue(MicroSeconds(125)),
+                          MakeTimeAccessor(&TrafficEngine::m_tick),
+                          MakeTimeChecker(NanoSeconds(1)));
+    return tid;
+}
+
+TrafficEngine::TrafficEngine()
+    : m_now(0),
+      m_pending(0),
+      m_wakeUps(0)
+{
+}
+
+TrafficEngine::~TrafficEngine()
+{
+}
+
+uint32_t
+TrafficEngine::AddFlow(FlowType type, Address peer, DataRate rate, uint32_t packetSize, Time start, Time stop)
+{
+    NS_LOG_FUNCTION(this << type << peer << rate << packetSize << start << stop);
+    NS_ABORT_MSG_IF(type == UDP && packetSize < 12, "UDP packets carry a 12 bytes SeqTsHeader");
+    Flow flow;
+    flow.type = type;
+    flow.peer = peer;
+    flow.rate = rate;
+    flow.packetSize = packetSize;
+    flow.start = start;
+    flow.stop = stop;
+    m_flows.push_back(flow);
+    m_due.push_back(NO_TICK);
+    return m_flows.size() - 1;
+}
+
+void
+TrafficEngine::ChangeDataRate(uint32_t flowId, DataRate rate)
+{
+    NS_LOG_FUNCTION(this << flowId << rate);
+    m_flows.at(flowId).rate = rate;
+}
+
+uint64_t
+TrafficEngine::GetWakeUps() const
+{
+    return m_wakeUps;
+}
+
+Time
+TrafficEngine::GetLastStop() const
+{
+    Time last;
+    for (const auto& flow : m_flows)
+    {
+        last = std::max(last, flow.stop);
+    }
+    return last;
+}
+
+void
+TrafficEngine::OpenSocket(Flow& flow)
+{
+    TypeId factory = flow.type == TCP ? TcpSocketFactory::GetTypeId() : UdpSocketFactory::GetTypeId();
+    flow.socket = Socket::CreateSocket(GetNode(), factory);
+    flow.socket->Bind();
+    int result = flow.socket->Connect(flow.peer);
+    std::clog << "TrafficEngine Connect Result " << result << std::endl;
+
+    uint32_t payload = flow.type == UDP ? flow.packetSize - 12 : flow.packetSize;
+    flow.payload = Create<Packet>(payload);
+}
+
+void
+TrafficEngine::StartApplication()
+{
+    NS_LOG_FUNCTION(this);
+    m_now = Simulator::Now().GetTimeStep() / m_tick.GetTimeStep();
+
+    // TCP sockets are created now and in order, so socket i of the node is the i-th TCP flow
+    for (uint32_t id = 0; id < m_flows.size(); ++id)
+    {
+        if (m_flows[id].type == TCP)
+        {
+            OpenSocket(m_flows[id]);
+        }
+        uint64_t startTick = static_cast<uint64_t>(std::ceil(static_cast<double>(m_flows[id].start.GetTimeStep()) / m_tick.GetTimeStep()));
+        Insert(id, std::max(startTick, m_now + 1));
+    }
+    ScheduleNext();
+}
+
+void
+TrafficEngine::StopApplication()
+{
+    NS_LOG_FUNCTION(this);
+    m_event.Cancel();
+    for (auto& flow : m_flows)
+    {
+        if (flow.socket)
+        {
+            flow.socket->Close();
+        }
+    }
+}
+
+void
+TrafficEngine::Insert(uint32_t flowId, uint64_t tick)
+{
+    NS_ASSERT(tick > m_now);
+    m_due[flowId] = tick;
+    m_pending++;
+
+    uint64_t distance = tick - m_now;
+    if (distance < WHEEL_SLOTS)
+    {
+        m_level0[tick % WHEEL_SLOTS].push_back(flowId);
+    }
+    else if (distance < (WHEEL_SLOTS - 1) * WHEEL_SLOTS)
+    {
+        m_level1[(tick / WHEEL_SLOTS) % WHEEL_SLOTS].push_back(flowId);
+    }
+    else
+    {
+        m_overflow.emplace_back(tick, flowId);
+    }
+}
+
+void
+TrafficEngine::Cascade()
+{
+    uint64_t turn = m_now / WHEEL_SLOTS;
+    std::vector<uint32_t> moving;
+    moving.swap(m_level1[turn % WHEEL_SLOTS]);
+    for (uint32_t id : moving)
+    {
+        m_pending--;
+        if (m_due[id] == m_now)
+        {
+            // Due right now, Tick() serves m_level0[m_now] after the cascade
+            m_pending++;
+            m_level0[m_now % WHEEL_SLOTS].push_back(id);
+        }
+        else
+        {
+            Insert(id, m_due[id]);
+        }
+    }
+
+    auto it = m_overflow.begin();
+    while (it != m_overflow.end())
+    {
+        if (it->first - m_now < (WHEEL_SLOTS - 1) * WHEEL_SLOTS)
+        {
+            uint32_t id = it->second;
+            uint64_t tick = it->first;
+            it = m_overflow.erase(it);
+            m_pending--;
+            if (tick == m_now)
+            {
+                m_pending++;
+                m_level0[m_now % WHEEL_SLOTS].push_back(id);
+            }
+            else
+            {
+                Insert(id, tick);
+            }
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void
+TrafficEngine::ScheduleNext()
+{
+    if (m_pending == 0)
+    {
+        return;
+    }
+
+    // Next tick with flows in this level 0 turn, else the start of the next turn (cascade)
+    uint64_t next = (m_now / WHEEL_SLOTS + 1) * WHEEL_SLOTS;
+    for (uint64_t t = m_now + 1; t < next; ++t)
+    {
+        if (!m_level0[t % WHEEL_SLOTS].empty())
+        {
+            next = t;
+            break;
+        }
+    }
+
+    Time at = TimeStep(next * m_tick.GetTimeStep());
+    m_event = Simulator::Schedule(at - Simulator::Now(), &TrafficEngine::Tick, this, next);
+}
+
+void
+TrafficEngine::Tick(uint64_t tick)
+{
+    m_now = tick;
+    m_wakeUps++;
+    if (m_now % WHEEL_SLOTS == 0)
+    {
+        Cascade();
+    }
+
+    std::vector<uint32_t> due;
+    due.swap(m_level0[m_now % WHEEL_SLOTS]);
+    for (uint32_t id : due)
+    {
+        m_pending--;
+        uint64_t next = Serve(id);
+        m_due[id] = NO_TICK;
+        if (next != NO_TICK)
+        {
+            Insert(id, next);
+        }
+    }
+    ScheduleNext();
+}
+
+uint64_t
+TrafficEngine::Serve(uint32_t flowId)
+{
+    Flow& flow = m_flows[flowId];
+    Time now = Simulator::Now();
+
+    if (now >= flow.stop)
+    {
+        NS_LOG_DEBUG("Flow " << flowId << " stopped");
+        if (flow.socket)
+        {
+            flow.socket->Close();
+        }
+        flow.active = false;
+        return NO_TICK;
+    }
+
+    if (!flow.active)
+    {
+        if (!flow.socket)
+        {
+            OpenSocket(flow);
+        }
+        flow.active = true;
+        flow.lastService = now;
+        flow.credit = flow.packetSize; // first packet right away
+    }
+
+    double bytesPerSec = static_cast<double>(flow.rate.GetBitRate()) / 8;
+    flow.credit += bytesPerSec * (now - flow.lastService).GetSeconds();
+    flow.lastService = now;
+    // Do not let a full TCP buffer become a huge burst later, two ticks of credit at most
+    flow.credit = std::min(flow.credit, std::max<double>(flow.packetSize, 2 * bytesPerSec * m_tick.GetSeconds()));
+
+    uint32_t fits = flow.type == TCP ? flow.socket->GetTxAvailable() / flow.packetSize
+                                     : std::numeric_limits<uint32_t>::max();
+    while (flow.credit >= flow.packetSize && fits > 0)
+    {
+        Ptr<Packet> p = flow.payload->Copy();
+        if (flow.type == UDP)
+        {
+            SeqTsHeader seqTs;
+            seqTs.SetSeq(flow.seq++);
+            p->AddHeader(seqTs);
+        }
+        if (flow.socket->Send(p) < 0)
+        {
+            break;
+        }
+        flow.credit -= flow.packetSize;
+        fits--;
+    }
+
+    // Next service when the next packet is owed (at least the next tick)
+    uint64_t ticks = 1;
+    if (bytesPerSec <= 0)
+    {
+        ticks = WHEEL_SLOTS; // paused, check again for a ChangeDataRate
+    }
+    else if (flow.credit < flow.packetSize)
+    {
+        double wait = (flow.packetSize - flow.credit) / bytesPerSec;
+        ticks = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(wait / m_tick.GetSeconds())));
+    }
+    uint64_t stopTick = static_cast<uint64_t>(std::ceil(static_cast<double>(flow.stop.GetTimeStep()) / m_tick.GetTimeStep()));
+    return std::max(m_now + 1, std::min(m_now + ticks, stopTick));
+}
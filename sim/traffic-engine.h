@@ -0,0 +1,124 @@
+#ifndef TRAFFIC_ENGINE_H
+#define TRAFFIC_ENGINE_H
+
+#include "ns3/core-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <array>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Application that sends the traffic of many flows (TCP or UDP, each one with its own rate, packet
+ * size and start/stop time) from a single timer, instead of one MyApp (socket + send timer) per flow.
+ *
+ * Flows are kept in a two level timer wheel: level 0 has one slot per tick, level 1 one slot per
+ * level 0 turn, farther flows wait in an overflow list. The engine wakes once per tick with flows due
+ * (empty ticks are skipped) and every due flow writes what its rate allows since its last service:
+ * the fraction of a packet is carried to the next one, so the long run rate is exact.
+ *
+ * TCP flows are limited by the socket GetTxAvailable(), UDP packets carry a SeqTsHeader like
+ * UdpClient's so the UdpServer can compute losses and delays.
+ */
+class TrafficEngine : public Application
+{
+public:
+    enum FlowType
+    {
+        TCP,
+        UDP
+    };
+
+    static TypeId GetTypeId();
+    TrafficEngine();
+    ~TrafficEngine() override;
+
+    /**
+     * @brief Adds a flow, must be called before the application starts
+     * @return Id of the flow
+     */
+    uint32_t AddFlow(FlowType type,
+                     Address peer,
+                     DataRate rate,
+                     uint32_t packetSize,
+                     Time start,
+                     Time stop);
+
+    /**
+     * @brief Changes the rate of a flow, like MyApp::ChangeDataRate
+     */
+    void ChangeDataRate(uint32_t flowId, DataRate rate);
+
+    /**
+     * @return Number of engine wake ups (timer events)
+     */
+    uint64_t GetWakeUps() const;
+
+    /**
+     * @return Stop time of the flow that stops last, 0 without flows
+     */
+    Time GetLastStop() const;
+
+private:
+    void StartApplication() override;
+    void StopApplication() override;
+
+    struct Flow
+    {
+        FlowType type;
+        Address peer;
+        DataRate rate;
+        uint32_t packetSize;
+        Time start;
+        Time stop;
+        Ptr<Socket> socket;
+        Ptr<Packet> payload;    //!< Shared by every packet of the flow
+        Time lastService;
+        double credit{0};       //!< Bytes allowed and not sent yet
+        uint32_t seq{0};        //!< UDP SeqTsHeader sequence
+        bool active{false};
+    };
+
+    static constexpr uint32_t WHEEL_SLOTS = 256;
+
+    /**
+     * @brief Puts a flow in the wheel at an absolute tick
+     */
+    void Insert(uint32_t flowId, uint64_t tick);
+
+    /**
+     * @brief Moves the flows of the level 1 slot (and overflow) that belong to the new level 0 turn
+     */
+    void Cascade();
+
+    /**
+     * @brief Schedules the wake up at the next tick with flows due
+     */
+    void ScheduleNext();
+
+    void Tick(uint64_t tick);
+
+    /**
+     * @brief Sends what the flow is owed and returns the tick it has to be served again
+     */
+    uint64_t Serve(uint32_t flowId);
+
+    void OpenSocket(Flow& flow);
+
+    Time m_tick;                //!< Granularity of the wheel
+    uint64_t m_now;             //!< Current tick
+    uint64_t m_pending;         //!< Flows in the wheel
+    EventId m_event;
+    uint64_t m_wakeUps;
+
+    std::vector<Flow> m_flows;
+    std::array<std::vector<uint32_t>, WHEEL_SLOTS> m_level0;
+    std::array<std::vector<uint32_t>, WHEEL_SLOTS> m_level1;
+    std::vector<std::pair<uint64_t, uint32_t>> m_overflow;   //!< (tick, flow)
+    std::vector<uint64_t> m_due;                             //!< Tick of every flow in the wheel
+};
+
+#endif // TRAFFIC_ENGINE_H
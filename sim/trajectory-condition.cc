@@ -0,0 +1,243 @@
+#include "ns3/core-module.h"
+#include "ns3/buildings-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/network-module.h"
+#include "ns3/nr-module.h"
+#include "ns3/propagation-module.h"
+
+#include "trajectory-condition.h"
+#include "obstacle-grid.h"
+
+#include <cmath>
+#include <fstream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("TrajectoryChannelConditionModel");
+
+NS_OBJECT_ENSURE_REGISTERED(TrajectoryChannelConditionModel);
+
+TypeId
+TrajectoryChannelConditionModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::TrajectoryChannelConditionModel")
+            .SetParent<ChannelConditionModel>()
+            .SetGroupName("MyAppComp")
+            .AddConstructor<TrajectoryChannelConditionModel>()
+            .AddAttribute("Resolution",
+                          "Distance (m) between the samples of a trajectory",
+                          DoubleValue(0.1),
+                          MakeDoubleAccessor(&TrajectoryChannelConditionModel::m_resolution),
+                          MakeDoubleChecker<double>(1e-3));
+    return tid;
+}
+
+TrajectoryChannelConditionModel::TrajectoryChannelConditionModel()
+    : m_resolution(0.1),
+      m_hits(0),
+      m_misses(0)
+{
+}
+
+TrajectoryChannelConditionModel::~TrajectoryChannelConditionModel()
+{
+    NS_LOG_INFO("Condition table hits: " << m_hits << " computed: " << m_misses);
+}
+
+Ptr<Building>
+TrajectoryChannelConditionModel::BuildingAt(const Vector& pos)
+{
+    Ptr<ObstacleGrid> grid = ObstacleGrid::Get();
+    if (grid)
+    {
+        return grid->FindBuilding(pos);
+    }
+    for (BuildingList::Iterator it = BuildingList::Begin(); it != BuildingList::End(); ++it)
+    {
+        if ((*it)->IsInside(pos))
+        {
+            return *it;
+        }
+    }
+    return nullptr;
+}
+
+TrajectoryChannelConditionModel::Sample
+TrajectoryChannelConditionModel::Compute(const Vector& a, const Vector& b) const
+{
+    Ptr<Building> aBuilding = BuildingAt(a);
+    Ptr<Building> bBuilding = BuildingAt(b);
+
+    Sample sample;
+    if (aBuilding && bBuilding)
+    {
+        sample.o2i = ChannelCondition::I2I;
+        sample.los = aBuilding == bBuilding ? ChannelCondition::LOS : ChannelCondition::NLOS;
+        return sample;
+    }
+    if (aBuilding || bBuilding)
+    {
+        sample.o2i = ChannelCondition::O2I;
+        sample.los = ChannelCondition::NLOS;
+        return sample;
+    }
+
+    // Both outdoor: LoS unless a building crosses the direct path
+    bool blocked = false;
+    Ptr<ObstacleGrid> grid = ObstacleGrid::Get();
+    if (grid)
+    {
+        grid->ForEachIntersected(a, b, [&blocked](Ptr<Building>) { blocked = true; });
+    }
+    else
+    {
+        for (BuildingList::Iterator it = BuildingList::Begin(); it != BuildingList::End() && !blocked; ++it)
+        {
+            blocked = (*it)->IsIntersect(a, b);
+        }
+    }
+    sample.o2i = ChannelCondition::O2O;
+    sample.los = blocked ? ChannelCondition::NLOS : ChannelCondition::LOS;
+    return sample;
+}
+
+void
+TrajectoryChannelConditionModel::Build(NodeContainer ueNodes, NodeContainer gnbNodes, Time duration)
+{
+    uint64_t total = 0;
+    for (auto ue = ueNodes.Begin(); ue != ueNodes.End(); ++ue)
+    {
+        Ptr<MobilityModel> ueMob = (*ue)->GetObject<MobilityModel>();
+        NS_ABORT_MSG_IF(!ueMob, "UE without mobility model");
+        Vector velocity = ueMob->GetVelocity();
+        double speed = velocity.GetLength();
+
+        Profile base;
+        base.start = ueMob->GetPosition();
+        base.direction = speed > 0 ? Vector(velocity.x / speed, velocity.y / speed, velocity.z / speed)
+                                   : Vector(0, 0, 0);
+        base.length = speed * duration.GetSeconds();
+        size_t n = static_cast<size_t>(base.length / m_resolution) + 1;
+
+        for (auto gnb = gnbNodes.Begin(); gnb != gnbNodes.End(); ++gnb)
+        {
+            Vector gnbPos = (*gnb)->GetObject<MobilityModel>()->GetPosition();
+            Profile profile = base;
+            profile.samples.reserve(n);
+            for (size_t i = 0; i < n; i++)
+            {
+                double d = i * m_resolution;
+                Vector pos(base.start.x + base.direction.x * d,
+                           base.start.y + base.direction.y * d,
+                           base.start.z + base.direction.z * d);
+                profile.samples.push_back(Compute(pos, gnbPos));
+            }
+            total += n;
+            m_profiles[std::make_pair((*ue)->GetId(), (*gnb)->GetId())] = std::move(profile);
+        }
+    }
+    NS_LOG_INFO("Condition table: " << m_profiles.size() << " links, " << total << " samples");
+}
+
+TrajectoryChannelConditionModel::Sample
+TrajectoryChannelConditionModel::GetSample(Ptr<const MobilityModel> a, Ptr<const MobilityModel> b) const
+{
+    uint32_t aId = a->GetObject<Node>()->GetId();
+    uint32_t bId = b->GetObject<Node>()->GetId();
+
+    auto it = m_profiles.find(std::make_pair(aId, bId));
+    Ptr<const MobilityModel> ue = a;
+    if (it == m_profiles.end())
+    {
+        it = m_profiles.find(std::make_pair(bId, aId));
+        ue = b;
+    }
+
+    if (it != m_profiles.end())
+    {
+        const Profile& profile = it->second;
+        Vector pos = ue->GetPosition();
+        Vector offset = pos - profile.start;
+        double along = offset.x * profile.direction.x + offset.y * profile.direction.y +
+                       offset.z * profile.direction.z;
+        int64_t index = std::llround(along / m_resolution);
+        if (index >= 0 && static_cast<size_t>(index) < profile.samples.size())
+        {
+            double d = index * m_resolution;
+            Vector sampled(profile.start.x + profile.direction.x * d,
+                           profile.start.y + profile.direction.y * d,
+                           profile.start.z + profile.direction.z * d);
+            if (CalculateDistance(sampled, pos) <= m_resolution)
+            {
+                m_hits++;
+                return profile.samples[index];
+            }
+        }
+    }
+
+    m_misses++;
+    return Compute(a->GetPosition(), b->GetPosition());
+}
+
+Ptr<ChannelCondition>
+TrajectoryChannelConditionModel::GetChannelCondition(Ptr<const MobilityModel> a,
+                                                     Ptr<const MobilityModel> b) const
+{
+    Sample sample = GetSample(a, b);
+    Ptr<ChannelCondition> condition = CreateObject<ChannelCondition>();
+    condition->SetLosCondition(sample.los);
+    condition->SetO2iCondition(sample.o2i);
+    return condition;
+}
+
+std::pair<uint64_t, uint64_t>
+TrajectoryChannelConditionModel::GetStats() const
+{
+    return {m_hits, m_misses};
+}
+
+int64_t
+TrajectoryChannelConditionModel::AssignStreams(int64_t stream [[maybe_unused]])
+{
+    return 0;
+}
+
+void
+TrajectoryChannelConditionModel::WriteProfile(std::string filename) const
+{
+    std::ofstream out(filename);
+    out << "UE\tgNB\tDistance (m)\tLoS\tO2I" << std::endl;
+    for (const auto& link : m_profiles)
+    {
+        for (size_t i = 0; i < link.second.samples.size(); i++)
+        {
+            const Sample& s = link.second.samples[i];
+            out << link.first.first << "\t" << link.first.second << "\t" << i * m_resolution << "\t"
+                << (s.los == ChannelCondition::LOS) << "\t" << s.o2i << std::endl;
+        }
+    }
+}
+
+void
+TrajectoryChannelConditionModel::InstallInBwps(const BandwidthPartInfoPtrVector& bwps)
+{
+    for (const auto& bwp : bwps)
+    {
+        if (bwp.get()->m_propagation)
+        {
+            // The hybrid buildings path loss (hybridPathloss) has no condition model, it finds the
+            // walls itself
+            bwp.get()->m_propagation->SetAttributeFailSafe("ChannelConditionModel", PointerValue(this));
+        }
+
+        Ptr<ThreeGppSpectrumPropagationLossModel> spectrumLoss =
+            DynamicCast<ThreeGppSpectrumPropagationLossModel>(bwp.get()->m_3gppChannel);
+        if (spectrumLoss)
+        {
+            PointerValue channelModel;
+            spectrumLoss->GetAttribute("ChannelModel", channelModel);
+            channelModel.Get<Object>()->SetAttribute("ChannelConditionModel", PointerValue(this));
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef TRAJECTORY_CONDITION_H
+#define TRAJECTORY_CONDITION_H
+
+#include "ns3/core-module.h"
+#include "ns3/buildings-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/network-module.h"
+#include "ns3/nr-module.h"
+#include "ns3/propagation-module.h"
+
+#include <map>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Channel condition model that answers from a table computed before the run. The UEs of the
+ * scenarios are static or move in a straight line (ConstantVelocityMobilityModel) among static
+ * buildings and trees, so Build() samples the trajectory of every UE each Resolution meters and
+ * stores, for every gNB, the condition (LoS/NLoS, O2O/O2I/I2I), which is all the channel and path
+ * loss models ask for (they compute the O2I penetration loss themselves). During the run a condition
+ * is the one of the sample closest to the UE; positions out of the trajectory (or links not in the
+ * table) are computed with the same geometry.
+ *
+ * The geometry is the one of BuildingsChannelConditionModel: LoS when no building intersects the
+ * segment between the nodes, O2I when only one of them is inside a building. The buildings are
+ * looked up in the ObstacleGrid when it was built. Without Build() the model only computes the
+ * geometry, as a BuildingsChannelConditionModel with the grid.
+ */
+class TrajectoryChannelConditionModel : public ChannelConditionModel
+{
+public:
+    /** Condition of a link at a point of the trajectory */
+    struct Sample
+    {
+        ChannelCondition::LosConditionValue los;
+        ChannelCondition::O2iConditionValue o2i;
+    };
+
+    static TypeId GetTypeId();
+    TrajectoryChannelConditionModel();
+    ~TrajectoryChannelConditionModel() override;
+
+    /**
+     * @brief Samples the trajectory of every UE from now until duration
+     */
+    void Build(NodeContainer ueNodes, NodeContainer gnbNodes, Time duration);
+
+    Ptr<ChannelCondition> GetChannelCondition(Ptr<const MobilityModel> a,
+                                              Ptr<const MobilityModel> b) const override;
+
+    int64_t AssignStreams(int64_t stream) override;
+
+    /**
+     * @brief Sample of the link at the current position of its nodes
+     */
+    Sample GetSample(Ptr<const MobilityModel> a, Ptr<const MobilityModel> b) const;
+
+    /**
+     * @brief Writes the table (one line per UE, gNB and sample) to plot the profile
+     */
+    void WriteProfile(std::string filename) const;
+
+    /**
+     * @brief Uses this model as the channel condition model of the propagation loss and channel
+     * models of every BWP (the propagation loss model keeps its own if it has none, as the hybrid
+     * buildings one)
+     */
+    void InstallInBwps(const BandwidthPartInfoPtrVector& bwps);
+
+    /**
+     * @return Conditions answered from the table and computed from the geometry
+     */
+    std::pair<uint64_t, uint64_t> GetStats() const;
+
+private:
+    /** Trajectory of a UE towards a gNB */
+    struct Profile
+    {
+        Vector start;
+        Vector direction;       //!< Unit vector, zero if the UE is static
+        double length;          //!< Meters covered until the end of the simulation
+        std::vector<Sample> samples;
+    };
+
+    /**
+     * @brief Condition between two positions from the buildings geometry
+     */
+    Sample Compute(const Vector& a, const Vector& b) const;
+
+    /**
+     * @return Building that contains the position, nullptr if outdoor
+     */
+    static Ptr<Building> BuildingAt(const Vector& pos);
+
+    double m_resolution;    //!< Attribute Resolution (m)
+    std::map<std::pair<uint32_t, uint32_t>, Profile> m_profiles;  //!< Key: (UE node, gNB node)
+    mutable uint64_t m_hits;
+    mutable uint64_t m_misses;
+};
+
+#endif // TRAJECTORY_CONDITION_H
@@ -0,0 +1,151 @@
+#include "ns3/core-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/network-module.h"
+
+#include "udp-rx-aggregator.h"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("UdpRxAggregator");
+
+UdpRxAggregator::UdpRxAggregator(std::string filename, Time interval)
+    : m_interval(interval),
+      m_anyRx(false),
+      m_nextSeq(0),
+      m_bytes(0),
+      m_packets(0),
+      m_lost(0),
+      m_reordered(0)
+{
+    NS_ABORT_MSG_IF(!m_interval.IsStrictlyPositive(), "The aggregation interval must be positive");
+
+    m_out.open(filename, std::ofstream::out | std::ofstream::trunc);
+    if (!m_out.is_open())
+    {
+        NS_FATAL_ERROR("Can't open file " << filename);
+    }
+    m_out.setf(std::ios_base::fixed);
+    m_out << "Time (s)\tBytes\tPackets\tLost\tReordered\tDelayMin\tDelayMean\tDelayP95\tDelayMax\n";
+
+    m_event = Simulator::Schedule(m_interval, &UdpRxAggregator::Tick, this);
+}
+
+UdpRxAggregator::~UdpRxAggregator()
+{
+}
+
+void
+UdpRxAggregator::Connect(uint32_t nodeId)
+{
+    Config::ConnectWithoutContext("/NodeList/" + std::to_string(nodeId)
+                                    + "/ApplicationList/0/$ns3::UdpServer/RxWithAddresses",
+                                  MakeCallback(&UdpRxAggregator::Receive, Ptr<UdpRxAggregator>(this)));
+}
+
+void
+UdpRxAggregator::Receive(Ptr<const Packet> p, const Address& srcAdd [[maybe_unused]], const Address& destAdd [[maybe_unused]])
+{
+    SeqTsHeader seqTs;
+    p->PeekHeader(seqTs);
+    uint32_t seq = seqTs.GetSeq();
+
+    m_bytes += p->GetSize();
+    m_packets++;
+    m_delays.push_back((Simulator::Now() - seqTs.GetTs()).GetSeconds());
+
+    if (!m_anyRx || seq >= m_nextSeq)
+    {
+        uint32_t from = m_anyRx ? m_nextSeq : 0;
+        if (seq > from)
+        {
+            m_lost += seq - from;
+            m_gaps.emplace(from, seq);
+        }
+        m_anyRx = true;
+        m_nextSeq = seq + 1;
+
+        // A packet this late is not waited for any more, its gap stays lost
+        while (!m_gaps.empty() && m_nextSeq - m_gaps.begin()->second > MAX_REORDER)
+        {
+            m_gaps.erase(m_gaps.begin());
+        }
+        return;
+    }
+
+    // Late packet: only one of a gap was counted as lost (a duplicate or a packet of a forgotten gap
+    // is neither lost nor reordered)
+    auto gap = m_gaps.upper_bound(seq);
+    if (gap == m_gaps.begin() || (--gap)->second <= seq)
+    {
+        return;
+    }
+    m_reordered++;
+    m_lost--;
+    uint32_t gapEnd = gap->second;
+    if (gap->first < seq)
+    {
+        gap->second = seq;
+    }
+    else
+    {
+        m_gaps.erase(gap);
+    }
+    if (seq + 1 < gapEnd)
+    {
+        m_gaps.emplace(seq + 1, gapEnd);
+    }
+}
+
+void
+UdpRxAggregator::Tick()
+{
+    WriteInterval();
+    m_event = Simulator::Schedule(m_interval, &UdpRxAggregator::Tick, this);
+}
+
+void
+UdpRxAggregator::WriteInterval()
+{
+    double dMin = 0;
+    double dMean = 0;
+    double dP95 = 0;
+    double dMax = 0;
+    if (!m_delays.empty())
+    {
+        auto [minIt, maxIt] = std::minmax_element(m_delays.begin(), m_delays.end());
+        dMin = *minIt;
+        dMax = *maxIt;
+        dMean = std::accumulate(m_delays.begin(), m_delays.end(), 0.0) / m_delays.size();
+        auto p95 = m_delays.begin() + (m_delays.size() - 1) * 95 / 100;
+        std::nth_element(m_delays.begin(), p95, m_delays.end());
+        dP95 = *p95;
+    }
+
+    m_out << Simulator::Now().GetSeconds() << "\t" << m_bytes << "\t" << m_packets << "\t" << m_lost
+          << "\t" << m_reordered << "\t" << dMin << "\t" << dMean << "\t" << dP95 << "\t" << dMax
+          << "\n";
+
+    m_bytes = 0;
+    m_packets = 0;
+    m_lost = 0;
+    m_reordered = 0;
+    m_delays.clear();
+}
+
+void
+UdpRxAggregator::Finish()
+{
+    if (!m_out.is_open())
+    {
+        return;
+    }
+    m_event.Cancel();
+    if (m_packets > 0)
+    {
+        WriteInterval();
+    }
+    m_out.close();
+}
@@ -0,0 +1,80 @@
+#ifndef UDP_RX_AGGREGATOR_H
+#define UDP_RX_AGGREGATOR_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <fstream>
+#include <map>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Per interval statistics of the packets received by a UdpServer, kept in memory instead of
+ * writing a line per packet (UdpRecv_NodeN.txt). Every interval one row is written with:
+ *
+ *  Time(s) Bytes Packets Lost Reordered DelayMin DelayMean DelayP95 DelayMax
+ *
+ * Lost is computed from the gaps in the SeqTsHeader sequence. A late packet (lower sequence than
+ * the highest received) that fills a gap is counted as reordered and removed from the loss of the
+ * interval it arrives in; duplicates and packets more than MAX_REORDER sequences late change
+ * neither. Delays are in seconds.
+ */
+class UdpRxAggregator : public SimpleRefCount<UdpRxAggregator>
+{
+public:
+    /**
+     * @param filename Output file
+     * @param interval Length of every row
+     */
+    UdpRxAggregator(std::string filename, Time interval);
+    ~UdpRxAggregator();
+
+    /**
+     * @brief Connects the aggregator to the RxWithAddresses trace of the first UdpServer of the node
+     */
+    void Connect(uint32_t nodeId);
+
+    /**
+     * @brief Accounts a packet that still carries its SeqTsHeader
+     */
+    void Receive(Ptr<const Packet> p, const Address& srcAdd, const Address& destAdd);
+
+    /**
+     * @brief Writes the last (partial) interval and closes the file, call it before
+     * Simulator::Destroy()
+     */
+    void Finish();
+
+private:
+    /**
+     * @brief Writes the current row and schedules the next one
+     */
+    void Tick();
+
+    /**
+     * @brief Writes the current row and resets the counters
+     */
+    void WriteInterval();
+
+    std::ofstream m_out;
+    Time m_interval;
+    EventId m_event;
+
+    /** Sequences behind the highest received after which a gap is no longer waited for */
+    static constexpr uint32_t MAX_REORDER = 1 << 16;
+
+    bool m_anyRx;               //!< Whether a packet was received, to initialise m_nextSeq
+    uint32_t m_nextSeq;         //!< Highest sequence received + 1
+    std::map<uint32_t, uint32_t> m_gaps;    //!< Sequences counted as lost, [first, second)
+
+    // Counters of the current interval
+    uint64_t m_bytes;
+    uint32_t m_packets;
+    int64_t m_lost;
+    uint32_t m_reordered;
+    std::vector<double> m_delays;   //!< Delays of the interval, reused between intervals
+};
+
+#endif // UDP_RX_AGGREGATOR_H
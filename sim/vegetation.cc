@@ -0,0 +1,218 @@
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/propagation-module.h"
+
+#include "vegetation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("Vegetation");
+
+NS_OBJECT_ENSURE_REGISTERED(VegetationPropagationLossModel);
+
+std::vector<VegetationObstacle> VegetationList::s_obstacles;
+std::vector<uint32_t> VegetationList::s_byMinX;
+double VegetationList::s_maxRadius = 0;
+
+uint32_t
+VegetationList::Add(double x, double y, double radius, double zMin, double zMax)
+{
+    NS_ABORT_MSG_IF(radius <= 0 || zMax <= zMin, "Invalid vegetation obstacle");
+    s_obstacles.push_back({x, y, radius, zMin, zMax});
+    s_maxRadius = std::max(s_maxRadius, radius);
+    return s_obstacles.size() - 1;
+}
+
+uint32_t
+VegetationList::GetN()
+{
+    return s_obstacles.size();
+}
+
+const VegetationObstacle&
+VegetationList::Get(uint32_t index)
+{
+    return s_obstacles.at(index);
+}
+
+void
+VegetationList::BuildIndex()
+{
+    if (s_byMinX.size() == s_obstacles.size())
+    {
+        return;
+    }
+    s_byMinX.resize(s_obstacles.size());
+    std::iota(s_byMinX.begin(), s_byMinX.end(), 0);
+    std::sort(s_byMinX.begin(), s_byMinX.end(), [](uint32_t a, uint32_t b) {
+        return s_obstacles[a].x - s_obstacles[a].radius < s_obstacles[b].x - s_obstacles[b].radius;
+    });
+}
+
+double
+VegetationList::IntersectionLength(const VegetationObstacle& tree, const Vector& a, const Vector& b)
+{
+    double dx = b.x - a.x;
+    double dy = b.y - a.y;
+    double dz = b.z - a.z;
+    double t0 = 0;
+    double t1 = 1;
+
+    // Circle of the crown in the xy plane
+    double ox = a.x - tree.x;
+    double oy = a.y - tree.y;
+    double qa = dx * dx + dy * dy;
+    double qc = ox * ox + oy * oy - tree.radius * tree.radius;
+    if (qa == 0)
+    {
+        if (qc > 0)
+        {
+            return 0;
+        }
+    }
+    else
+    {
+        double qb = 2 * (dx * ox + dy * oy);
+        double disc = qb * qb - 4 * qa * qc;
+        if (disc <= 0)
+        {
+            return 0;
+        }
+        double root = std::sqrt(disc);
+        t0 = std::max(t0, (-qb - root) / (2 * qa));
+        t1 = std::min(t1, (-qb + root) / (2 * qa));
+    }
+
+    // Height of the crown
+    if (dz == 0)
+    {
+        if (a.z < tree.zMin || a.z > tree.zMax)
+        {
+            return 0;
+        }
+    }
+    else
+    {
+        double zt0 = (tree.zMin - a.z) / dz;
+        double zt1 = (tree.zMax - a.z) / dz;
+        t0 = std::max(t0, std::min(zt0, zt1));
+        t1 = std::min(t1, std::max(zt0, zt1));
+    }
+
+    if (t1 <= t0)
+    {
+        return 0;
+    }
+    return (t1 - t0) * std::sqrt(qa + dz * dz);
+}
+
+double
+VegetationList::GetFoliageDepth(const Vector& a, const Vector& b)
+{
+    if (s_obstacles.empty())
+    {
+        return 0;
+    }
+    BuildIndex();
+
+    double xLo = std::min(a.x, b.x);
+    double xHi = std::max(a.x, b.x);
+    double yLo = std::min(a.y, b.y);
+    double yHi = std::max(a.y, b.y);
+
+    // An obstacle overlaps [xLo, xHi] only if its minimum x is in [xLo - 2 * maxRadius, xHi]
+    auto first = std::lower_bound(s_byMinX.begin(), s_byMinX.end(), xLo - 2 * s_maxRadius,
+                                  [](uint32_t i, double x) { return s_obstacles[i].x - s_obstacles[i].radius < x; });
+    double depth = 0;
+    for (auto it = first; it != s_byMinX.end() && s_obstacles[*it].x - s_obstacles[*it].radius <= xHi; ++it)
+    {
+        const VegetationObstacle& tree = s_obstacles[*it];
+        if (tree.x + tree.radius < xLo || tree.y + tree.radius < yLo || tree.y - tree.radius > yHi)
+        {
+            continue;
+        }
+        depth += IntersectionLength(tree, a, b);
+    }
+    return depth;
+}
+
+/* ------------------------------------------------------------------------------------------------- */
+
+TypeId
+VegetationPropagationLossModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::VegetationPropagationLossModel")
+            .SetParent<PropagationLossModel>()
+            .SetGroupName("MyAppComp")
+            .AddConstructor<VegetationPropagationLossModel>()
+            .AddAttribute("Frequency",
+                          "Carrier frequency (Hz)",
+                          DoubleValue(28e9),
+                          MakeDoubleAccessor(&VegetationPropagationLossModel::m_frequency),
+                          MakeDoubleChecker<double>(1e6))
+            .AddAttribute("SpecificAttenuation",
+                          "Attenuation per meter of foliage (dB/m), 0: 0.2 * f(MHz)^0.3 (in leaf)",
+                          DoubleValue(0),
+                          MakeDoubleAccessor(&VegetationPropagationLossModel::m_gamma),
+                          MakeDoubleChecker<double>(0.0))
+            .AddAttribute("MaxAttenuation",
+                          "Maximum attenuation of the vegetation (dB), 0: 0.18 * f(MHz)^0.752",
+                          DoubleValue(0),
+                          MakeDoubleAccessor(&VegetationPropagationLossModel::m_maxAtt),
+                          MakeDoubleChecker<double>(0.0));
+    return tid;
+}
+
+VegetationPropagationLossModel::VegetationPropagationLossModel()
+    : m_frequency(28e9),
+      m_gamma(0),
+      m_maxAtt(0)
+{
+}
+
+VegetationPropagationLossModel::~VegetationPropagationLossModel()
+{
+}
+
+double
+VegetationPropagationLossModel::GetSpecificAttenuation() const
+{
+    return m_gamma > 0 ? m_gamma : 0.2 * std::pow(m_frequency / 1e6, 0.3);
+}
+
+double
+VegetationPropagationLossModel::GetMaxAttenuation() const
+{
+    return m_maxAtt > 0 ? m_maxAtt : 0.18 * std::pow(m_frequency / 1e6, 0.752);
+}
+
+double
+VegetationPropagationLossModel::GetLoss(const Vector& a, const Vector& b) const
+{
+    double depth = VegetationList::GetFoliageDepth(a, b);
+    if (depth <= 0)
+    {
+        return 0;
+    }
+    double am = GetMaxAttenuation();
+    return am * (1 - std::exp(-depth * GetSpecificAttenuation() / am));
+}
+
+double
+VegetationPropagationLossModel::DoCalcRxPower(double txPowerDbm,
+                                              Ptr<MobilityModel> a,
+                                              Ptr<MobilityModel> b) const
+{
+    return txPowerDbm - GetLoss(a->GetPosition(), b->GetPosition());
+}
+
+int64_t
+VegetationPropagationLossModel::DoAssignStreams(int64_t stream [[maybe_unused]])
+{
+    return 0;
+}
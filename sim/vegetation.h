@@ -0,0 +1,97 @@
+#ifndef VEGETATION_H
+#define VEGETATION_H
+
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/propagation-module.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Tree (or any vegetation) as a vertical cylinder of foliage. Unlike a Building it has no rooms
+ * and no walls: it does not change the indoor/outdoor state of the nodes nor the LoS condition, it
+ * only adds the attenuation of the foliage crossed by the direct path (VegetationPropagationLossModel).
+ */
+struct VegetationObstacle
+{
+    double x;           //!< Center of the trunk
+    double y;
+    double radius;      //!< Radius of the crown
+    double zMin;        //!< Bottom of the crown
+    double zMax;        //!< Top of the crown
+};
+
+/**
+ * Global list of the vegetation, as BuildingList for buildings. The obstacles keep the index they
+ * were added with; a separate index sorted by their minimum x lets a segment test only the ones whose
+ * x range overlaps its own.
+ */
+class VegetationList
+{
+public:
+    /**
+     * @brief Adds a cylinder of foliage
+     * @return Index of the obstacle
+     */
+    static uint32_t Add(double x, double y, double radius, double zMin, double zMax);
+
+    static uint32_t GetN();
+    static const VegetationObstacle& Get(uint32_t index);
+
+    /**
+     * @brief Builds the index by minimum x if obstacles were added since the last query. Queries do
+     * it on their own, call it before querying from several threads
+     */
+    static void BuildIndex();
+
+    /**
+     * @brief Meters of foliage crossed by the segment a-b (sum over every obstacle)
+     */
+    static double GetFoliageDepth(const Vector& a, const Vector& b);
+
+    /**
+     * @brief Length of the segment a-b inside a cylinder
+     */
+    static double IntersectionLength(const VegetationObstacle& tree, const Vector& a, const Vector& b);
+
+private:
+    static std::vector<VegetationObstacle> s_obstacles;   //!< In the order they were added
+    static std::vector<uint32_t> s_byMinX;                //!< Indices sorted by minimum x
+    static double s_maxRadius;
+};
+
+/**
+ * Excess loss of the vegetation between two nodes, ITU-R P.833 terrestrial path through woodland:
+ *
+ *   A = Am * (1 - exp(-d * gamma / Am))
+ *
+ * d is the foliage depth crossed by the direct path, gamma the specific attenuation (dB/m) and Am the
+ * maximum attenuation (dB). Chain it before the path loss model of the spectrum channel.
+ */
+class VegetationPropagationLossModel : public PropagationLossModel
+{
+public:
+    static TypeId GetTypeId();
+    VegetationPropagationLossModel();
+    ~VegetationPropagationLossModel() override;
+
+    /**
+     * @return Excess loss in dB between two positions
+     */
+    double GetLoss(const Vector& a, const Vector& b) const;
+
+private:
+    double DoCalcRxPower(double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const override;
+    int64_t DoAssignStreams(int64_t stream) override;
+
+    double GetSpecificAttenuation() const;
+    double GetMaxAttenuation() const;
+
+    double m_frequency;     //!< Attribute Frequency (Hz)
+    double m_gamma;         //!< Attribute SpecificAttenuation (dB/m), 0: from the frequency
+    double m_maxAtt;        //!< Attribute MaxAttenuation (dB), 0: from the frequency
+};
+
+#endif // VEGETATION_H